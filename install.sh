@@ -79,6 +79,48 @@ install_dependencies() {
     else
         print_success "All system dependencies are already satisfied."
     fi
+
+    # Optional: libjpeg-turbo enables the direct TurboJPEG encoder
+    declare -A turbo
+    turbo[apt]="libturbojpeg0-dev"
+    turbo[dnf]="turbojpeg-devel"
+    turbo[yum]="turbojpeg-devel"
+    turbo[pacman]="libjpeg-turbo"
+    turbo[brew]="jpeg-turbo"
+
+    if ! pkg-config --exists libturbojpeg; then
+        print_info "libturbojpeg not found, attempting to install (optional)..."
+        case "$PM" in
+            apt)    sudo apt-get install -y ${turbo[apt]} ;;
+            dnf)    sudo dnf install -y ${turbo[dnf]} ;;
+            yum)    sudo yum install -y ${turbo[yum]} ;;
+            pacman) sudo pacman -S --noconfirm ${turbo[pacman]} ;;
+            brew)   brew install ${turbo[brew]} ;;
+        esac || print_info "libturbojpeg unavailable; JPEG encoding will use OpenCV."
+    else
+        print_success "libturbojpeg found (fast JPEG encoder enabled)."
+    fi
+
+    # Optional: libwebp enables WebP method/lossless/threaded options
+    declare -A webp
+    webp[apt]="libwebp-dev"
+    webp[dnf]="libwebp-devel"
+    webp[yum]="libwebp-devel"
+    webp[pacman]="libwebp"
+    webp[brew]="webp"
+
+    if ! pkg-config --exists libwebp; then
+        print_info "libwebp not found, attempting to install (optional)..."
+        case "$PM" in
+            apt)    sudo apt-get install -y ${webp[apt]} ;;
+            dnf)    sudo dnf install -y ${webp[dnf]} ;;
+            yum)    sudo yum install -y ${webp[yum]} ;;
+            pacman) sudo pacman -S --noconfirm ${webp[pacman]} ;;
+            brew)   brew install ${webp[brew]} ;;
+        esac || print_info "libwebp unavailable; WebP encoding will use OpenCV."
+    else
+        print_success "libwebp found (tunable WebP encoder enabled)."
+    fi
 }
 
 # --- Main Logic ---
@@ -1,16 +1,80 @@
 /**
  * @file This bridge loads the native C++ addon and promisifies its functions.
+ *
+ * The addon is context-aware, so this module can be required from any
+ * worker_thread; all isolates share the engine's thread pool and caches.
+ * Image inputs (and raw `data` fields) may be Buffers, typed arrays,
+ * DataViews, ArrayBuffers or SharedArrayBuffers, all wrapped zero-copy.
+ * With outputFormat 'native' results are NativeImage handles that any
+ * export takes back as input without touching the pixels. An AbortSignal
+ * in options.signal cancels the job (through a native CancelToken).
  */
 const util = require('util');
 const addon = require('rosepetal-image-engine/build/Release/addon.node');
 
 const promisifiedAddon = {};
 
+// Synchronous exports (no callback) and the handle classes are passed through unchanged
+const SYNC_EXPORTS = new Set(['poolStats', 'configure', 'stats', 'NativeImage', 'CancelToken']);
+
+const isShared = (v) => typeof SharedArrayBuffer !== 'undefined' && v instanceof SharedArrayBuffer;
+const isNative = (v) => typeof addon.NativeImage === 'function' && v instanceof addon.NativeImage;
+
+// Node-API cannot read a bare SharedArrayBuffer, but it can read any view
+// on one: wrap it (no copy) in a Uint8Array, also inside image objects
+function viewShared(image) {
+  if (isNative(image)) return image;
+  if (isShared(image)) return new Uint8Array(image);
+  if (Array.isArray(image)) return image.some(hasShared) ? image.map(viewShared) : image;
+  if (image && typeof image === 'object' && isShared(image.data)) {
+    return { ...image, data: new Uint8Array(image.data) };
+  }
+  return image;
+}
+
+// Handles are skipped: reading their `data` would materialize the Buffer
+function hasShared(image) {
+  if (isNative(image)) return false;
+  return isShared(image) || (!!image && typeof image === 'object' && isShared(image.data)) ||
+         (Array.isArray(image) && image.some(hasShared));
+}
+
+const isSignal = (v) => !!v && typeof v === 'object' && typeof v.aborted === 'boolean' &&
+                        typeof v.addEventListener === 'function';
+const isOptions = (v) => !!v && typeof v === 'object' && !Array.isArray(v) &&
+                         !ArrayBuffer.isView(v) && !isNative(v) && isSignal(v.signal);
+
+// options.signal → options.cancel: a CancelToken cancelled on 'abort'.
+// Returns the listener cleanup, run once the job settles.
+function bindSignal(args) {
+  const i = args.findIndex(isOptions);
+  if (i < 0 || typeof addon.CancelToken !== 'function') return null;
+  const { signal, ...options } = args[i];
+  const token = new addon.CancelToken();
+  const onAbort = () => token.cancel();
+  args[i] = { ...options, cancel: token };
+  if (signal.aborted) {
+    token.cancel();
+    return null;
+  }
+  signal.addEventListener('abort', onAbort, { once: true });
+  return () => signal.removeEventListener('abort', onAbort);
+}
+
 // Promisify all functions exported from the C++ addon
 for (const key in addon) {
-  if (typeof addon[key] === 'function') {
-    promisifiedAddon[key] = util.promisify(addon[key]);
+  if (typeof addon[key] !== 'function') continue;
+  if (SYNC_EXPORTS.has(key)) {
+    promisifiedAddon[key] = addon[key];
+    continue;
   }
+  const call = util.promisify(addon[key]);
+  promisifiedAddon[key] = (...args) => {
+    args = args.map(a => (hasShared(a) ? viewShared(a) : a));
+    const release = bindSignal(args);
+    const job = call(...args);
+    return release ? job.finally(release) : job;
+  };
 }
 
 module.exports = promisifiedAddon;
\ No newline at end of file
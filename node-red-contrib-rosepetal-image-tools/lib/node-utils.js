@@ -5,6 +5,7 @@
  */
 
 const sharp = require('sharp'); // Ensure sharp is installed in your project
+const { NativeImage } = require('./cpp-bridge.js');
 
 
 module.exports = function(RED) {
@@ -16,12 +17,24 @@ module.exports = function(RED) {
     DEFAULT_ARRAY_POSITION: 0,
     SUPPORTED_DTYPES: ['uint8'],
     SUPPORTED_COLOR_SPACES: ['GRAY', 'RGB', 'RGBA', 'BGR', 'BGRA'],
-    CHANNEL_MAP: { 'GRAY': 1, 'RGB': 3, 'RGBA': 4, 'BGR': 3, 'BGRA': 4 }
+    CHANNEL_MAP: { 'GRAY': 1, 'RGB': 3, 'RGBA': 4, 'BGR': 3, 'BGRA': 4 },
+    LATENCY_WINDOW: 100,
+    DEBUG_PREVIEW_QUALITY: 80,
+    DROPPED_CODES: { ERR_DEADLINE: 'deadline', ERR_CANCELLED: 'cancelled', ERR_SUPERSEDED: 'superseded' }
   };
 
+  /**
+   * True for the engine's opaque image handles (outputFormat 'native')
+   */
+  utils.isNativeImage = function(image) {
+    return typeof NativeImage === 'function' && image instanceof NativeImage;
+  }
+
   /**
    * Validates and normalizes an image structure
    * Supports structure: {data, width, height, channels, colorSpace, dtype}
+   * NativeImage handles are returned as-is (validated by the engine, and
+   * reading their data here would materialize it)
    */
   utils.validateImageStructure = function(image, node) {
     if (!image) {
@@ -30,6 +43,9 @@ module.exports = function(RED) {
     }
 
     switch (true) {
+      case utils.isNativeImage(image):
+        return image;
+
       // New Rosepetal bitmap structure
       case (image.hasOwnProperty('width') &&
             image.hasOwnProperty('height') &&
@@ -125,6 +141,85 @@ module.exports = function(RED) {
     return true;
   }
 
+  /**
+   * Unpacks the { images, timings } result of a native *Batch call into the
+   * same [{ image, timing }] shape returned by the single-image bindings.
+   */
+  utils.batchToResults = function(batch) {
+    return batch.images.map((image, i) => ({
+      image,
+      timing: batch.timings[i],
+      preview: i === 0 ? batch.preview : undefined   // thumbnail of the first image only
+    }));
+  }
+
+  /**
+   * PNG mode of a node config. Flows saved before pngMode existed only
+   * carry the pngOptimize boolean and keep their behaviour (checked →
+   * balanced, unchecked → none); the editors pre-select the same mapping
+   * in oneditprepare so re-saving such a node does not change it.
+   */
+  utils.pngMode = function(config) {
+    return config.pngMode || (config.pngOptimize ? 'balanced' : 'none');
+  };
+
+  /**
+   * Encoder options passed to the native bindings where the old
+   * pngOptimize boolean went (pngMode from utils.pngMode).
+   * `msg.outBuffer` (a Buffer, or an array of Buffers for lists) is passed
+   * as the native `out` target: results are written into it instead of a
+   * freshly allocated Buffer, so a flow can recycle one buffer per frame.
+   * JPEG inputs of 64 MP and more are processed in row strips (resize,
+   * filter, crop); `msg.streaming` (true / false / 'auto') overrides that.
+   * With `node` given and debug on, the engine also returns a debug-width
+   * JPEG `preview` of the (first) result, see debugImageDisplay.
+   */
+  utils.encodeOptions = function(config, msg, node) {
+    const webpMethod = parseInt(config.webpMethod, 10);
+    const options = {
+      pngMode: utils.pngMode(config),
+      webpMethod: isNaN(webpMethod) ? -1 : webpMethod,
+      webpLossless: !!config.webpLossless,
+      streaming: 'auto'
+    };
+    if (msg && (Buffer.isBuffer(msg.outBuffer) || Array.isArray(msg.outBuffer))) {
+      options.out = msg.outBuffer;
+    }
+    if (msg && ['high', 'normal', 'low'].includes(msg.priority)) {
+      options.priority = msg.priority;
+    }
+    if (msg && (typeof msg.streaming === 'boolean' || msg.streaming === 'auto')) {
+      options.streaming = msg.streaming;
+    }
+    // Frames dropped by these come back as ERR_DEADLINE / ERR_SUPERSEDED
+    // (see handleNodeError)
+    if (msg && Number.isFinite(msg.deadlineMs)) {
+      options.deadlineMs = msg.deadlineMs;
+    }
+    if (node && config.latestFrameWins) {
+      options.latestKey = `${node.id}:${msg && msg.topic != null ? msg.topic : ''}`;
+    }
+    if (node && config.debugEnabled) {
+      try {
+        options.preview = {
+          width: utils.resolveDebugWidth(node, config, msg),
+          quality: CONSTANTS.DEBUG_PREVIEW_QUALITY
+        };
+      } catch (e) {
+        // Bad debug width: debugImageDisplay reports it after processing
+      }
+    }
+    return options;
+  }
+
+  /**
+   * Debug display width from config.debugWidth / debugWidthType (default 200)
+   */
+  utils.resolveDebugWidth = function(node, config, msg) {
+    const width = utils.resolveDimension(node, config.debugWidthType, config.debugWidth, msg);
+    return Math.max(1, parseInt(width) || 200);
+  }
+
   utils.resolveDimension = function(node, type, value, msg) {
     if (!value || String(value).trim() === '') return null;
     let resolvedValue;
@@ -170,6 +265,7 @@ module.exports = function(RED) {
   }
 
   utils.rawToJpeg = async function (image, quality = CONSTANTS.DEFAULT_JPEG_QUALITY) {
+    if (utils.isNativeImage(image)) image = image.toObject();
     const normalized = utils.validateImageStructure(image, { warn: () => {} });
     if (!normalized)
       throw new Error('Invalid raw image object supplied to rawToJpeg');
@@ -206,6 +302,13 @@ module.exports = function(RED) {
    * @param {string} operation - Optional operation name for context
    */
   utils.handleNodeError = function(node, error, msg, done, operation = 'processing') {
+    // Load shedding (deadline, cancellation, newer frame) drops the message
+    // without flagging an error
+    if (error && CONSTANTS.DROPPED_CODES[error.code]) {
+      node.status({ fill: "yellow", shape: "ring", text: `Dropped: ${CONSTANTS.DROPPED_CODES[error.code]}` });
+      if (done) done();
+      return;
+    }
     const errorMessage = error.message || `Unknown error during ${operation}.`;
     node.error(errorMessage, msg);
     node.status({ fill: "red", shape: "ring", text: "Error" });
@@ -214,6 +317,29 @@ module.exports = function(RED) {
     }
   }
 
+  /**
+   * Records a message latency on the node and returns the p95 of the last
+   * LATENCY_WINDOW samples (a single slow frame no longer hides the trend)
+   * @param {object} node - Node-RED node instance
+   * @param {number} totalTime - Latency of this message in ms
+   * @returns {number} p95 in ms
+   */
+  utils.recordLatency = function(node, totalTime) {
+    const window = node._latencyWindow || (node._latencyWindow = []);
+    window.push(totalTime);
+    if (window.length > CONSTANTS.LATENCY_WINDOW) window.shift();
+    const sorted = window.slice().sort((a, b) => a - b);
+    return sorted[Math.min(sorted.length - 1, Math.ceil(sorted.length * 0.95) - 1)];
+  }
+
+  function successStatusText(node, count, totalTime, timing) {
+    const { convertMs = 0, taskMs = 0, encodeMs = 0 } = timing;
+    const p95 = utils.recordLatency(node, totalTime);
+    return `OK: ${count} img, p95 ${p95.toFixed(2)} ms ` +
+           `(conv ${(convertMs + encodeMs).toFixed(2)} ms | ` +
+           `task ${taskMs.toFixed(2)} ms)`;
+  }
+
   /**
    * Standardized success status formatting
    * @param {object} node - Node-RED node instance  
@@ -222,13 +348,10 @@ module.exports = function(RED) {
    * @param {object} timing - Timing breakdown object
    */
   utils.setSuccessStatus = function(node, count, totalTime, timing = {}) {
-    const { convertMs = 0, taskMs = 0, encodeMs = 0 } = timing;
     node.status({
       fill: 'green',
       shape: 'dot',
-      text: `OK: ${count} img in ${totalTime.toFixed(2)} ms ` +
-            `(conv ${(convertMs + encodeMs).toFixed(2)} ms | ` +
-            `task ${taskMs.toFixed(2)} ms)`
+      text: successStatusText(node, count, totalTime, timing)
     });
   }
 
@@ -236,23 +359,29 @@ module.exports = function(RED) {
    * Debug image display utility for inline node debugging
    * Converts images to displayable format and returns data URL with format message
    * @param {object|Buffer} image - Image data (raw image object or encoded buffer)
-   * @param {string} outputFormat - The output format selected ('raw', 'jpg', 'png', 'webp')
+   * @param {string} outputFormat - The output format selected ('raw', 'native', 'jpg', 'png', 'webp')
    * @param {number} quality - JPEG quality for raw conversion (default: 90)
    * @param {object} node - Node-RED node instance for error reporting
    * @param {boolean} debugEnabled - Whether debugging is enabled
    * @param {number} debugWidth - Desired width for debug image display (default: 200)
+   * @param {object} [preview] - `preview` returned by the engine ({ data, width, height }):
+   *   a JPEG thumbnail made in the worker, published as is (no sharp pass)
    * @returns {Promise<object|null>} Debug result object with dataUrl and formatMessage, or null if disabled
    */
-  utils.debugImageDisplay = async function(image, outputFormat, quality, node, debugEnabled, debugWidth) {
+  utils.debugImageDisplay = async function(image, outputFormat, quality, node, debugEnabled, debugWidth, preview) {
     if (!debugEnabled) return null;
     
     // Validate and set default debug width
     debugWidth = Math.max(1, parseInt(debugWidth) || 200);
+
+    if (preview && Buffer.isBuffer(preview.data)) {
+      return publishDebugImage(node, preview.data, 'jpg preview', 'jpg', preview.width, preview.height);
+    }
     
     try {
       let imageBuffer, formatMessage;
       
-      if (outputFormat === 'raw') {
+      if (outputFormat === 'raw' || outputFormat === 'native') {
         // Convert raw image to JPG for display using existing utility
         imageBuffer = await utils.rawToJpeg(image, quality || CONSTANTS.DEFAULT_JPEG_QUALITY);
         formatMessage = 'jpg default';
@@ -278,7 +407,7 @@ module.exports = function(RED) {
           });
         
         // Only convert format if output is raw, otherwise preserve the existing format
-        if (outputFormat === 'raw') {
+        if (outputFormat === 'raw' || outputFormat === 'native') {
           // For raw format, convert to JPEG for display
           sharpInstance = sharpInstance.jpeg({ quality: quality || 90 });
           formatMessage = 'jpg default';
@@ -288,12 +417,11 @@ module.exports = function(RED) {
           formatMessage = outputFormat + ' resized';
         }
         
-        imageBuffer = await sharpInstance.toBuffer();
-        
-        // Get actual dimensions of resized image
-        const metadata = await sharp(imageBuffer).metadata();
-        actualWidth = metadata.width || debugWidth;
-        actualHeight = metadata.height || debugWidth;
+        // Actual dimensions of the resized image come back with the buffer
+        const { data, info } = await sharpInstance.toBuffer({ resolveWithObject: true });
+        imageBuffer = data;
+        actualWidth = info.width || debugWidth;
+        actualHeight = info.height || debugWidth;
         
       } catch (resizeError) {
         node.warn(`Debug image resize error: ${resizeError.message}`);
@@ -310,32 +438,8 @@ module.exports = function(RED) {
         }
       }
       
-      // Convert to base64 for WebSocket transmission
-      const base64 = imageBuffer.toString('base64');
       const mimeType = formatMessage.replace(' default', '').replace(' resized', '');
-      const dataUrl = `data:image/${mimeType};base64,${base64}`;
-      
-      // Send image to frontend via WebSocket for inline display
-      try {
-        RED.comms.publish("debug-image", {
-          id: node.id,
-          data: base64,
-          format: formatMessage,
-          mimeType: mimeType,
-          size: imageBuffer.length,
-          debugWidth: actualWidth,
-          debugHeight: actualHeight
-        });
-      } catch (wsError) {
-        node.warn(`Debug WebSocket error: ${wsError.message}`);
-        // Continue anyway - status display will still work
-      }
-      
-      return {
-        dataUrl: dataUrl,
-        formatMessage: formatMessage,
-        size: imageBuffer.length
-      };
+      return publishDebugImage(node, imageBuffer, formatMessage, mimeType, actualWidth, actualHeight);
       
     } catch (error) {
       node.warn(`Debug display error: ${error.message}`);
@@ -343,6 +447,35 @@ module.exports = function(RED) {
     }
   }
 
+  // Sends a debug image to the editor (inline display) and returns the debug result
+  function publishDebugImage(node, imageBuffer, formatMessage, mimeType, width, height) {
+    // Convert to base64 for WebSocket transmission
+    const base64 = imageBuffer.toString('base64');
+    const dataUrl = `data:image/${mimeType};base64,${base64}`;
+
+    // Send image to frontend via WebSocket for inline display
+    try {
+      RED.comms.publish("debug-image", {
+        id: node.id,
+        data: base64,
+        format: formatMessage,
+        mimeType: mimeType,
+        size: imageBuffer.length,
+        debugWidth: width,
+        debugHeight: height
+      });
+    } catch (wsError) {
+      node.warn(`Debug WebSocket error: ${wsError.message}`);
+      // Continue anyway - status display will still work
+    }
+
+    return {
+      dataUrl: dataUrl,
+      formatMessage: formatMessage,
+      size: imageBuffer.length
+    };
+  }
+
   /**
    * Enhanced success status formatting with debug information
    * @param {object} node - Node-RED node instance  
@@ -352,10 +485,7 @@ module.exports = function(RED) {
    * @param {string} debugFormat - Optional debug format message to include in status
    */
   utils.setSuccessStatusWithDebug = function(node, count, totalTime, timing = {}, debugFormat = null) {
-    const { convertMs = 0, taskMs = 0, encodeMs = 0 } = timing;
-    let statusText = `OK: ${count} img in ${totalTime.toFixed(2)} ms ` +
-                    `(conv ${(convertMs + encodeMs).toFixed(2)} ms | ` +
-                    `task ${taskMs.toFixed(2)} ms)`;
+    let statusText = successStatusText(node, count, totalTime, timing);
     
     if (debugFormat) {
       statusText += ` | ${debugFormat}`;
@@ -43,11 +43,19 @@ module.exports = function (RED) {
         const opacity = Math.max(0, Math.min(100, parseInt(config.opacity) || 50)) / 100.0;
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
+
+        // Placement: msg.blend = { x, y, mask, mode } puts image 1 at (x, y)
+        // on image 2 at its own size instead of stretching it over the frame
+        if (msg.blend && typeof msg.blend === 'object') {
+          const { x, y, mask, mode } = msg.blend;
+          Object.assign(encodeOptions, { x, y, mode,
+            mask: typeof mask === 'string' ? RED.util.getMessageProperty(msg, mask.replace(/^msg\./, '')) : mask });
+        }
 
         /* ▸ Single call to the C++ addon --------------------------------- */
-        const { image, timing = {} } =
-              await Cpp.blend(img1, img2, opacity, outputFormat, outputQuality, pngOptimize);
+        const { image, timing = {}, preview } =
+              await Cpp.blend(img1, img2, opacity, outputFormat, outputQuality, encodeOptions);
 
         /* ▸ Write the result back to msg ---------------------------------- */
         RED.util.setMessageProperty(msg, config.outputPath || 'payload', image);
@@ -74,7 +82,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              preview
             );
             
             if (debugResult) {
@@ -37,12 +37,12 @@ module.exports = function (RED) {
         const strategy  = config.strategy;    // 'pad-start' | 'pad-end' | 'pad-both' | 'resize'
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
         const padColorHex = config.padColor    || '#000000';
 
         /* ▸ Single call to the C++ addon --------------------------------- */
-        const { image, timing = {} } =
-              await Cpp.concat(imgs, direction, strategy, padColorHex, outputFormat, outputQuality, pngOptimize);
+        const { image, timing = {}, preview } =
+              await Cpp.concat(imgs, direction, strategy, padColorHex, outputFormat, outputQuality, encodeOptions);
 
         /* ▸ Write the single result back to msg -------------------------- */
         RED.util.setMessageProperty(msg, config.outputPath || 'payload', image);
@@ -69,7 +69,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              preview
             );
             
             if (debugResult) {
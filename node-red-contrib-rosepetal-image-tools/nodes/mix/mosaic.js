@@ -23,7 +23,7 @@ module.exports = function (RED) {
         const outputPath = config.outputPath || 'payload';
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
 
         /* Canvas configuration */
         const canvasWidth = Number(NodeUtils.resolveDimension(node, config.canvasWidthType, config.canvasWidth, msg));
@@ -58,7 +58,7 @@ module.exports = function (RED) {
         }
 
         /* Single ultra-fast C++ call */
-        const { image, timing = {} } = await CppProcessor.mosaic(
+        const { image, timing = {}, preview } = await CppProcessor.mosaic(
           imageArray,
           canvasWidth,
           canvasHeight,
@@ -67,7 +67,7 @@ module.exports = function (RED) {
           normalized,
           outputFormat,
           outputQuality,
-          pngOptimize
+          encodeOptions
         );
 
         /* Set output */
@@ -96,7 +96,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              preview
             );
             
             if (debugResult) {
@@ -26,7 +26,7 @@ module.exports = function (RED) {
         /* Configuration */
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
         const minConfidence = NodeUtils.resolveDimension(node, config.minConfidenceType, config.minConfidence, msg) || 0.5;
 
         /* Get input data */
@@ -65,64 +65,68 @@ module.exports = function (RED) {
           }
         }
 
-        /* Process each image with the detections */
-        const allCrops = [];
-        let totalConvertMs = 0, totalTaskMs = 0, totalEncodeMs = 0;
+        /* Pair frames with their detections:
+         * - images[] + detections[][]  → one list per frame (batch)
+         * - otherwise                  → all detections on the first image */
+        const batched = Array.isArray(imageData) &&
+          detections.length === images.length && detections.every(Array.isArray);
+        const frames = batched
+          ? images.map((image, i) => ({ image, detections: detections[i] }))
+          : [{ image: images[0], detections }];
 
-        // For now, assume single image with all detections
-        // In the future, could handle multiple images with detection arrays
-        const image = images[0]; // Use first image
-        
         /* Filter detections by confidence and extract bounding boxes */
-        const validBboxes = [];
-        for (const detection of detections) {
-          const bbox = parseSingleDetection(detection, minConfidence, image, node);
-          if (bbox) {
-            validBboxes.push(bbox);
+        const validPerFrame = frames.map(({ image, detections }) => {
+          const validBboxes = [];
+          for (const detection of detections) {
+            const bbox = parseSingleDetection(detection, minConfidence, image, node);
+            if (bbox) {
+              validBboxes.push(bbox);
+            }
           }
-        }
-        
-        if (validBboxes.length === 0) {
+          return validBboxes;
+        });
+
+        const totalValid = validPerFrame.reduce((n, list) => n + list.length, 0);
+        if (totalValid === 0) {
           node.warn(`No valid bounding boxes found with confidence >= ${minConfidence}`);
-          RED.util.setMessageProperty(msg, outputPath, []);
+          // Batched output keeps one (empty) list per frame
+          RED.util.setMessageProperty(msg, outputPath, batched ? validPerFrame.map(() => []) : []);
           if (done) done();
           return;
         }
 
-        /* Create crop jobs for all valid bounding boxes */
-        const cropJobs = validBboxes.map(bbox => {
-          // Convert bbox coordinates to crop parameters
-          const { x, y, width, height, label, confidence, originalBbox } = bbox;
-          
-          return CppProcessor.crop(image, x, y, width, height, false, outputFormat, outputQuality, pngOptimize)
-            .then(result => ({
-              crop: result.image,
-              tag: {
-                label: label,
-                confidence: confidence,
-                bbox: originalBbox
-              },
-              timing: result.timing
-            }));
-        });
+        /* Optional fixed model-input size for every crop (blank = keep) */
+        const resizeWidth  = parseInt(config.resizeWidth)  || 0;
+        const resizeHeight = parseInt(config.resizeHeight) || 0;
+        const resize = (resizeWidth > 0 || resizeHeight > 0)
+          ? { ...(resizeWidth > 0 && { width: resizeWidth }), ...(resizeHeight > 0 && { height: resizeHeight }) }
+          : undefined;
+
+        /* One native call: decode once per frame, all ROIs sliced as views */
+        const { images: cropImages, timing, preview } = await CppProcessor.cropMany(
+          batched ? frames.map(f => f.image) : frames[0].image,
+          batched ? validPerFrame : validPerFrame[0],
+          { normalized: false, outputFormat, quality: outputQuality, ...encodeOptions, resize }
+        );
 
-        /* Execute all crops in parallel */
-        const cropResults = await Promise.all(cropJobs);
-        
-        /* Accumulate results and timing */
-        cropResults.forEach(result => {
-          allCrops.push({
-            crop: result.crop,
-            tag: result.tag
-          });
-          
-          totalConvertMs += result.timing?.convertMs ?? 0;
-          totalTaskMs += result.timing?.taskMs ?? 0;
-          totalEncodeMs += result.timing?.encodeMs ?? 0;
-        });
+        const perFrameCrops = batched ? cropImages : [cropImages];
+        const cropLists = validPerFrame.map((bboxes, f) =>
+          bboxes.map(({ label, confidence, originalBbox }, k) => ({
+            crop: perFrameCrops[f][k],
+            tag: {
+              label: label,
+              confidence: confidence,
+              bbox: originalBbox
+            }
+          }))
+        );
+        const allCrops = cropLists.flat();
+        const totalConvertMs = timing?.convertMs ?? 0;
+        const totalTaskMs    = timing?.taskMs    ?? 0;
+        const totalEncodeMs  = timing?.encodeMs  ?? 0;
 
-        /* Set output */
-        RED.util.setMessageProperty(msg, outputPath, allCrops);
+        /* Set output: flat list for one frame, one list per frame for batches */
+        RED.util.setMessageProperty(msg, outputPath, batched ? cropLists : allCrops);
 
         /* Status and timing */
         const totalTime = performance.now() - t0;
@@ -140,7 +144,8 @@ module.exports = function (RED) {
               outputQuality, 
               node, 
               true, 
-              debugWidth
+              debugWidth,
+              preview
             );
             
             if (debugResult) {
@@ -25,7 +25,7 @@ module.exports = function (RED) {
         const normalized = !!config.coordNorm;
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
 
         /* imagen o lista de imágenes */
         const original = RED.util.getMessageProperty(msg, inPath);
@@ -44,17 +44,17 @@ module.exports = function (RED) {
           }
         }
 
-        /* lanzar recortes en paralelo */
-        const jobs = imgs.map(img => {
-          const x = Number(NodeUtils.resolveDimension(node, config.cropXType, config.cropX, msg));
-          const y = Number(NodeUtils.resolveDimension(node, config.cropYType, config.cropY, msg));
-          const width = Number(NodeUtils.resolveDimension(node, config.widthType, config.width, msg));
-          const height = Number(NodeUtils.resolveDimension(node, config.heightType, config.height, msg));
+        const x = Number(NodeUtils.resolveDimension(node, config.cropXType, config.cropX, msg));
+        const y = Number(NodeUtils.resolveDimension(node, config.cropYType, config.cropY, msg));
+        const width = Number(NodeUtils.resolveDimension(node, config.widthType, config.width, msg));
+        const height = Number(NodeUtils.resolveDimension(node, config.heightType, config.height, msg));
 
-          return CppProcessor.crop(img, x, y, width, height, normalized, outputFormat, outputQuality, pngOptimize);
-        });
-
-        const results = await Promise.all(jobs);
+        /* listas: recortes en paralelo dentro de una sola llamada batch */
+        const results = Array.isArray(original)
+          ? NodeUtils.batchToResults(await CppProcessor.cropBatch(
+              imgs, x, y, width, height, normalized, outputFormat, outputQuality, encodeOptions))
+          : [await CppProcessor.crop(
+              original, x, y, width, height, normalized, outputFormat, outputQuality, encodeOptions)];
 
         /* acumular métricas */
         const { totalConvertMs, totalTaskMs, totalEncodeMs, images } =
@@ -94,7 +94,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              results[0].preview
             );
             
             if (debugResult) {
@@ -23,7 +23,7 @@ module.exports = function (RED) {
         const outputPath = config.outputPath || 'payload';
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
 
         // Filter parameters
         const filterType = config.filterType || 'blur';
@@ -68,20 +68,26 @@ module.exports = function (RED) {
           ? originalPayload
           : [originalPayload];
 
-        // Process images in parallel
-        const promises = inputList.map((inputImage) => {
-          return CppProcessor.filter(
-            inputImage,
-            filterType,
-            kernelSize,
-            intensity,
-            outputFormat,
-            outputQuality,
-            pngOptimize
-          );
-        });
-
-        const results = await Promise.all(promises);
+        // Arrays are processed in parallel inside one native batch call
+        const results = Array.isArray(originalPayload)
+          ? NodeUtils.batchToResults(await CppProcessor.filterBatch(
+              inputList,
+              filterType,
+              kernelSize,
+              intensity,
+              outputFormat,
+              outputQuality,
+              encodeOptions
+            ))
+          : [await CppProcessor.filter(
+              originalPayload,
+              filterType,
+              kernelSize,
+              intensity,
+              outputFormat,
+              outputQuality,
+              encodeOptions
+            )];
 
         // Aggregate timing information
         const { totalConvertMs, totalTaskMs, encodeMs, images } =
@@ -123,7 +129,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              results[0].preview
             );
             
             if (debugResult) {
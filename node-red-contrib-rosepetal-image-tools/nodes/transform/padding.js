@@ -42,7 +42,7 @@ module.exports = function (RED) {
         /* static options from editor */
         const outputFormat = cfg.outputFormat || 'raw';
         const outputQuality = parseInt(cfg.outputQuality) || 90;
-        const pngOptimize = cfg.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(cfg, msg, node);
         const padHex   = cfg.padColor || '#000000';
 
         /* numeric margins can come from msg / flow / global */
@@ -51,11 +51,12 @@ module.exports = function (RED) {
         const lVal = Number(NodeUtils.resolveDimension(node, cfg.leftType,   cfg.left,   msg));
         const rVal = Number(NodeUtils.resolveDimension(node, cfg.rightType,  cfg.right,  msg));
 
-        /* one C++ call per image (fast, runs in parallel) */
-        const tasks = imgs.map(img =>
-          CppProcessor.padding(img, tVal, bVal, lVal, rVal, padHex, outputFormat, outputQuality, pngOptimize)
-        );
-        const results = await Promise.all(tasks);
+        /* arrays: one native batch call (parallel inside C++) */
+        const results = Array.isArray(rawIn)
+          ? NodeUtils.batchToResults(await CppProcessor.paddingBatch(
+              imgs, tVal, bVal, lVal, rVal, padHex, outputFormat, outputQuality, encodeOptions))
+          : [await CppProcessor.padding(
+              rawIn, tVal, bVal, lVal, rVal, padHex, outputFormat, outputQuality, encodeOptions)];
 
         /* collect timings */
         let cMs = 0, tMs = 0, eMs = 0;
@@ -90,7 +91,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              results[0].preview
             );
             
             if (debugResult) {
@@ -0,0 +1,191 @@
+/**
+ * @file Node-RED logic for the pipeline node (fused C++ operations).
+ * Runs an ordered list of crop/resize/rotate/filter/padding/letterbox/blend
+ * ops in a single native call: one decode, one encode, no intermediate JS
+ * buffers.
+ * Works with single images or arrays transparently.
+ * @author Rosepetal
+ */
+const { performance } = require('perf_hooks');
+const CppProcessor = require('../../lib/cpp-bridge.js');
+
+const SUPPORTED_OPS = ['resize', 'crop', 'rotate', 'filter', 'padding', 'letterbox', 'blend'];
+
+module.exports = function (RED) {
+  const NodeUtils = require('../../lib/node-utils.js')(RED);
+
+  function PipelineNode(config) {
+    RED.nodes.createNode(this, config);
+    const node = this;
+
+    /**
+     * Resolves the op list from the node config (JSON) or msg/flow/global.
+     * Blend ops may reference their second image (and placement mask) by
+     * path: { image: "msg.overlay", mask: "msg.overlayMask", x: 10, y: 10 }.
+     */
+    function resolveOps(msg) {
+      const opsType = config.opsType || 'json';
+      let ops;
+      if (opsType === 'json') {
+        ops = config.ops ? JSON.parse(config.ops) : [];
+      } else {
+        ops = RED.util.evaluateNodeProperty(config.ops, opsType, node, msg);
+        if (typeof ops === 'string') ops = JSON.parse(ops);
+      }
+
+      if (!Array.isArray(ops) || ops.length === 0) {
+        throw new Error('Pipeline ops must be a non-empty array.');
+      }
+
+      return ops.map((op, idx) => {
+        if (!op || !SUPPORTED_OPS.includes(op.type)) {
+          throw new Error(`Unsupported op at index ${idx}: ${op && op.type}. Supported: ${SUPPORTED_OPS.join(', ')}`);
+        }
+        if (op.type === 'blend') {
+          const fromMsg = (v) => (typeof v === 'string'
+            ? RED.util.getMessageProperty(msg, v.replace(/^msg\./, ''))
+            : v);
+          const resolved = { ...op, image: fromMsg(op.image) };
+          if (op.mask !== undefined) resolved.mask = fromMsg(op.mask);
+          return resolved;
+        }
+        return op;
+      });
+    }
+
+    node.on('input', async (msg, send, done) => {
+      try {
+        const startTime = performance.now();
+        node.status({});
+        const inputPath  = config.inputPath  || 'payload';
+        const outputPath = config.outputPath || 'payload';
+        const outputFormat = config.outputFormat || 'raw';
+        const outputQuality = parseInt(config.outputQuality) || 90;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
+
+        const ops = resolveOps(msg);
+
+        const originalPayload = RED.util.getMessageProperty(msg, inputPath);
+        const inputList = Array.isArray(originalPayload)
+          ? originalPayload
+          : [originalPayload];
+
+        // Validate input images
+        if (Array.isArray(originalPayload)) {
+          if (!NodeUtils.validateListImage(originalPayload, node)) {
+            // Warning already sent, don't send message
+            return;
+          }
+        } else {
+          if (!NodeUtils.validateSingleImage(originalPayload, node)) {
+            // Warning already sent, don't send message
+            return;
+          }
+        }
+
+        // One native job per image: (image, ops, outputFormat, quality, encodeOptions)
+        // (an `out` list gives each job its own destination Buffer; a single
+        // Buffer is only used when there is a single job; only the first job
+        // makes the debug preview; each slot gets its own latestKey so the
+        // jobs of one message never supersede each other)
+        const outList = Array.isArray(encodeOptions.out) ? encodeOptions.out : null;
+        const jobOptions = (i) => {
+          if (!outList && inputList.length === 1) return encodeOptions;
+          return {
+            ...encodeOptions,
+            out: outList ? outList[i] : undefined,
+            preview: i === 0 ? encodeOptions.preview : undefined,
+            latestKey: encodeOptions.latestKey && `${encodeOptions.latestKey}:${i}`
+          };
+        };
+        const promises = inputList.map((inputImage, i) =>
+          CppProcessor.pipeline(
+            inputImage,
+            ops,
+            outputFormat,
+            outputQuality,
+            jobOptions(i)
+          )
+        );
+        const results = await Promise.all(promises);
+
+        // Aggregate timings and prepare output
+        const { totalConvertMs, totalTaskMs, encodeMs, images } =
+          results.reduce(
+            (acc, { image, timing }) => {
+              acc.totalConvertMs += timing?.convertMs ?? 0;
+              acc.totalTaskMs    += timing?.taskMs    ?? 0;
+              acc.encodeMs       += timing?.encodeMs  ?? 0;
+              acc.images.push(image);
+              return acc;
+            },
+            { totalConvertMs: 0, totalTaskMs: 0, encodeMs: 0, images: [] }
+          );
+
+        const out = Array.isArray(originalPayload) ? images : images[0];
+
+        // Letterbox ops report how to map boxes back to the source image
+        if (results.some(r => r.letterbox)) {
+          const boxes = results.map(r => r.letterbox || null);
+          msg.letterbox = Array.isArray(originalPayload) ? boxes : boxes[0];
+        }
+        const elapsedTime = performance.now() - startTime;
+
+        // Debug image display
+        let debugFormat = null;
+        if (config.debugEnabled) {
+          try {
+            // Resolve and validate debug width
+            let debugWidth = NodeUtils.resolveDimension(
+              node,
+              config.debugWidthType,
+              config.debugWidth,
+              msg
+            );
+            debugWidth = Math.max(1, parseInt(debugWidth) || 200); // Ensure positive, default 200
+
+            // For arrays, show the first image as representative
+            const debugResult = await NodeUtils.debugImageDisplay(
+              images[0],
+              outputFormat,
+              outputQuality,
+              node,
+              true,
+              debugWidth,
+              results[0].preview
+            );
+
+            if (debugResult) {
+              debugFormat = debugResult.formatMessage;
+              NodeUtils.setSuccessStatusWithDebug(node, results.length, elapsedTime, {
+                convertMs: totalConvertMs,
+                taskMs: totalTaskMs,
+                encodeMs: encodeMs
+              }, debugFormat + (Array.isArray(originalPayload) ? ' (first)' : ''));
+            }
+          } catch (debugError) {
+            node.warn(`Debug display error: ${debugError.message}`);
+          }
+        }
+
+        // Set regular status if debug not enabled or failed
+        if (!debugFormat) {
+          NodeUtils.setSuccessStatus(node, results.length, elapsedTime, {
+            convertMs: totalConvertMs,
+            taskMs: totalTaskMs,
+            encodeMs: encodeMs
+          });
+        }
+
+        RED.util.setMessageProperty(msg, outputPath, out);
+
+        send(msg);
+        done && done();
+      } catch (err) {
+        NodeUtils.handleNodeError(node, err, msg, done, 'pipeline processing');
+      }
+    });
+  }
+
+  RED.nodes.registerType('pipeline', PipelineNode);
+};
@@ -21,7 +21,7 @@ module.exports = function (RED) {
         const outputPath = config.outputPath || 'payload';
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
 
         const originalPayload = RED.util.getMessageProperty(msg, inputPath);
         const inputList = Array.isArray(originalPayload)
@@ -41,36 +41,43 @@ module.exports = function (RED) {
           }
         }
 
-        const promises = inputList.map((inputImage) => {
-          // Resolve dimension values (can come from msg/flow/global)
-          let wVal = NodeUtils.resolveDimension(
-            node,
-            config.widthType,
-            config.widthValue,
-            msg
-          );
-          let hVal = NodeUtils.resolveDimension(
-            node,
-            config.heightType,
-            config.heightValue,
-            msg
-          );
+        // Resolve dimension values (can come from msg/flow/global)
+        let wVal = NodeUtils.resolveDimension(
+          node,
+          config.widthType,
+          config.widthValue,
+          msg
+        );
+        let hVal = NodeUtils.resolveDimension(
+          node,
+          config.heightType,
+          config.heightValue,
+          msg
+        );
 
-          // Convert to Number or NaN (C++ interprets NaN as "Auto")
-          wVal = wVal === null || wVal === '' ? NaN : Number(wVal);
-          hVal = hVal === null || hVal === '' ? NaN : Number(hVal);
+        // Convert to Number or NaN (C++ interprets NaN as "Auto")
+        wVal = wVal === null || wVal === '' ? NaN : Number(wVal);
+        hVal = hVal === null || hVal === '' ? NaN : Number(hVal);
 
-          // Direct call to addon: (image, wMode, wVal, hMode, hVal, outputFormat, quality, pngOptimize)
-          return CppProcessor.resize(
-            inputImage,
-            config.widthMode,  wVal,
-            config.heightMode, hVal,
-            outputFormat,
-            outputQuality,
-            pngOptimize
-          );
-        });
-        const results = await Promise.all(promises);
+        // Arrays go through one native batch call; single images use resize()
+        // (image(s), wMode, wVal, hMode, hVal, outputFormat, quality, encodeOptions)
+        const results = Array.isArray(originalPayload)
+          ? NodeUtils.batchToResults(await CppProcessor.resizeBatch(
+              inputList,
+              config.widthMode,  wVal,
+              config.heightMode, hVal,
+              outputFormat,
+              outputQuality,
+              encodeOptions
+            ))
+          : [await CppProcessor.resize(
+              originalPayload,
+              config.widthMode,  wVal,
+              config.heightMode, hVal,
+              outputFormat,
+              outputQuality,
+              encodeOptions
+            )];
 
         // Aggregate timings and prepare output
         const { totalConvertMs, totalTaskMs, encodeMs, images } =
@@ -109,7 +116,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              results[0].preview
             );
             
             if (debugResult) {
@@ -20,7 +20,7 @@ module.exports = function (RED) {
         const outputPath  = config.outputPath || 'payload';
         const outputFormat = config.outputFormat || 'raw';
         const outputQuality = parseInt(config.outputQuality) || 90;
-        const pngOptimize = config.pngOptimize || false;
+        const encodeOptions = NodeUtils.encodeOptions(config, msg, node);
         const padColorHex = config.padColor    || '#000000';
 
         const original = RED.util.getMessageProperty(msg, inputPath);
@@ -40,16 +40,16 @@ module.exports = function (RED) {
         
         const imgs     = Array.isArray(original) ? original : [original];
 
-        /* ——— lanzar rotaciones en paralelo ——— */
-        const promises = imgs.map(img => {
-          let angle = NodeUtils.resolveDimension(
-            node, config.angleType, config.angleValue, msg);
-          angle = angle === null || angle === '' ? 0 : Number(angle);
+        let angle = NodeUtils.resolveDimension(
+          node, config.angleType, config.angleValue, msg);
+        angle = angle === null || angle === '' ? 0 : Number(angle);
 
-          return CppProcessor.rotate(img, angle, padColorHex, outputFormat, outputQuality, pngOptimize);
-        });
-
-        const results = await Promise.all(promises);
+        /* ——— listas: una sola llamada batch en C++ ——— */
+        const results = Array.isArray(original)
+          ? NodeUtils.batchToResults(await CppProcessor.rotateBatch(
+              imgs, angle, padColorHex, outputFormat, outputQuality, encodeOptions))
+          : [await CppProcessor.rotate(
+              original, angle, padColorHex, outputFormat, outputQuality, encodeOptions)];
 
         /* ——— acumular métricas ——— */
         const { totalConvertMs, totalTaskMs, encodeMs, images } =
@@ -87,7 +87,8 @@ module.exports = function (RED) {
               outputQuality,
               node,
               true,
-              debugWidth
+              debugWidth,
+              results[0].preview
             );
             
             if (debugResult) {
@@ -0,0 +1,71 @@
+#!/usr/bin/env node
+
+/**
+ * Compares two bench/run.js reports case by case.
+ *
+ *   node bench/compare.js base.json current.json [--threshold 10] [--metric p50Ms]
+ *
+ * Prints the relative change of the latency metric and of throughput for
+ * every case present in both files, and exits with 1 when any case got
+ * slower than the threshold (percent), so it can gate a release.
+ */
+
+const fs = require('fs');
+
+function parseArgs(argv) {
+    const files = [];
+    const args = { threshold: 10, metric: 'p50Ms' };
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i] === '--threshold') args.threshold = parseFloat(argv[++i]);
+        else if (argv[i] === '--metric') args.metric = argv[++i];
+        else files.push(argv[i]);
+    }
+    if (files.length !== 2) {
+        throw new Error('Usage: compare.js base.json current.json [--threshold 10] [--metric p50Ms]');
+    }
+    return { ...args, base: files[0], current: files[1] };
+}
+
+const load = (file) => {
+    const report = JSON.parse(fs.readFileSync(file, 'utf8'));
+    return { meta: report.meta || {}, cases: new Map((report.results || []).filter(r => !r.error).map(r => [r.key, r])) };
+};
+
+const pct = (from, to) => (from > 0 ? (to - from) / from * 100 : 0);
+const signed = (v) => `${v >= 0 ? '+' : ''}${v.toFixed(1)}%`;
+
+function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const base = load(opts.base);
+    const current = load(opts.current);
+
+    console.log(`base:    ${base.meta.engineVersion || '?'} (${base.meta.date || '?'}, ${base.meta.cpu || '?'})`);
+    console.log(`current: ${current.meta.engineVersion || '?'} (${current.meta.date || '?'}, ${current.meta.cpu || '?'})\n`);
+
+    const regressions = [];
+    let compared = 0;
+    for (const [key, c] of current.cases) {
+        const b = base.cases.get(key);
+        if (!b || !(opts.metric in c)) continue;
+        compared++;
+        const latency = pct(b[opts.metric], c[opts.metric]);
+        const throughput = pct(b.jobsPerSec, c.jobsPerSec);
+        const flag = latency > opts.threshold ? '  << REGRESSION' : (latency < -opts.threshold ? '  (faster)' : '');
+        if (latency > opts.threshold) regressions.push(key);
+        console.log(`${key.padEnd(52)} ${opts.metric} ${b[opts.metric].toFixed(2).padStart(9)} → ` +
+                    `${c[opts.metric].toFixed(2).padStart(9)} ms ${signed(latency).padStart(8)}  ` +
+                    `jobs/s ${signed(throughput).padStart(8)}${flag}`);
+    }
+
+    const missing = [...base.cases.keys()].filter(k => !current.cases.has(k));
+    console.log(`\nCompared ${compared} cases; ${regressions.length} slower than ${opts.threshold}%` +
+                (missing.length ? `; ${missing.length} base cases missing from current` : ''));
+    process.exit(regressions.length ? 1 : 0);
+}
+
+try {
+    main();
+} catch (error) {
+    console.error(error.message);
+    process.exit(2);
+}
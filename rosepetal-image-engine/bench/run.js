@@ -0,0 +1,252 @@
+#!/usr/bin/env node
+
+/**
+ * Benchmark harness for the native engine (through cpp-bridge.js).
+ *
+ * Runs every op over a matrix of image sizes, colour layouts, output formats
+ * and concurrency levels and writes one JSON record per case, keyed so two
+ * runs can be diffed with bench/compare.js.
+ *
+ *   node bench/run.js [--quick] [--ops resize,filter] [--sizes vga,fhd,20mp]
+ *                     [--colors gray,bgr,rgba] [--formats raw,jpg,png,webp]
+ *                     [--concurrency 1,4,8] [--iterations 20] [--threads N]
+ *                     [--png-mode fast] [--out bench-results.json]
+ *
+ * Per case: wall latency per job (p50/p95/p99), throughput (jobs/s and
+ * MPix/s) and the medians of the engine's own stage timings, so a kernel
+ * regression (taskMs) can be told apart from codec or queueing changes.
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { performance } = require('perf_hooks');
+const CppProcessor = require('../../node-red-contrib-rosepetal-image-tools/lib/cpp-bridge.js');
+const pkg = require('../package.json');
+
+const SIZES = {
+    vga:   [640, 480],
+    hd:    [1280, 720],
+    fhd:   [1920, 1080],
+    '4k':  [3840, 2160],
+    '12mp': [4000, 3000],
+    '20mp': [5472, 3648]
+};
+
+const COLORS = {
+    gray: { channels: 1, colorSpace: 'GRAY' },
+    bgr:  { channels: 3, colorSpace: 'BGR' },
+    rgba: { channels: 4, colorSpace: 'RGBA' }
+};
+
+const PRESETS = {
+    full:  { sizes: Object.keys(SIZES), colors: Object.keys(COLORS), formats: ['raw', 'jpg', 'png', 'webp'],
+             concurrency: [1, 2, 4, 8], iterations: 20 },
+    quick: { sizes: ['vga', 'fhd'], colors: ['bgr'], formats: ['raw', 'jpg'],
+             concurrency: [1, 4], iterations: 8 }
+};
+
+/* ─ Ops: each returns its cases as { name, run(image, format, quality, options) } ─ */
+const OPS = {
+    resize: () => [
+        { name: 'half', run: (img, f, q, o) => CppProcessor.resize(img, 'multiply', 0.5, 'multiply', 0.5, f, q, o) },
+        { name: 'to-vga', run: (img, f, q, o) => CppProcessor.resize(img, 'set', 640, 'set', NaN, f, q, o) }
+    ],
+    rotate: () => [
+        { name: 'fast-90', run: (img, f, q, o) => CppProcessor.rotate(img, 90, '#000000', f, q, o) },
+        { name: 'warp-33', run: (img, f, q, o) => CppProcessor.rotate(img, 33, '#000000', f, q, o) }
+    ],
+    crop: () => [
+        { name: 'center-50', run: (img, f, q, o) => CppProcessor.crop(img, 0.25, 0.25, 0.5, 0.5, true, f, q, o) }
+    ],
+    filter: () => {
+        const cases = [];
+        for (const type of ['blur', 'sharpen', 'edge', 'emboss', 'gaussian']) {
+            for (const k of [3, 7, 15]) {
+                cases.push({ name: `${type}-k${k}`, run: (img, f, q, o) => CppProcessor.filter(img, type, k, 1.0, f, q, o) });
+            }
+        }
+        return cases;
+    },
+    letterbox: () => [
+        { name: 'to-640', run: (img, f, q, o) => CppProcessor.letterbox(img, 640, 640, '#727272', 'center', f, q, o) }
+    ],
+    padding: () => [
+        { name: 'pad-32', run: (img, f, q, o) => CppProcessor.padding(img, 32, 32, 32, 32, '#000000', f, q, o) }
+    ],
+    concat: () => [
+        { name: 'right-x4', run: (img, f, q, o) => CppProcessor.concat([img, img, img, img], 'right', 'pad-both', '#000000', f, q, o) },
+        { name: 'down-x4', run: (img, f, q, o) => CppProcessor.concat([img, img, img, img], 'down', 'pad-both', '#000000', f, q, o) }
+    ],
+    mosaic: () => [
+        { name: 'grid-2x2', run: (img, f, q, o) => CppProcessor.mosaic(
+            [img, img, img, img], img.width, img.height, '#000000', quadrants(img), false, f, q, o) }
+    ],
+    advancedMosaic: () => [
+        { name: 'rotated-2x2', run: (img, f, q, o) => CppProcessor.advancedMosaic(
+            [img, img, img, img], img.width, img.height, '#000000',
+            quadrants(img).map((p, i) => ({ ...p, rotation: 15 * i, width: img.width >> 1, height: img.height >> 1, zIndex: i })),
+            false, f, q, o) }
+    ],
+    blend: () => [
+        { name: 'opacity-50', run: (img, f, q, o) => CppProcessor.blend(img, img, 0.5, f, q, o) }
+    ]
+};
+
+function quadrants(img) {
+    const w = img.width >> 1, h = img.height >> 1;
+    return [
+        { arrayIndex: 0, x: 0, y: 0 }, { arrayIndex: 1, x: w, y: 0 },
+        { arrayIndex: 2, x: 0, y: h }, { arrayIndex: 3, x: w, y: h }
+    ];
+}
+
+/* ─ Helpers ─ */
+function parseArgs(argv) {
+    const args = { preset: 'full' };
+    for (let i = 0; i < argv.length; i++) {
+        const a = argv[i];
+        if (a === '--quick') { args.preset = 'quick'; continue; }
+        if (!a.startsWith('--')) throw new Error(`Unexpected argument: ${a}`);
+        const key = a.slice(2).replace(/-([a-z])/g, (_, c) => c.toUpperCase());
+        args[key] = argv[++i];
+    }
+    const preset = PRESETS[args.preset];
+    const list = (v, def) => (v ? String(v).split(',').map(s => s.trim()).filter(Boolean) : def);
+    return {
+        ops:         list(args.ops, Object.keys(OPS)),
+        sizes:       list(args.sizes, preset.sizes),
+        colors:      list(args.colors, preset.colors),
+        formats:     list(args.formats, preset.formats),
+        concurrency: list(args.concurrency, preset.concurrency).map(Number),
+        iterations:  parseInt(args.iterations, 10) || preset.iterations,
+        threads:     parseInt(args.threads, 10) || 0,
+        pngMode:     args.pngMode || 'fast',
+        out:         args.out || 'bench-results.json'
+    };
+}
+
+// Gradient + hash noise: flat enough to look like a photo, noisy enough
+// that the encoders cannot shortcut it
+function makeImage(width, height, { channels, colorSpace }) {
+    const data = Buffer.allocUnsafe(width * height * channels);
+    let i = 0;
+    for (let y = 0; y < height; y++) {
+        for (let x = 0; x < width; x++) {
+            const n = ((x * 73856093) ^ (y * 19349663)) & 31;
+            for (let c = 0; c < channels; c++) {
+                data[i++] = c === 3 ? 255 : ((((x * (c + 1) + y * (3 - c)) >> 3) + n) & 255);
+            }
+        }
+    }
+    return { data, width, height, channels, colorSpace, dtype: 'uint8' };
+}
+
+function percentile(sorted, q) {
+    if (!sorted.length) return 0;
+    return sorted[Math.min(sorted.length - 1, Math.max(0, Math.ceil(q * sorted.length) - 1))];
+}
+
+const median = (values) => percentile(values.slice().sort((a, b) => a - b), 0.5);
+const round = (v) => Math.round(v * 1000) / 1000;
+
+// Runs `iterations` jobs with at most `concurrency` in flight
+async function runCase(run, image, format, quality, options, iterations, concurrency) {
+    const latencies = [];
+    const stages = { queueMs: [], convertMs: [], taskMs: [], encodeMs: [] };
+    let next = 0;
+
+    const lane = async () => {
+        while (next < iterations) {
+            next++;
+            const t0 = performance.now();
+            const { timing = {} } = await run(image, format, quality, options);
+            latencies.push(performance.now() - t0);
+            for (const k of Object.keys(stages)) stages[k].push(timing[k] || 0);
+        }
+    };
+
+    const t0 = performance.now();
+    await Promise.all(Array.from({ length: Math.min(concurrency, iterations) }, lane));
+    const wallMs = performance.now() - t0;
+
+    latencies.sort((a, b) => a - b);
+    const jobsPerSec = iterations / (wallMs / 1e3);
+    return {
+        iterations,
+        wallMs: round(wallMs),
+        p50Ms: round(percentile(latencies, 0.50)),
+        p95Ms: round(percentile(latencies, 0.95)),
+        p99Ms: round(percentile(latencies, 0.99)),
+        jobsPerSec: round(jobsPerSec),
+        mpixPerSec: round(jobsPerSec * image.width * image.height / 1e6),
+        stages: Object.fromEntries(Object.entries(stages).map(([k, v]) => [k, round(median(v))]))
+    };
+}
+
+/* ─ Main ─ */
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    for (const op of opts.ops) if (!OPS[op]) throw new Error(`Unknown op: ${op}. Available: ${Object.keys(OPS).join(', ')}`);
+    for (const s of opts.sizes) if (!SIZES[s]) throw new Error(`Unknown size: ${s}. Available: ${Object.keys(SIZES).join(', ')}`);
+    for (const c of opts.colors) if (!COLORS[c]) throw new Error(`Unknown color: ${c}. Available: ${Object.keys(COLORS).join(', ')}`);
+
+    const engineConfig = CppProcessor.configure(opts.threads ? { threads: opts.threads } : undefined);
+    const results = [];
+    const warmup = 2;
+
+    console.log(`Engine: ${engineConfig.threads} threads, OpenCV ${engineConfig.opencvThreads}; ` +
+                `${opts.iterations} iterations per case\n`);
+
+    for (const sizeName of opts.sizes) {
+        const [width, height] = SIZES[sizeName];
+        for (const colorName of opts.colors) {
+            const image = makeImage(width, height, COLORS[colorName]);
+            for (const opName of opts.ops) {
+                for (const { name, run } of OPS[opName]()) {
+                    for (const format of opts.formats) {
+                        const options = { pngMode: opts.pngMode };
+                        for (let i = 0; i < warmup; i++) await run(image, format, 90, options);
+
+                        for (const concurrency of opts.concurrency) {
+                            const key = `${opName}/${name}/${sizeName}/${colorName}/${format}/c${concurrency}`;
+                            try {
+                                const r = await runCase(run, image, format, 90, options, opts.iterations, concurrency);
+                                results.push({ key, op: opName, case: name, size: sizeName, width, height,
+                                               color: colorName, format, concurrency, ...r });
+                                console.log(`${key.padEnd(52)} p50 ${r.p50Ms.toFixed(2).padStart(9)} ms  ` +
+                                            `p95 ${r.p95Ms.toFixed(2).padStart(9)} ms  ${r.jobsPerSec.toFixed(1).padStart(8)} jobs/s`);
+                            } catch (error) {
+                                results.push({ key, op: opName, case: name, size: sizeName, color: colorName,
+                                               format, concurrency, error: error.message });
+                                console.log(`${key.padEnd(52)} FAILED - ${error.message}`);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    const report = {
+        meta: {
+            engineVersion: pkg.version,
+            node: process.version,
+            platform: `${os.platform()}-${os.arch()}`,
+            cpu: os.cpus()[0] ? os.cpus()[0].model : 'unknown',
+            cpuCount: os.cpus().length,
+            date: new Date().toISOString(),
+            engine: engineConfig,
+            options: opts
+        },
+        results
+    };
+    fs.writeFileSync(path.resolve(opts.out), JSON.stringify(report, null, 2));
+    console.log(`\nWrote ${results.length} cases to ${opts.out}`);
+    process.exit(results.some(r => r.error) ? 1 : 0);
+}
+
+main().catch(error => {
+    console.error('Benchmark error:', error.message);
+    process.exit(1);
+});
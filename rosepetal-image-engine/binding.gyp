@@ -1,4 +1,9 @@
 {
+  "variables": {
+    "has_turbojpeg": "<!(pkg-config --exists libturbojpeg && echo 1 || echo 0)",
+    "has_libwebp": "<!(pkg-config --exists libwebp && echo 1 || echo 0)",
+    "has_libjpeg": "<!(pkg-config --exists libjpeg && echo 1 || echo 0)"
+  },
   "targets": [
     {
       "target_name": "addon",
@@ -12,7 +17,15 @@
         "src/filter.cpp",
         "src/mosaic.cpp",
         "src/advanced-mosaic.cpp",
-        "src/blend.cpp"
+        "src/blend.cpp",
+        "src/letterbox.cpp",
+        "src/pipeline.cpp",
+        "src/batch.cpp",
+        "src/pool.cpp",
+        "src/engine.cpp",
+        "src/native-image.cpp",
+        "src/cancel-token.cpp",
+        "src/streaming.cpp"
       ],
       "include_dirs": [
         "/usr/include/opencv4",
@@ -27,8 +40,6 @@
       "cflags_cc": [
         "-std=c++17",
         "-O3",
-        "-ffast-math",
-        "-march=native",
         "-fexceptions",
         "-frtti",
         "-fno-omit-frame-pointer",
@@ -36,8 +47,33 @@
         "-fstrict-aliasing"
       ],
       "ldflags": [
-        "-O3",
-        "-march=native"
+        "-O3"
+      ],
+      "conditions": [
+        ["has_turbojpeg==1", {
+          "defines": [ "HAVE_TURBOJPEG" ],
+          "cflags_cc": [ "<!@(pkg-config --cflags libturbojpeg)" ],
+          "libraries": [ "<!@(pkg-config --libs libturbojpeg)" ],
+          "xcode_settings": {
+            "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags libturbojpeg)" ]
+          }
+        }],
+        ["has_libwebp==1", {
+          "defines": [ "HAVE_LIBWEBP" ],
+          "cflags_cc": [ "<!@(pkg-config --cflags libwebp)" ],
+          "libraries": [ "<!@(pkg-config --libs libwebp)" ],
+          "xcode_settings": {
+            "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags libwebp)" ]
+          }
+        }],
+        ["has_libjpeg==1", {
+          "defines": [ "HAVE_LIBJPEG" ],
+          "cflags_cc": [ "<!@(pkg-config --cflags libjpeg)" ],
+          "libraries": [ "<!@(pkg-config --libs libjpeg)" ],
+          "xcode_settings": {
+            "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags libjpeg)" ]
+          }
+        }]
       ],
       "xcode_settings": {
         "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
@@ -45,8 +81,6 @@
         "OTHER_CPLUSPLUSFLAGS": [
           "-std=c++17",
           "-O3",
-          "-ffast-math",
-          "-march=native",
           "-funroll-loops"
         ]
       }
@@ -1,12 +1,17 @@
 // ───────── src/advanced-mosaic.cpp ───────────────────────────────────────────────
 // ADVANCED MOSAIC - Ultra-optimized image compositing with per-image transformations
-// Combines resize, rotate, and positioning in a single high-performance pipeline
+// Combines resize, rotate, and positioning in a single high-performance pipeline:
+// arbitrary angles are one affine warp per tile (a single resample), straight
+// into the visible canvas region
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include "utils.h"
+#include "compositing/alpha-blend.h"
+#include "runtime/device.h"
+#include "geometry/remap-cache.h"
 
 // Helper function to determine the best canvas format from multiple input formats
 std::string DetermineBestCanvasFormatAdvanced(const std::vector<std::string>& channels) {
@@ -30,7 +35,7 @@ std::string DetermineBestCanvasFormatAdvanced(const std::vector<std::string>& ch
 }
 
 /*────────────────────────── ULTRA-FAST AdvancedMosaicWorker ───────────────────────────────────*/
-class AdvancedMosaicWorker : public Napi::AsyncWorker {
+class AdvancedMosaicWorker : public EngineWorker {
 public:
   AdvancedMosaicWorker(Napi::Function cb,
                        const Napi::Array& imagesArray,
@@ -39,48 +44,22 @@ public:
                        const Napi::Array& imageConfigsArray,
                        bool normalized, std::string outputFormat,
                        int quality = 90,
-                       bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+                       EncodeOptions encodeOpts = {},
+                       OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "advancedMosaic"),
       canvasWidth_(canvasWidth), canvasHeight_(canvasHeight),
       backgroundColor_(backgroundColor),
       normalized_(normalized), outputFormat_(std::move(outputFormat)),
-      quality_(quality), pngOptimize_(pngOptimize)
+      quality_(quality), encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget))
   {
-    /* ─ SUPER FAST image conversion with timing ─ */
-    const int64 t0 = cv::getTickCount();
-    
     // Pre-allocate vectors for maximum performance
-    images_.reserve(imagesArray.Length());
-    imageChannels_.reserve(imagesArray.Length());
+    inputs_.reserve(imagesArray.Length());
     imageConfigs_.reserve(imageConfigsArray.Length());
     
-    // Convert images with zero-copy operations and extract channel formats
+    // Wrap inputs only - decoding is deferred to Execute() (worker thread)
     for (uint32_t i = 0; i < imagesArray.Length(); i++) {
-      images_.emplace_back(ConvertToMat(imagesArray[i]));
-      
-      // Extract and store channel format for each image
-      std::string channel;
-      if (imagesArray[i].IsObject() && !imagesArray[i].IsBuffer()) {
-        Napi::Object obj = imagesArray[i].As<Napi::Object>();
-        
-        // Check for new colorSpace field first
-        if (obj.Has("colorSpace")) {
-          channel = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-        }
-        // Default based on channel count
-        else {
-          channel = (images_[i].channels() == 4) ? "BGRA"
-                  : (images_[i].channels() == 3) ? "BGR" 
-                  : "GRAY";
-        }
-      } else {
-        // Buffer input - determine from OpenCV Mat
-        channel = (images_[i].channels() == 4) ? "BGRA"
-                : (images_[i].channels() == 3) ? "BGR"
-                : "GRAY";
-      }
-      
-      imageChannels_.emplace_back(channel);
+      inputs_.push_back(PrepareInput(imagesArray[i]));
     }
     
     // Parse image configurations - ultra-fast operations
@@ -117,26 +96,32 @@ public:
               });
     
     // Check if any images have rotation to determine if we need alpha support
-    bool hasRotation = false;
     for (const auto& config : imageConfigs_) {
       if (std::abs(config.rotation) > 1e-3) {
-        hasRotation = true;
+        hasRotation_ = true;
         break;
       }
     }
+  }
+
+protected:
+  void Execute() override {
+    /* ─ Decode inputs on the worker thread (parallel for encoded buffers) ─ */
+    convertMs_ = DecodeInputs(inputs_);
+    images_.reserve(inputs_.size());
+    imageChannels_.reserve(inputs_.size());
+    for (const auto& in : inputs_) {
+      images_.push_back(in.mat);
+      imageChannels_.push_back(in.colorSpace);
+    }
     
     // Determine the best canvas format, preferring RGBA if rotation is detected
-    if (hasRotation) {
+    if (hasRotation_) {
       canvasChannel_ = "RGBA"; // Force RGBA for transparent rotation padding
     } else {
       canvasChannel_ = DetermineBestCanvasFormatAdvanced(imageChannels_);
     }
     
-    convertMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
-  }
-
-protected:
-  void Execute() override {
     /* ─ SUPER FAST advanced mosaic composition ─ */
     const int64 t0 = cv::getTickCount();
     
@@ -170,25 +155,23 @@ protected:
     
     /* ─ SUPER FAST multi-format encoding (optional) ─ */
     if (outputFormat_ != "raw") {
-      // Convert to BGR format for encoding if needed
-      const cv::Mat& srcForEncoding = (canvasChannel_ == "BGR") ? canvas_ 
-                                     : ToBgrForJpg(canvas_, canvasChannel_);
-      encodeMs_ = EncodeToFormat(srcForEncoding, encodedBuf_, outputFormat_, quality_, pngOptimize_);
+      // JPEG encodes straight from the canvas format (BGR conversion otherwise)
+      encodeMs_ = EncodeImage(canvas_, canvasChannel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
     }
+    out_.Capture(outputFormat_, canvas_, encodedBuf_, canvasChannel_);
   }
   
   void OnOK() override {
     Napi::Env env = Env();
     
     // Zero-copy output creation with correct channel format
-    Napi::Value jsImg = (outputFormat_ != "raw")
-        ? VectorToBuffer(env, std::move(encodedBuf_))       // Zero-copy encoded
-        : MatToRawJS(env, canvas_.clone(), canvasChannel_); // Contiguous raw with correct channel format
+    Napi::Value jsImg = out_.ToJS(env, outputFormat_, canvas_, canvasChannel_, encodedBuf_);
     
     Napi::Object result = Napi::Object::New(env);
     result.Set("image", jsImg);
-    result.Set("timing", MakeTimingJS(env, convertMs_, taskMs_, encodeMs_));
+    result.Set("timing", TimingJS(convertMs_, taskMs_, encodeMs_));
     
+    out_.AttachPreview(result);
     Callback().Call({ env.Null(), result });
   }
   
@@ -205,118 +188,197 @@ private:
     int zIndex;
   };
   
-  // ULTRA-FAST image processing with transformations
+  // Top-left corner of a tile (of its rotated bounding box) on the canvas
+  cv::Point TileOrigin(const ImageConfig& config) const {
+    return normalized_
+      ? cv::Point(static_cast<int>(std::round(config.x * canvasWidth_)),
+                  static_cast<int>(std::round(config.y * canvasHeight_)))
+      : cv::Point(static_cast<int>(std::lround(config.x)),
+                  static_cast<int>(std::lround(config.y)));
+  }
+
+  // Resize, rotate and place one tile. The decoded inputs may be shared
+  // (decode cache, NativeImage), so they are only read: no per-tile clone.
   void ProcessImageFast(const ImageConfig& config) {
     if (config.arrayIndex < 0 || config.arrayIndex >= static_cast<int>(images_.size())) {
       return; // Skip invalid indices
     }
     
-    cv::Mat img = images_[config.arrayIndex].clone(); // Work with copy for transformations
-    if (img.empty()) return;
+    const cv::Mat& src = images_[config.arrayIndex];
+    if (src.empty()) return;
     
     const std::string& imgChannel = imageChannels_[config.arrayIndex];
     
-    // Step 1: Resize if needed
+    // Target size (aspect ratio kept if only one dimension is given)
+    cv::Size target = src.size();
     if (config.width > 0 || config.height > 0) {
-      int targetWidth = config.width > 0 ? config.width : img.cols;
-      int targetHeight = config.height > 0 ? config.height : img.rows;
-      
-      // Maintain aspect ratio if only one dimension specified
+      target.width = config.width > 0 ? config.width : src.cols;
+      target.height = config.height > 0 ? config.height : src.rows;
       if (config.width > 0 && config.height <= 0) {
-        targetHeight = static_cast<int>(std::round(targetWidth * static_cast<double>(img.rows) / img.cols));
+        target.height = static_cast<int>(std::round(target.width * static_cast<double>(src.rows) / src.cols));
       } else if (config.height > 0 && config.width <= 0) {
-        targetWidth = static_cast<int>(std::round(targetHeight * static_cast<double>(img.cols) / img.rows));
+        target.width = static_cast<int>(std::round(target.height * static_cast<double>(src.cols) / src.rows));
       }
-      
-      cv::resize(img, img, cv::Size(targetWidth, targetHeight), 0, 0, cv::INTER_LINEAR);
     }
+    if (target.width <= 0 || target.height <= 0) return;
     
-    // Step 2: Rotate if needed
+    // Fast-path for multiples of 90° (transpose / flip, no resampling)
+    int rotateCode = -1;
+    bool arbitrary = false;
     if (std::abs(config.rotation) > 1e-3) {
-      // Fast-path for 90-degree rotations
-      double normalizedAngle = std::fmod(config.rotation + 360.0, 360.0);
-      double eps = 1e-3;
-      
+      const double normalizedAngle = std::fmod(config.rotation + 360.0, 360.0);
+      const double eps = 1e-3;
       if (std::abs(normalizedAngle) < eps || std::abs(normalizedAngle - 360.0) < eps) {
         // 0 degrees - no rotation needed
       } else if (std::abs(normalizedAngle - 90.0) < eps) {
-        // 90° counterclockwise (mathematical standard)
-        cv::rotate(img, img, cv::ROTATE_90_COUNTERCLOCKWISE);
+        rotateCode = cv::ROTATE_90_COUNTERCLOCKWISE;   // counterclockwise (mathematical standard)
       } else if (std::abs(normalizedAngle - 180.0) < eps) {
-        cv::rotate(img, img, cv::ROTATE_180);
+        rotateCode = cv::ROTATE_180;
       } else if (std::abs(normalizedAngle - 270.0) < eps) {
-        // 270° counterclockwise = 90° clockwise
-        cv::rotate(img, img, cv::ROTATE_90_CLOCKWISE);
+        rotateCode = cv::ROTATE_90_CLOCKWISE;
       } else {
-        // Arbitrary angles - use affine transformation
-        // Negate rotation to make positive angles counterclockwise (mathematical standard)
-        // OpenCV uses clockwise positive, so we negate to get counterclockwise positive
-        int w = img.cols, h = img.rows;
-        cv::Point2f center(w / 2.0f, h / 2.0f);
-        cv::Mat rotationMatrix = cv::getRotationMatrix2D(center, -config.rotation, 1.0);
-        
-        // Calculate new bounding box to prevent cropping
-        double cosA = std::abs(rotationMatrix.at<double>(0, 0));
-        double sinA = std::abs(rotationMatrix.at<double>(0, 1));
-        cv::Size newSize(static_cast<int>(h * sinA + w * cosA), 
-                        static_cast<int>(h * cosA + w * sinA));
-        
-        // Adjust translation to center the rotated image
-        rotationMatrix.at<double>(0, 2) += newSize.width / 2.0 - center.x;
-        rotationMatrix.at<double>(1, 2) += newSize.height / 2.0 - center.y;
-        
-        // Use transparent padding for rotation to allow layering effects
-        // This allows background images to show through the rotation padding areas
-        cv::Scalar padColor(0, 0, 0, 0); // Transparent black (RGBA)
-        
-        // Ensure the image has an alpha channel for transparent padding
-        // Respect original colorSpace format to prevent channel inversion
-        if (img.channels() == 3) {
-          if (imgChannel == "RGB") {
-            cv::cvtColor(img, img, cv::COLOR_RGB2RGBA);
-          } else { // BGR format
-            cv::cvtColor(img, img, cv::COLOR_BGR2BGRA);
-          }
-        } else if (img.channels() == 1) {
-          cv::cvtColor(img, img, cv::COLOR_GRAY2BGRA);
-        }
-        // 4-channel images (RGBA/BGRA) already have alpha - no conversion needed
-        
-        cv::warpAffine(img, img, rotationMatrix, newSize, 
-                      cv::INTER_LINEAR, cv::BORDER_CONSTANT, padColor);
+        arbitrary = true;
       }
     }
     
-    // Step 3: Place on canvas
-    // Update channel format if we converted for rotation
-    std::string finalImgChannel = imgChannel;
-    if (config.rotation && std::abs(config.rotation) > 1e-3) {
-      // After rotation with transparent padding, track correct format
-      if (img.channels() == 4) {
-        // Preserve original color order for all input formats
-        if (imgChannel == "RGB") {
-          finalImgChannel = "RGBA";
-        } else if (imgChannel == "BGR") {
-          finalImgChannel = "BGRA"; 
-        } else if (imgChannel == "GRAY") {
-          finalImgChannel = "BGRA"; // GRAY converts to BGRA
-        }
-        // RGBA and BGRA inputs remain unchanged
-      }
+    if (arbitrary) {
+      WarpTile(src, imgChannel, target, config);
+      return;
+    }
+    
+    // Unclipped CPU resize into a canvas of the same format: straight into
+    // the canvas ROI
+    const cv::Point origin = TileOrigin(config);
+    const cv::Rect placed(origin, target);
+    if (rotateCode < 0 && target != src.size() && imgChannel == canvasChannel_ &&
+        src.type() == canvas_.type() && src.channels() != 4 &&
+        (placed & cv::Rect(0, 0, canvasWidth_, canvasHeight_)) == placed &&
+        !ComputeDevice::Instance().Offload(GpuOp::MOSAIC, static_cast<double>(src.total()))) {
+      cv::Mat dst = canvas_(placed);
+      cv::resize(src, dst, target, 0, 0, cv::INTER_LINEAR);
+      return;
+    }
+    
+    cv::Mat img = src;
+    if (target != src.size()) {
+      img = OnDevice(GpuOp::MOSAIC, static_cast<double>(src.total()),
+        [&] { cv::Mat r; cv::resize(src, r, target, 0, 0, cv::INTER_LINEAR); return r; },
+        [&] { cv::UMat r; cv::resize(Upload(src), r, target, 0, 0, cv::INTER_LINEAR); return r; });
+    }
+    if (rotateCode >= 0) {
+      cv::Mat rotated;
+      cv::rotate(img, rotated, rotateCode);
+      img = rotated;
+    }
+    PlaceImageOnCanvas(img, config, imgChannel);
+  }
+  
+  // Canvas order with alpha (RGBA), picked from the tile's real channel
+  // count; the label only tells RGB from BGR order
+  static cv::Mat ToRgba(const cv::Mat& tile, const std::string& imgChannel) {
+    const bool rgbOrder = imgChannel.compare(0, 3, "RGB") == 0;
+    int code;
+    switch (tile.channels()) {
+      case 1:  code = cv::COLOR_GRAY2RGBA; break;
+      case 3:  code = rgbOrder ? cv::COLOR_RGB2RGBA : cv::COLOR_BGR2RGBA; break;
+      case 4:
+        if (rgbOrder) return tile;
+        code = cv::COLOR_BGRA2RGBA;
+        break;
+      default: throw std::runtime_error("advanced mosaic: unsupported channel count");
+    }
+    cv::Mat rgba;
+    cv::cvtColor(tile, rgba, code);
+    return rgba;
+  }
+  
+  // Arbitrary angles: resize, rotation about the tile centre and placement
+  // composed into one affine map, sampled once (INTER_LINEAR) for just the
+  // visible part of the tile's bounding box and alpha-blended onto the
+  // canvas. Same geometry as cv::resize + RotationMatrix() + placement at
+  // TileOrigin(); the padding is transparent so the layers below show
+  // through. hasRotation_ makes the canvas RGBA here.
+  // Unscaled tiles that land wholly on the canvas keep the shared remap
+  // tables instead (src/geometry/remap-cache.h): a mosaic that rotates the
+  // same camera frames every message then costs a lookup and a gather.
+  void WarpTile(const cv::Mat& src, const std::string& imgChannel,
+                const cv::Size& target, const ImageConfig& config) {
+    // Negate rotation to make positive angles counterclockwise (OpenCV
+    // uses clockwise positive)
+    cv::Size box;
+    const cv::Mat R = RemapCache::RotationMatrix(
+        target, RemapCache::QuantizeAngle(-config.rotation), box);
+    const cv::Point origin = TileOrigin(config);
+    const cv::Rect canvasRect(0, 0, canvasWidth_, canvasHeight_);
+    const cv::Rect roi = cv::Rect(origin, box) & canvasRect;
+    if (roi.empty()) return;
+    
+    if (target == src.size() && roi == cv::Rect(origin, box)) {
+      const cv::Mat rotated = RotateOnDevice(GpuOp::MOSAIC, ToRgba(src, imgChannel), -config.rotation,
+                                             cv::INTER_LINEAR, cv::Scalar(0, 0, 0, 0));
+      cv::Mat canvasROI = canvas_(roi);
+      AlphaOver(rotated, canvasROI);
+      return;
     }
     
-    PlaceImageOnCanvas(img, config, finalImgChannel);
+    // src → canvas ROI: R · S (cv::resize pixel-centre convention) + origin
+    const double sx = static_cast<double>(target.width) / src.cols;
+    const double sy = static_cast<double>(target.height) / src.rows;
+    const double tx = 0.5 * sx - 0.5, ty = 0.5 * sy - 0.5;
+    const double a = R.at<double>(0, 0) * sx, b = R.at<double>(0, 1) * sy;
+    const double c = R.at<double>(1, 0) * sx, d = R.at<double>(1, 1) * sy;
+    double e = R.at<double>(0, 0) * tx + R.at<double>(0, 1) * ty + R.at<double>(0, 2) + origin.x - roi.x;
+    double f = R.at<double>(1, 0) * tx + R.at<double>(1, 1) * ty + R.at<double>(1, 2) + origin.y - roi.y;
+    
+    // Source pixels that reach the ROI (+1 px for the bilinear taps); a
+    // tile hanging off the canvas only converts and samples what is seen
+    const double det = a * d - b * c;
+    if (std::abs(det) < 1e-12) return;
+    double x0 = 1e300, y0 = 1e300, x1 = -1e300, y1 = -1e300;
+    for (int corner = 0; corner < 4; ++corner) {
+      const double px = (corner & 1) ? roi.width : 0;
+      const double py = (corner & 2) ? roi.height : 0;
+      const double u = ( d * (px - e) - b * (py - f)) / det;
+      const double v = (-c * (px - e) + a * (py - f)) / det;
+      x0 = std::min(x0, u); x1 = std::max(x1, u);
+      y0 = std::min(y0, v); y1 = std::max(y1, v);
+    }
+    const int ux0 = std::max(0, static_cast<int>(std::floor(x0)) - 1);
+    const int uy0 = std::max(0, static_cast<int>(std::floor(y0)) - 1);
+    const int ux1 = std::min(src.cols, static_cast<int>(std::ceil(x1)) + 2);
+    const int uy1 = std::min(src.rows, static_cast<int>(std::ceil(y1)) + 2);
+    if (ux1 <= ux0 || uy1 <= uy0) return;
+    const cv::Rect used(ux0, uy0, ux1 - ux0, uy1 - uy0);
+    e += a * used.x + b * used.y;
+    f += c * used.x + d * used.y;
+    const cv::Mat M = (cv::Mat_<double>(2, 3) << a, b, e, c, d, f);
+    
+    // Canvas order with alpha, so the resampled padding comes out transparent
+    const cv::Mat tile = ToRgba(src(used), imgChannel);
+    
+    const cv::Scalar transparent(0, 0, 0, 0);
+    const cv::Mat warped = OnDevice(GpuOp::MOSAIC, static_cast<double>(roi.area()),
+      [&] {
+        cv::Mat w;
+        cv::warpAffine(tile, w, M, roi.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, transparent);
+        return w;
+      },
+      [&] {
+        cv::UMat w;
+        cv::warpAffine(Upload(tile), w, M, roi.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, transparent);
+        return w;
+      });
+    
+    cv::Mat canvasROI = canvas_(roi);
+    AlphaOver(warped, canvasROI);
   }
   
   // ULTRA-FAST image placement with bounds checking
   void PlaceImageOnCanvas(const cv::Mat& img, const ImageConfig& config, const std::string& imgChannel) {
     if (img.empty()) return;
     
-    // Calculate position - FAST integer operations
-    int x = normalized_ ? static_cast<int>(std::round(config.x * canvasWidth_)) 
-                        : static_cast<int>(std::lround(config.x));
-    int y = normalized_ ? static_cast<int>(std::round(config.y * canvasHeight_)) 
-                        : static_cast<int>(std::lround(config.y));
+    const cv::Point origin = TileOrigin(config);
+    const int x = origin.x, y = origin.y;
     
     // FAST bounds checking with early exit
     if (x >= canvasWidth_ || y >= canvasHeight_) return;
@@ -422,33 +484,12 @@ private:
       }
     }
     
-    // Alpha-aware image placement for transparent rotation padding
-    if (imgToPlace.channels() == 4 && canvasChannel_ == "RGBA") {
-      // Both source and destination have alpha - use proper alpha blending
+    // Alpha-aware image placement for transparent rotation padding.
+    // The canvas starts opaque and "over" keeps it opaque, so the 8-bit
+    // fixed-point SIMD kernel gives the exact straight-alpha result.
+    if (imgToPlace.channels() == 4 && canvas_.channels() == 4) {
       cv::Mat canvasROI = canvas_(dstROI);
-      
-      // Custom alpha blending for maximum control
-      for (int y = 0; y < imgToPlace.rows; ++y) {
-        for (int x = 0; x < imgToPlace.cols; ++x) {
-          cv::Vec4b& srcPixel = imgToPlace.at<cv::Vec4b>(y, x);
-          cv::Vec4b& dstPixel = canvasROI.at<cv::Vec4b>(y, x);
-          
-          float srcAlpha = srcPixel[3] / 255.0f;
-          float dstAlpha = dstPixel[3] / 255.0f;
-          
-          if (srcAlpha > 0.0f) {
-            // Alpha blending formula: dst = src * srcAlpha + dst * (1 - srcAlpha) * dstAlpha
-            float outAlpha = srcAlpha + dstAlpha * (1.0f - srcAlpha);
-            
-            if (outAlpha > 0.0f) {
-              dstPixel[0] = static_cast<uchar>((srcPixel[0] * srcAlpha + dstPixel[0] * dstAlpha * (1.0f - srcAlpha)) / outAlpha);
-              dstPixel[1] = static_cast<uchar>((srcPixel[1] * srcAlpha + dstPixel[1] * dstAlpha * (1.0f - srcAlpha)) / outAlpha);
-              dstPixel[2] = static_cast<uchar>((srcPixel[2] * srcAlpha + dstPixel[2] * dstAlpha * (1.0f - srcAlpha)) / outAlpha);
-              dstPixel[3] = static_cast<uchar>(outAlpha * 255.0f);
-            }
-          }
-        }
-      }
+      AlphaOver(imgToPlace, canvasROI);
     } else {
       // Standard copy operation for non-alpha images
       imgToPlace.copyTo(canvas_(dstROI));
@@ -456,18 +497,21 @@ private:
   }
   
   // Member variables
+  std::vector<InputImage> inputs_;          // Captured on the JS thread
   std::vector<cv::Mat> images_;
   std::vector<std::string> imageChannels_;
   std::vector<ImageConfig> imageConfigs_;
   cv::Mat canvas_;
   std::string canvasChannel_;
+  bool hasRotation_ = false;
   
   int canvasWidth_, canvasHeight_;
   std::string backgroundColor_;
   bool normalized_;
   std::string outputFormat_;
   int quality_;
-  bool pngOptimize_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
   
   double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
   std::vector<uchar> encodedBuf_;
@@ -496,7 +540,9 @@ Napi::Value AdvancedMosaic(const Napi::CallbackInfo& info) {
   // Handle optional parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
   
   if (info.Length() - i >= 2) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -507,7 +553,9 @@ Napi::Value AdvancedMosaic(const Napi::CallbackInfo& info) {
   }
   
   if (info.Length() - i >= 2) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
   
   Napi::Function callback = info[i].As<Napi::Function>();
@@ -519,7 +567,7 @@ Napi::Value AdvancedMosaic(const Napi::CallbackInfo& info) {
   
   // Launch ULTRA-FAST worker
   (new AdvancedMosaicWorker(callback, imagesArray, canvasWidth, canvasHeight, 
-                           backgroundColor, imageConfigs, normalized, outputFormat, quality, pngOptimize))->Queue();
+                           backgroundColor, imageConfigs, normalized, outputFormat, quality, encodeOpts, std::move(outTarget)))->Queue(job);
   
   return env.Undefined();
 }
\ No newline at end of file
@@ -0,0 +1,402 @@
+// ───────── src/batch.cpp ─────────────────────────────────────────────────
+// Batch entry points: one engine worker per JS call, cv::parallel_for_ over the
+// images. Same parameters as the single-image bindings, but the first argument
+// is an array and the result is { images, timing, timings }.
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "ops.h"
+
+// Applies one operation to one decoded image. `channel` comes in as the
+// input channel order and must leave as the result's.
+using BatchOp = std::function<cv::Mat(const InputImage&, std::string& channel)>;
+// Decodes one input on the worker thread and returns convertMs
+using BatchDecode = std::function<double(InputImage&)>;
+// Optional per-image metadata returned next to `images` (JS thread, after
+// the job; the decoded input is still available)
+using BatchMeta = std::function<Napi::Value(Napi::Env, const InputImage&)>;
+
+/*────────────────────────── Worker ───────────────────────────────────*/
+class BatchWorker final : public EngineWorker {
+public:
+  BatchWorker(Napi::Function cb,
+              const char* opName,
+              const Napi::Array& images,
+              BatchOp op,
+              BatchDecode decode,
+              std::string outputFormat,
+              int quality = 90,
+              EncodeOptions encodeOpts = {},
+              const Napi::Value& optsVal = Napi::Value())
+    : EngineWorker(cb, opName),
+      op_(std::move(op)),
+      decode_(std::move(decode)),
+      outputFormat_(std::move(outputFormat)),
+      quality_(quality),
+      encodeOpts_(std::move(encodeOpts)),
+      tensor_(outputFormat_ == "tensor")
+  {
+    const uint32_t n = images.Length();
+    inputs_.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) inputs_.push_back(PrepareInput(images.Get(i)));
+
+    results_.resize(n);
+    channels_.resize(n);
+    encoded_.resize(n);
+    timings_.resize(n);
+    outs_ = ParseOutputTargets(optsVal, n);       // options.out: Buffer per image
+  }
+
+  // Adds result[key] = [meta(input) for each image]
+  void SetMeta(const char* key, BatchMeta meta) {
+    metaKey_ = key;
+    meta_ = std::move(meta);
+  }
+
+protected:
+  void Execute() override {
+    const int64 w0 = cv::getTickCount();
+    const int n = static_cast<int>(inputs_.size());
+    std::vector<std::string> errors(n);
+    JobCounters* counters = JobCounters::Current();
+
+    // Nested parallel_for_ calls inside the ops run serially, so the batch
+    // level is the only one that fans out.
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range& r) {
+      JobCountersScope scope(counters);
+      for (int i = r.start; i < r.end; ++i) {
+        try {
+          ProcessOne(i);
+        } catch (const std::exception& e) {
+          errors[i] = e.what();
+        }
+      }
+    });
+
+    for (int i = 0; i < n; ++i) {
+      if (!errors[i].empty()) {
+        CheckJob("encoding");
+        throw std::runtime_error("Image " + std::to_string(i) + ": " + errors[i]);
+      }
+    }
+    if (tensor_) WriteTensorBatch();
+    wallMs_ = (cv::getTickCount() - w0) / cv::getTickFrequency() * 1e3;
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    const uint32_t n = static_cast<uint32_t>(inputs_.size());
+
+    Napi::Array images  = Napi::Array::New(env, n);
+    Napi::Array timings = Napi::Array::New(env, n);
+    double convertMs = 0.0, taskMs = 0.0, encodeMs = 0.0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      if (!tensor_) images.Set(i, outs_[i].ToJS(env, outputFormat_, results_[i], channels_[i], encoded_[i]));
+
+      const Timing& t = timings_[i];
+      timings.Set(i, MakeTimingJS(env, t.convertMs, t.taskMs, t.encodeMs));
+      convertMs += t.convertMs;
+      taskMs    += t.taskMs;
+      encodeMs  += t.encodeMs;
+    }
+
+    // Aggregate = per-image sums (what the nodes already add up) + wall time
+    Napi::Object timing = TimingJS(convertMs, taskMs, encodeMs);
+    timing.Set("wallMs", Napi::Number::New(env, wallMs_));
+
+    Napi::Object out = Napi::Object::New(env);
+    if (tensor_) {
+      const cv::Size size = n ? results_[0].size() : cv::Size();
+      out.Set("tensor", TensorJS(env, MatToBuffer(env, blob_), static_cast<int>(n),
+                                 size, encodeOpts_.tensor));
+    } else {
+      out.Set("images", images);
+    }
+    out.Set("timing",  timing);
+    out.Set("timings", timings);
+    if (n) outs_[0].AttachPreview(out);
+    if (meta_) {
+      Napi::Array meta = Napi::Array::New(env, n);
+      for (uint32_t i = 0; i < n; ++i) meta.Set(i, meta_(env, inputs_[i]));
+      out.Set(metaKey_, meta);
+    }
+    Callback().Call({ env.Null(), out });
+  }
+
+  void OnError(const Napi::Error& e) override {
+    Callback().Call({ e.Value(), Env().Null() });
+  }
+
+private:
+  struct Timing { double convertMs = 0.0, taskMs = 0.0, encodeMs = 0.0; };
+
+  void ProcessOne(int i) {
+    Timing& t = timings_[i];
+    t.convertMs = decode_ ? decode_(inputs_[i]) : DecodeInput(inputs_[i]);
+
+    const int64 t0 = cv::getTickCount();
+    channels_[i] = inputs_[i].colorSpace;
+    results_[i]  = op_(inputs_[i], channels_[i]);
+    t.taskMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+
+    if (tensor_) {                      // written into the batch blob afterwards
+      outs_[i].Preview(results_[i], channels_[i]);
+      return;
+    }
+    if (outputFormat_ != "raw") {
+      t.encodeMs = EncodeImage(results_[i], channels_[i], encoded_[i],
+                               outputFormat_, quality_, encodeOpts_);
+    }
+    outs_[i].Capture(outputFormat_, results_[i], encoded_[i], channels_[i]);
+  }
+
+  // outputFormat "tensor": every result goes straight into its slice of one
+  // contiguous N×C×H×W blob (all results must share a size)
+  void WriteTensorBatch() {
+    const int n = static_cast<int>(results_.size());
+    if (n == 0) return;
+    const cv::Size size = results_[0].size();
+    for (int i = 1; i < n; ++i) {
+      if (results_[i].size() != size) {
+        throw std::runtime_error("tensor output needs equal sizes: image " + std::to_string(i) + " is " +
+                                 std::to_string(results_[i].cols) + "x" + std::to_string(results_[i].rows) +
+                                 ", image 0 is " + std::to_string(size.width) + "x" + std::to_string(size.height));
+      }
+    }
+    const size_t slice = encodeOpts_.tensor.Bytes(size);
+    blob_.create(1, static_cast<int>(slice * n), CV_8U);
+    std::vector<std::string> errors(n);
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range& r) {
+      JobCountersScope scope(counters);
+      for (int i = r.start; i < r.end; ++i) {
+        try {
+          timings_[i].encodeMs = EncodeTensor(results_[i], channels_[i], blob_.data + slice * i,
+                                              encodeOpts_.tensor);
+        } catch (const std::exception& e) {
+          errors[i] = e.what();
+        }
+      }
+    });
+    for (int i = 0; i < n; ++i) {
+      if (!errors[i].empty()) {
+        CheckJob("encoding");
+        throw std::runtime_error("Image " + std::to_string(i) + ": " + errors[i]);
+      }
+    }
+    CountOutput(slice * n);
+  }
+
+  std::vector<InputImage> inputs_;
+  BatchOp op_;
+  BatchDecode decode_;                  // empty → plain DecodeInput()
+  const char* metaKey_ = nullptr;
+  BatchMeta meta_;                      // empty → no metadata array
+
+  std::string outputFormat_;
+  int quality_;
+  EncodeOptions encodeOpts_;
+  bool tensor_;                         // one NCHW blob instead of per-image buffers
+  cv::Mat blob_;
+
+  std::vector<cv::Mat> results_;
+  std::vector<std::string> channels_;
+  std::vector<std::vector<uchar>> encoded_;
+  std::vector<OutputTarget> outs_;
+  std::vector<Timing> timings_;
+  double wallMs_{0.0};
+};
+
+/*────────────────────────── helpers ──────────────────────────────────*/
+// Reads [outputFormat], [quality], [pngOptimize] starting at `i`; the last
+// argument is always the callback. Returns the callback. `optsVal` is the
+// raw options slot (for `out`), undefined when absent.
+static Napi::Function ParseOutputArgs(const Napi::CallbackInfo& info, int i,
+                                      std::string& outputFormat, int& quality,
+                                      EncodeOptions& encodeOpts, Napi::Value& optsVal)
+{
+  if (info.Length() - i >= 2) {
+    outputFormat = info[i++].As<Napi::String>().Utf8Value();
+  }
+  if (info.Length() - i >= 2) {
+    quality = info[i++].As<Napi::Number>().Int32Value();
+  }
+  if (info.Length() - i >= 2) {
+    optsVal = info[i];
+    encodeOpts = ParseEncodeOptions(info[i++]);
+  }
+  return info[i].As<Napi::Function>();
+}
+
+static bool CheckBatchArgs(const Napi::CallbackInfo& info, size_t minArgs,
+                           size_t maxArgs, const char* usage)
+{
+  if (info.Length() < minArgs || info.Length() > maxArgs || !info[0].IsArray() ||
+      !info[info.Length()-1].IsFunction()) {
+    Napi::TypeError::New(info.Env(), usage).ThrowAsJavaScriptException();
+    return false;
+  }
+  return true;
+}
+
+static void QueueBatch(const Napi::CallbackInfo& info, const char* opName,
+                       int optStart, BatchOp op,
+                       BatchDecode decode = nullptr,
+                       const char* metaKey = nullptr, BatchMeta meta = nullptr)
+{
+  std::string outputFormat = "raw";
+  int quality = 90;
+  EncodeOptions encodeOpts;
+  Napi::Value optsVal = info.Env().Undefined();
+  Napi::Function cb = ParseOutputArgs(info, optStart, outputFormat, quality, encodeOpts, optsVal);
+
+  auto* worker = new BatchWorker(cb, opName, info[0].As<Napi::Array>(), std::move(op), std::move(decode),
+                                 outputFormat, quality, encodeOpts, optsVal);
+  if (meta) worker->SetMeta(metaKey, std::move(meta));
+  worker->Queue(ParseJobOptions(optsVal));
+}
+
+// Options slot of a batch call (the argument before the callback), if given
+static Napi::Value BatchOptions(const Napi::CallbackInfo& info, int optStart)
+{
+  return info.Length() - optStart >= 4 ? info[info.Length() - 2] : info.Env().Undefined();
+}
+
+/*──────── resizeBatch(images, widthMode, widthVal, heightMode, heightVal, [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value ResizeBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 6, 9,
+      "resizeBatch(images, widthMode, widthVal, heightMode, heightVal, [outputFormat], [quality], [pngOptimize], callback)"))
+    return env.Null();
+
+  ResizeParams p;
+  p.widthMode   = info[1].As<Napi::String>().Utf8Value();
+  p.widthValue  = info[2].As<Napi::Number>().DoubleValue();
+  p.heightMode  = info[3].As<Napi::String>().Utf8Value();
+  p.heightValue = info[4].As<Napi::Number>().DoubleValue();
+
+  // JPEGs shrunk ≥2× are decoded with DCT scaling; the target is still
+  // resolved against the full-resolution size
+  QueueBatch(info, "resizeBatch", 5,
+    [p](const InputImage& in, std::string&) {
+      return ApplyResize(in.mat, p, in.sourceSize);
+    },
+    [p](InputImage& in) { return DecodeForResize(in, p); });
+  return env.Undefined();
+}
+
+/*──────── rotateBatch(images, angleDeg, [padColor], [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value RotateBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 3, 7,
+      "rotateBatch(images, angleDeg, [padColor], [outputFormat], [quality], [pngOptimize], callback)"))
+    return env.Null();
+
+  int i = 1;
+  RotateParams p;
+  p.angleDeg = info[i++].As<Napi::Number>().DoubleValue();
+
+  std::string padColorStr = "#000000";      // negro por defecto
+  if (info[i].IsString()) padColorStr = info[i++].As<Napi::String>();
+  p.padColor = ParseColor(padColorStr);
+
+  QueueBatch(info, "rotateBatch", i, [p](const InputImage& in, std::string& channel) {
+    return ApplyRotate(in.mat, channel, p);
+  });
+  return env.Undefined();
+}
+
+/*──────── filterBatch(images, filterType, kernelSize, intensity, [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value FilterBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 5, 8,
+      "filterBatch(images, filterType, kernelSize, intensity, [outputFormat], [quality], [pngOptimize], callback)"))
+    return env.Null();
+
+  FilterParams p;
+  p.type       = info[1].As<Napi::String>().Utf8Value();
+  p.kernelSize = info[2].As<Napi::Number>().Int32Value();
+  p.intensity  = info[3].As<Napi::Number>().DoubleValue();
+
+  QueueBatch(info, "filterBatch", 4, [p](const InputImage& in, std::string&) {
+    return ApplyFilter(in.mat, p);
+  });
+  return env.Undefined();
+}
+
+/*──────── cropBatch(images, x, y, width, height, normalized, [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value CropBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 7, 10,
+      "cropBatch(images, x, y, width, height, normalized, [outputFormat], [quality], [pngOptimize], callback)"))
+    return env.Null();
+
+  CropParams p;
+  p.x          = info[1].As<Napi::Number>().DoubleValue();
+  p.y          = info[2].As<Napi::Number>().DoubleValue();
+  p.width      = info[3].As<Napi::Number>().DoubleValue();
+  p.height     = info[4].As<Napi::Number>().DoubleValue();
+  p.normalized = info[5].As<Napi::Boolean>().Value();
+
+  QueueBatch(info, "cropBatch", 6, [p](const InputImage& in, std::string&) {
+    return ApplyCrop(in.mat, p);               // view; MatToRawJS clones if needed
+  });
+  return env.Undefined();
+}
+
+/*──────── paddingBatch(images, top, bottom, left, right, padHex, [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value PaddingBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 7, 10,
+      "paddingBatch(images, top, bottom, left, right, padHex, [outputFormat], [quality], [pngOptimize], callback)"))
+    return env.Null();
+
+  PaddingParams p;
+  p.top      = info[1].As<Napi::Number>().Int32Value();
+  p.bottom   = info[2].As<Napi::Number>().Int32Value();
+  p.left     = info[3].As<Napi::Number>().Int32Value();
+  p.right    = info[4].As<Napi::Number>().Int32Value();
+  p.padColor = ParseColor(info[5].As<Napi::String>());
+
+  QueueBatch(info, "paddingBatch", 6, [p](const InputImage& in, std::string& channel) {
+    return ApplyPadding(in.mat, channel, p);
+  });
+  return env.Undefined();
+}
+
+/*──────── letterboxBatch(images, width, height, padHex, align, [outputFormat], [quality], [options], callback) ─*/
+Napi::Value LetterboxBatch(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (!CheckBatchArgs(info, 6, 9,
+      "letterboxBatch(images, width, height, padHex, align, [outputFormat], [quality], [options], callback)"))
+    return env.Null();
+
+  LetterboxParams p;
+  p.width  = info[1].As<Napi::Number>().Int32Value();
+  p.height = info[2].As<Napi::Number>().Int32Value();
+  if (info[3].IsString()) p.padColor = ParseColor(info[3].As<Napi::String>());
+  if (info[4].IsString()) p.align = info[4].As<Napi::String>().Utf8Value();
+  p.scaleUp = ParseLetterboxScaleUp(BatchOptions(info, 5));
+
+  // result.letterbox[i] maps boxes of images[i] back to its source
+  QueueBatch(info, "letterboxBatch", 5,
+    [p](const InputImage& in, std::string& channel) {
+      return ApplyLetterbox(in.mat, channel, p, in.sourceSize);
+    },
+    [p](InputImage& in) { return DecodeForLetterbox(in, p); },
+    "letterbox",
+    [p](Napi::Env env, const InputImage& in) -> Napi::Value {
+      return LetterboxInfoJS(env, ResolveLetterbox(in.sourceSize, p));
+    });
+  return env.Undefined();
+}
@@ -1,6 +1,9 @@
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include "utils.h"
+#include "ops.h"
+#include "compositing/alpha-blend.h"
+#include "runtime/device.h"
 
 
 // Helper function to determine the best output channel format from two inputs
@@ -13,9 +16,139 @@ std::string DetermineOutputFormat(const std::string& format1, const std::string&
   return "GRAY";
 }
 
+/*──────────────────────── core op (shared with pipeline) ───────────────*/
+cv::Mat ApplyBlend(const cv::Mat& a, const std::string& formatA,
+                   const cv::Mat& b, const std::string& formatB,
+                   double opacity, std::string& outChannel) {
+  outChannel = DetermineOutputFormat(formatA, formatB);
+
+  // Convert both images to the same target format
+  cv::Mat img1 = ConvertToTargetFormatShared(a, formatA, outChannel);
+  cv::Mat img2 = ConvertToTargetFormatShared(b, formatB, outChannel);
+  
+  // Ensure both images have the same dimensions (resize smaller to match larger)
+  const cv::Size targetSize(std::max(img1.cols, img2.cols), std::max(img1.rows, img2.rows));
+
+  // Blend the images using addWeighted
+  // Formula: result = img1 * opacity + img2 * (1 - opacity)
+  // (on the OpenCL device, resizes included, for large frames)
+  return OnDevice(GpuOp::BLEND, static_cast<double>(targetSize.area()),
+    [&] {
+      if (img1.size() != targetSize) cv::resize(img1, img1, targetSize);
+      if (img2.size() != targetSize) cv::resize(img2, img2, targetSize);
+      cv::Mat result;
+      cv::addWeighted(img1, opacity, img2, 1.0 - opacity, 0.0, result);
+      return result;
+    },
+    [&] {
+      cv::UMat u1 = Upload(img1), u2 = Upload(img2), result;
+      if (u1.size() != targetSize) cv::resize(u1, u1, targetSize);
+      if (u2.size() != targetSize) cv::resize(u2, u2, targetSize);
+      cv::addWeighted(u1, opacity, u2, 1.0 - opacity, 0.0, result);
+      return result;
+    });
+}
+
+namespace {
+
+cv::Mat ToGray(const cv::Mat& src, const std::string& format) {
+  if (src.channels() == 1) return src;
+  cv::Mat gray;
+  if (format == "RGB")       cv::cvtColor(src, gray, cv::COLOR_RGB2GRAY);
+  else if (format == "RGBA") cv::cvtColor(src, gray, cv::COLOR_RGBA2GRAY);
+  else if (src.channels() == 4) cv::cvtColor(src, gray, cv::COLOR_BGRA2GRAY);
+  else                       cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+  return gray;
+}
+
+// 8-bit weight of every overlay pixel in `ovRect` (overlay coordinates)
+cv::Mat OverlayWeights(const cv::Mat& overlay, const cv::Rect& ovRect,
+                       const cv::Mat& mask, double opacity) {
+  const cv::Mat ov = overlay(ovRect);
+  cv::Mat alpha;
+  if (ov.channels() == 4) cv::extractChannel(ov, alpha, 3);
+  else alpha = cv::Mat(ov.size(), CV_8UC1, cv::Scalar(255));
+
+  if (!mask.empty()) {
+    cv::Mat m = mask;
+    if (m.channels() == 4)      cv::extractChannel(m, m, 3);
+    else if (m.channels() == 3) cv::cvtColor(m, m, cv::COLOR_BGR2GRAY);
+    if (m.size() != overlay.size()) cv::resize(m, m, overlay.size(), 0, 0, cv::INTER_LINEAR);
+    cv::multiply(alpha, m(ovRect), alpha, opacity / 255.0);
+  } else if (opacity < 1.0) {
+    alpha.convertTo(alpha, CV_8U, opacity);
+  }
+  return alpha;
+}
+
+}  // namespace
+
+cv::Mat ApplyPlaceBlend(const cv::Mat& base, const std::string& baseFormat,
+                        const cv::Mat& overlay, const std::string& overlayFormat,
+                        const cv::Mat& mask, const PlaceBlendParams& p,
+                        bool baseOwned) {
+  if (base.depth() != CV_8U || overlay.depth() != CV_8U ||
+      (!mask.empty() && mask.depth() != CV_8U)) {
+    throw std::runtime_error("Blend placement supports 8-bit images only");
+  }
+
+  cv::Mat result = baseOwned ? base : base.clone();
+  const cv::Rect target = cv::Rect(p.x, p.y, overlay.cols, overlay.rows) &
+                          cv::Rect(0, 0, base.cols, base.rows);
+  if (target.empty() || p.opacity <= 0.0) return result;
+
+  // Only the visible part of the overlay is converted and weighted
+  const cv::Rect ovRect(target.x - p.x, target.y - p.y, target.width, target.height);
+  const cv::Mat alpha = OverlayWeights(overlay, ovRect, mask, p.opacity);
+  cv::Mat dst = result(target);
+
+  if (result.channels() == 1) {
+    AlphaOverGray(ToGray(overlay(ovRect), overlayFormat), alpha, dst);
+    return result;
+  }
+
+  // Overlay in the base's channel order plus an alpha channel (the weights)
+  const std::string order = result.channels() == 4 ? baseFormat : baseFormat + "A";
+  cv::Mat ov4 = ConvertToTargetFormatShared(overlay(ovRect), overlayFormat, order);
+  if (ov4.channels() != 4) {
+    throw std::runtime_error("Blend placement: cannot convert " + overlayFormat + " to " + order);
+  }
+  if (ov4.datastart == overlay.datastart) ov4 = ov4.clone();   // still a view of the input
+  cv::insertChannel(alpha, ov4, 3);
+  AlphaOver(ov4, dst);
+  return result;
+}
+
 
 /*------------------------------------------------------------------------*/
-class BlendWorker final : public Napi::AsyncWorker {
+// options.mode "place" (or any of x / y / mask): image1 is an overlay put at
+// (x, y) on image2 at native size; default "stretch" keeps the full-frame blend
+struct BlendPlacement {
+  bool enabled = false;
+  int x = 0, y = 0;
+  Napi::Value mask;
+};
+
+static BlendPlacement ParseBlendPlacement(const Napi::Value& optsVal) {
+  BlendPlacement pl;
+  if (!optsVal.IsObject() || optsVal.IsBuffer()) return pl;
+  Napi::Object o = optsVal.As<Napi::Object>();
+
+  auto given = [&](const char* key) {
+    return o.Has(key) && !o.Get(key).IsUndefined() && !o.Get(key).IsNull();
+  };
+  const std::string mode = given("mode") && o.Get("mode").IsString()
+      ? o.Get("mode").As<Napi::String>().Utf8Value() : "";
+  pl.enabled = mode == "place" || (mode != "stretch" && (given("x") || given("y") || given("mask")));
+  if (!pl.enabled) return pl;
+
+  if (given("x")) pl.x = static_cast<int>(std::lround(o.Get("x").ToNumber().DoubleValue()));
+  if (given("y")) pl.y = static_cast<int>(std::lround(o.Get("y").ToNumber().DoubleValue()));
+  if (given("mask")) pl.mask = o.Get("mask");
+  return pl;
+}
+
+class BlendWorker final : public EngineWorker {
 public:
   BlendWorker(Napi::Function cb,
               const Napi::Value& jsImg1,
@@ -23,83 +156,83 @@ public:
               double opacity,
               std::string outputFormat,
               int quality = 90,
-              bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+              EncodeOptions encodeOpts = {},
+              OutputTarget outTarget = OutputTarget(),
+              const BlendPlacement& placement = BlendPlacement())
+    : EngineWorker(cb, "blend"),
       opacity(opacity),
+      place(placement.enabled),
+      placeX(placement.x), placeY(placement.y),
       outputFormat(std::move(outputFormat)),
-      quality(quality), pngOptimize(pngOptimize)
+      quality(quality), encodeOpts(encodeOpts),
+      outTarget(std::move(outTarget))
   {
-    // Timing and conversion
-    const int64 t0 = cv::getTickCount();
-    
-    // Convert JavaScript inputs to OpenCV Mats
-    mat1 = ConvertToMat(jsImg1);
-    mat2 = ConvertToMat(jsImg2);
-    
-    // Detect channel formats
-    format1 = DetectChannelFormatShared(jsImg1, mat1);
-    format2 = DetectChannelFormatShared(jsImg2, mat2);
-    
-    // Determine output channel format
-    outputChannel = DetermineOutputFormat(format1, format2);
-    
-    convertMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+    // Wrap inputs only; decoding happens on the worker thread
+    inputs.reserve(3);
+    inputs.push_back(PrepareInput(jsImg1));
+    inputs.push_back(PrepareInput(jsImg2));
+    if (place && !placement.mask.IsEmpty() && placement.mask.IsObject()) {
+      inputs.push_back(PrepareInput(placement.mask));
+    }
   }
 
 protected:
   void Execute() override {
+    // A decoded base is ours and can be written in place (unless the
+    // decode cache shares it with other jobs)
+    const bool baseEncoded = inputs[1].IsEncoded();
+
+    // Decode all inputs (in parallel when several are encoded)
+    convertMs = DecodeInputs(inputs);
+    const bool baseOwned = baseEncoded && !inputs[1].shared;
+    mat1 = inputs[0].mat;
+    mat2 = inputs[1].mat;
+    format1 = inputs[0].colorSpace;
+    format2 = inputs[1].colorSpace;
+
     const int64 t0 = cv::getTickCount();
     
-    // Convert both images to the same target format
-    cv::Mat img1 = ConvertToTargetFormatShared(mat1, format1, outputChannel);
-    cv::Mat img2 = ConvertToTargetFormatShared(mat2, format2, outputChannel);
-    
-    // Ensure both images have the same dimensions (resize smaller to match larger)
-    cv::Size targetSize;
-    if (img1.size() != img2.size()) {
-      // Use the larger dimensions
-      targetSize.width = std::max(img1.cols, img2.cols);
-      targetSize.height = std::max(img1.rows, img2.rows);
-      
-      if (img1.size() != targetSize) {
-        cv::resize(img1, img1, targetSize);
-      }
-      if (img2.size() != targetSize) {
-        cv::resize(img2, img2, targetSize);
-      }
+    if (place) {
+      // Overlay (image1) at (x, y) on the base (image2); output keeps the base's layout
+      const cv::Mat mask = inputs.size() > 2 ? inputs[2].mat : cv::Mat();
+      result = ApplyPlaceBlend(mat2, format2, mat1, format1, mask,
+                               { placeX, placeY, opacity }, baseOwned);
+      outputChannel = format2;
+    } else {
+      result = ApplyBlend(mat1, format1, mat2, format2, opacity, outputChannel);
     }
     
-    // Blend the images using addWeighted
-    // Formula: result = img1 * opacity + img2 * (1 - opacity)
-    cv::addWeighted(img1, opacity, img2, 1.0 - opacity, 0.0, result);
-    
     taskMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
 
     // Multi-format encoding if needed
     if (outputFormat != "raw") {
-      cv::Mat tmp = ToBgrForJpg(result, outputChannel);
-      encodeMs = EncodeToFormat(tmp, encodedBuf, outputFormat, quality, pngOptimize);
+      encodeMs = EncodeImage(result, outputChannel, encodedBuf, outputFormat, quality, encodeOpts);
     }
+    outTarget.Capture(outputFormat, result, encodedBuf, outputChannel);
   }
 
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value jsImg = (outputFormat != "raw") ? VectorToBuffer(env, std::move(encodedBuf))
-                                                : MatToRawJS(env, result, outputChannel);
+    Napi::Value jsImg = outTarget.ToJS(env, outputFormat, result, outputChannel, encodedBuf);
 
     Napi::Object out = Napi::Object::New(env);
     out.Set("image", jsImg);
-    out.Set("timing", MakeTimingJS(env, convertMs, taskMs, encodeMs));
+    out.Set("timing", TimingJS(convertMs, taskMs, encodeMs));
+    outTarget.AttachPreview(out);
     Callback().Call({env.Null(), out});
   }
 
 private:
+  std::vector<InputImage> inputs;
   cv::Mat mat1, mat2, result;
   std::string format1, format2, outputChannel;
   double opacity;
+  bool place;
+  int placeX, placeY;
   std::string outputFormat;
   int quality;
-  bool pngOptimize;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
   double convertMs = 0, taskMs = 0, encodeMs = 0;
   std::vector<uchar> encodedBuf;
 };
@@ -110,7 +243,7 @@ Napi::Value Blend(const Napi::CallbackInfo& info) {
   
   // Fast parameter validation
   if (info.Length() < 4 || info.Length() > 7 || !info[info.Length() - 1].IsFunction()) {
-    Napi::TypeError::New(env, "blend(image1, image2, opacity, [outputFormat], [quality], [pngOptimize], callback)")
+    Napi::TypeError::New(env, "blend(image1, image2, opacity, [outputFormat], [quality], [options], callback)")
       .ThrowAsJavaScriptException();
     return env.Null();
   }
@@ -126,7 +259,10 @@ Napi::Value Blend(const Napi::CallbackInfo& info) {
   // Handle optional parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  BlendPlacement placement;
+  JobOptions job;
   size_t cbIdx = 3;
   
   if (info.Length() >= 5) {
@@ -140,11 +276,14 @@ Napi::Value Blend(const Napi::CallbackInfo& info) {
   }
   
   if (info.Length() == 7) {
-    pngOptimize = info[5].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[5]);
+    job        = ParseJobOptions(info[5]);
+    outTarget  = ParseOutputTarget(info[5]);
+    placement  = ParseBlendPlacement(info[5]);
     cbIdx = 6;
   }
 
   // Create and queue worker
-  (new BlendWorker(info[cbIdx].As<Napi::Function>(), jsImg1, jsImg2, opacity, outputFormat, quality, pngOptimize))->Queue();
+  (new BlendWorker(info[cbIdx].As<Napi::Function>(), jsImg1, jsImg2, opacity, outputFormat, quality, encodeOpts, std::move(outTarget), placement))->Queue(job);
   return env.Undefined();
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+// Fichero: src/cancel-token.cpp
+//
+// CancelToken handles (src/runtime/cancel-token.h).
+#include <napi.h>
+#include <memory>
+#include "runtime/cancel-token.h"
+#include "runtime/worker-pool.h"
+
+void CancelToken::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function ctor = DefineClass(env, "CancelToken", {
+    InstanceMethod("cancel",        &CancelToken::Cancel),
+    InstanceAccessor("cancelled",   &CancelToken::GetCancelled, nullptr),
+  });
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  data->cancelToken = Napi::Persistent(ctor);
+  exports.Set("CancelToken", ctor);
+}
+
+std::shared_ptr<CancelState> CancelToken::FromValue(const Napi::Value& v) {
+  if (!v.IsObject()) return nullptr;
+  AddonData* data = v.Env().GetInstanceData<AddonData>();
+  if (!data || data->cancelToken.IsEmpty()) return nullptr;
+  Napi::Object obj = v.As<Napi::Object>();
+  if (!obj.InstanceOf(data->cancelToken.Value())) return nullptr;
+  return Unwrap(obj)->state_;
+}
+
+CancelToken::CancelToken(const Napi::CallbackInfo& info)
+  : Napi::ObjectWrap<CancelToken>(info), state_(std::make_shared<CancelState>()) {}
+
+Napi::Value CancelToken::Cancel(const Napi::CallbackInfo& info) {
+  state_->cancelled = true;
+  return info.Env().Undefined();
+}
+
+Napi::Value CancelToken::GetCancelled(const Napi::CallbackInfo& info) {
+  return Napi::Boolean::New(info.Env(), state_->cancelled.load());
+}
@@ -0,0 +1,216 @@
+// Fichero: src/codecs/decode-cache.h
+//
+// LRU cache of decoded images for fan-out flows: one encoded Buffer wired to
+// several nodes (crop, thumbnail, mosaic, blend…) is decoded once.
+// - Key: byte length + 64-bit hash of the whole content + imdecode flags
+//   (DCT-reduced decodes are separate entries). Node-RED clones Buffers when
+//   a message goes to several wires, so the key is the content, not the
+//   Buffer's address. The hash reads 32 bytes per step (four 64-bit lanes),
+//   far below the cost of the decode it saves.
+// - Concurrent requests for the same key are coalesced: the first thread
+//   decodes, the others wait for its result.
+// - Budget: ROSEPETAL_DECODE_CACHE_MB (default 128, 0 disables) and at most
+//   kMaxEntries; frames larger than a quarter of the budget are not kept.
+// Cached Mats are shared by every job that hits them and must be treated as
+// read-only; MatToBuffer copies instead of aliasing them into JS.
+
+#ifndef DECODE_CACHE_H
+#define DECODE_CACHE_H
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// 64-bit content hash (xxHash64-style lanes and avalanche)
+inline uint64_t ContentHash(const uchar* p, size_t n) {
+  constexpr uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full,
+                     P3 = 0x165667B19E3779F9ull;
+  auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+  auto round = [&](uint64_t acc, uint64_t in) { return rotl(acc + in * P2, 31) * P1; };
+
+  uint64_t v[4] = { P1 + P2, P2, 0, 0 - P1 };
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    for (int k = 0; k < 4; ++k) {
+      uint64_t w;
+      std::memcpy(&w, p + i + 8 * k, 8);
+      v[k] = round(v[k], w);
+    }
+  }
+  uint64_t h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18) + n;
+  for (; i < n; ++i) h = rotl(h ^ (p[i] * P3), 11) * P1;
+
+  h ^= h >> 33; h *= P2;
+  h ^= h >> 29; h *= P3;
+  h ^= h >> 32;
+  return h;
+}
+
+class DecodeCache {
+public:
+  static constexpr size_t kMaxEntries = 32;
+
+  struct Stats {
+    uint64_t hits = 0, misses = 0;
+    uint64_t coalesced = 0;     // hits that waited for another thread's decode
+    uint64_t bypassed = 0;      // decoded but too large to keep
+    size_t entries = 0, bytes = 0, budget = 0;
+  };
+
+  static DecodeCache& Instance() {
+    static DecodeCache* cache = new DecodeCache();
+    return *cache;
+  }
+
+  // Decoded image of `p[0..n)`: cached, coalesced with a decode already
+  // running, or `decode()` on this thread. `hit` tells which.
+  cv::Mat Get(const uchar* p, size_t n, int flags, bool& hit,
+              const std::function<cv::Mat()>& decode) {
+    hit = false;
+    if (budget_ == 0) return decode();
+
+    const Key key{ n, ContentHash(p, n), flags };
+    std::shared_ptr<Pending> pending;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto it = index_.find(key);
+      if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        ++stats_.hits;
+        hit = true;
+        return it->second->mat;
+      }
+      auto pit = pending_.find(key);
+      if (pit != pending_.end()) {
+        pending = pit->second;
+        ++stats_.hits;
+        ++stats_.coalesced;
+        done_.wait(lock, [&] { return pending->done; });
+        hit = true;
+        return pending->mat;                  // empty if that decode failed
+      }
+      pending = std::make_shared<Pending>();
+      pending_[key] = pending;
+      ++stats_.misses;
+    }
+
+    cv::Mat mat;
+    try {
+      mat = decode();
+    } catch (...) {
+      Finish(key, *pending, cv::Mat());
+      throw;
+    }
+    Finish(key, *pending, mat);
+    return mat;
+  }
+
+  // Cached image of `p[0..n)` without decoding: empty on a miss (and while
+  // another thread is still decoding it). Counts a hit only.
+  cv::Mat Peek(const uchar* p, size_t n, int flags) {
+    if (budget_ == 0) return cv::Mat();
+    const Key key{ n, ContentHash(p, n), flags };
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) return cv::Mat();
+    lru_.splice(lru_.begin(), lru_, it->second);
+    ++stats_.hits;
+    return it->second->mat;
+  }
+
+  bool Enabled() const { return budget_ != 0; }
+
+  // True when `m` shares pixels with a cached image
+  bool Holds(const cv::Mat& m) const {
+    if (!m.u || budget_ == 0) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return held_.count(m.u) != 0;
+  }
+
+  Stats GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    s.entries = lru_.size();
+    s.budget = budget_;
+    return s;
+  }
+
+private:
+  struct Key {
+    size_t length;
+    uint64_t hash;
+    int flags;
+    bool operator==(const Key& o) const {
+      return length == o.length && hash == o.hash && flags == o.flags;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& k) const {
+      return static_cast<size_t>(k.hash ^ (uint64_t(k.flags) << 48));
+    }
+  };
+
+  struct Entry {
+    Key key;
+    cv::Mat mat;
+    size_t Bytes() const { return mat.total() * mat.elemSize(); }
+  };
+
+  struct Pending {
+    bool done = false;
+    cv::Mat mat;
+  };
+
+  DecodeCache() {
+    const char* v = std::getenv("ROSEPETAL_DECODE_CACHE_MB");
+    const long mb = (v && *v) ? std::strtol(v, nullptr, 10) : 128;
+    budget_ = mb > 0 ? size_t(mb) << 20 : 0;
+  }
+
+  // Publishes a finished decode to its waiters and, if it fits, the LRU
+  void Finish(const Key& key, Pending& pending, const cv::Mat& mat) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending.mat = mat;
+      pending.done = true;
+      pending_.erase(key);
+
+      const size_t bytes = mat.total() * mat.elemSize();
+      if (!mat.empty() && bytes > budget_ / 4) {
+        ++stats_.bypassed;
+      } else if (!mat.empty()) {
+        lru_.push_front({ key, mat });
+        index_[key] = lru_.begin();
+        held_.insert(mat.u);
+        stats_.bytes += bytes;
+        while (lru_.size() > kMaxEntries || stats_.bytes > budget_) {
+          stats_.bytes -= lru_.back().Bytes();
+          held_.erase(lru_.back().mat.u);
+          index_.erase(lru_.back().key);
+          lru_.pop_back();
+        }
+      }
+    }
+    done_.notify_all();
+  }
+
+  size_t budget_ = 0;
+  mutable std::mutex mutex_;
+  std::condition_variable done_;
+  std::list<Entry> lru_;                               // front = most recent
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  std::unordered_map<Key, std::shared_ptr<Pending>, KeyHash> pending_;
+  std::unordered_set<const cv::UMatData*> held_;       // pixels of cached Mats
+  Stats stats_;
+};
+
+#endif // DECODE_CACHE_H
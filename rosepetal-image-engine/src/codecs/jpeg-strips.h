@@ -0,0 +1,238 @@
+// Fichero: src/codecs/jpeg-strips.h
+//
+// Row-strip JPEG decoder / encoder on the libjpeg API (libjpeg-turbo), for
+// the streaming mode of src/streaming.cpp and the region decode of crop.
+// - JpegStripReader decodes scanlines into caller strips. It can shrink with
+//   DCT scaling (1/2, 1/4, 1/8), skip rows and decode only a column range
+//   (jpeg_skip_scanlines / jpeg_crop_scanline, libjpeg-turbo ≥ 1.5).
+// - DecodeJpegRegion() decodes one rectangle: rows above are skipped, rows
+//   below are never read and only the rectangle's iMCU columns go through
+//   IDCT and colour conversion.
+// - JpegStripWriter compresses rows as they arrive; only the compressed
+//   bytes grow (jpeg_mem_dest), never a full frame of pixels.
+// libjpeg reports errors through longjmp. Every libjpeg call goes through
+// Guard(), whose frame holds no objects with destructors, and the failure
+// comes back as a false return.
+// Needs libjpeg-turbo: the colour extensions (JCS_EXT_*) and the skip /
+// crop calls are not in IJG libjpeg. Built only when binding.gyp finds
+// libjpeg (HAVE_LIBJPEG) and it is libjpeg-turbo, which then defines
+// HAVE_JPEG_STRIPS; otherwise streaming and region decode stay off.
+
+#ifndef JPEG_STRIPS_H
+#define JPEG_STRIPS_H
+
+#ifdef HAVE_LIBJPEG
+#include <cstdio>
+#include <jpeglib.h>
+#if defined(JCS_EXTENSIONS) && defined(LIBJPEG_TURBO_VERSION)
+#define HAVE_JPEG_STRIPS 1
+#endif
+#endif
+
+#ifdef HAVE_JPEG_STRIPS
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace jpeg_strips_detail {
+
+struct ErrorManager {
+  jpeg_error_mgr pub;
+  std::jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+};
+
+inline void OnError(j_common_ptr cinfo) {
+  auto* err = reinterpret_cast<ErrorManager*>(cinfo->err);
+  err->pub.format_message(cinfo, err->message);
+  std::longjmp(err->jump, 1);
+}
+
+inline void Install(ErrorManager& err) {
+  jpeg_std_error(&err.pub);
+  err.pub.error_exit = OnError;
+  err.pub.output_message = [](j_common_ptr) {};        // warnings are not fatal
+  err.message[0] = '\0';
+}
+
+// Row pointers of `rows` (any step)
+inline std::vector<JSAMPROW> RowPointers(const cv::Mat& rows) {
+  std::vector<JSAMPROW> ptrs(rows.rows);
+  for (int y = 0; y < rows.rows; ++y) ptrs[y] = const_cast<JSAMPROW>(rows.ptr<uchar>(y));
+  return ptrs;
+}
+
+}  // namespace jpeg_strips_detail
+
+class JpegStripReader {
+public:
+  JpegStripReader() {
+    jpeg_strips_detail::Install(err_);
+    cinfo_.err = &err_.pub;
+  }
+  ~JpegStripReader() { if (created_) jpeg_destroy_decompress(&cinfo_); }
+
+  JpegStripReader(const JpegStripReader&) = delete;
+  JpegStripReader& operator=(const JpegStripReader&) = delete;
+
+  // 1- or 3-component JPEGs only (BGR / GRAY output, as cv::imdecode).
+  // `reduce` 1/2/4/8 = DCT scale denominator.
+  bool Open(const uchar* data, size_t size, int reduce) {
+    return Guard([&] {
+      jpeg_create_decompress(&cinfo_);
+      created_ = true;
+      jpeg_mem_src(&cinfo_, const_cast<uchar*>(data), static_cast<unsigned long>(size));
+      jpeg_read_header(&cinfo_, TRUE);
+      if (cinfo_.num_components != 1 && cinfo_.num_components != 3) {
+        std::snprintf(err_.message, sizeof(err_.message), "streaming: %d-component JPEG",
+                      cinfo_.num_components);
+        std::longjmp(err_.jump, 1);
+      }
+      cinfo_.out_color_space = cinfo_.num_components == 1 ? JCS_GRAYSCALE : JCS_EXT_BGR;
+      cinfo_.scale_num = 1;
+      cinfo_.scale_denom = reduce;
+      jpeg_start_decompress(&cinfo_);
+    });
+  }
+
+  int Width() const    { return static_cast<int>(cinfo_.output_width); }
+  int Height() const   { return static_cast<int>(cinfo_.output_height); }
+  int Channels() const { return cinfo_.output_components; }
+  int Row() const      { return static_cast<int>(cinfo_.output_scanline); }
+
+  // Decode only columns [x, x + width). The range grows by one column on
+  // each side (fancy chroma upsampling replicates the samples at its edges,
+  // which must not be the rectangle's own) and libjpeg widens it to iMCU
+  // boundaries: on return `x` / `width` hold the decoded range. Call before
+  // the first Read().
+  bool CropColumns(int& x, int& width) {
+    const int end = std::min(Width(), x + width + 1);
+    JDIMENSION xo = std::max(0, x - 1);
+    JDIMENSION w = end - static_cast<int>(xo);
+    const bool ok = Guard([&] { jpeg_crop_scanline(&cinfo_, &xo, &w); });
+    x = static_cast<int>(xo);
+    width = static_cast<int>(w);
+    return ok;
+  }
+
+  bool Skip(int rows) {
+    return Guard([&] { jpeg_skip_scanlines(&cinfo_, static_cast<JDIMENSION>(rows)); });
+  }
+
+  // Fills every row of `strip` (Width() × Channels(), 8-bit) with the next scanlines
+  bool Read(cv::Mat strip) {
+    std::vector<JSAMPROW> rows = jpeg_strips_detail::RowPointers(strip);
+    return Guard([&] {
+      JDIMENSION done = 0;
+      while (done < rows.size()) {
+        done += jpeg_read_scanlines(&cinfo_, rows.data() + done,
+                                    static_cast<JDIMENSION>(rows.size() - done));
+      }
+    });
+  }
+
+  const char* Error() const { return err_.message; }
+
+private:
+  template <typename F> bool Guard(F&& f) {
+    if (setjmp(err_.jump)) return false;
+    f();
+    return true;
+  }
+
+  jpeg_decompress_struct cinfo_{};
+  jpeg_strips_detail::ErrorManager err_;
+  bool created_ = false;
+};
+
+// `rect` in full-resolution pixels, inside the image. `out` is a view of
+// rect.size() into a buffer of the decoded (iMCU-widened) columns, in the
+// reader's BGR / GRAY order.
+inline bool DecodeJpegRegion(const uchar* data, size_t size, const cv::Rect& rect,
+                             cv::Mat& out, std::string& error) {
+  JpegStripReader reader;
+  int cx = rect.x, cw = rect.width;
+  if (!reader.Open(data, size, 1) || !reader.CropColumns(cx, cw) || !reader.Skip(rect.y)) {
+    error = reader.Error();
+    return false;
+  }
+  cv::Mat buf(rect.height, cw, CV_8UC(reader.Channels()));
+  if (!reader.Read(buf)) {
+    error = reader.Error();
+    return false;
+  }
+  out = buf(cv::Rect(rect.x - cx, 0, rect.width, rect.height));
+  return true;
+}
+
+class JpegStripWriter {
+public:
+  JpegStripWriter() {
+    jpeg_strips_detail::Install(err_);
+    cinfo_.err = &err_.pub;
+  }
+  ~JpegStripWriter() {
+    if (created_) jpeg_destroy_compress(&cinfo_);
+    std::free(buffer_);
+  }
+
+  JpegStripWriter(const JpegStripWriter&) = delete;
+  JpegStripWriter& operator=(const JpegStripWriter&) = delete;
+
+  // Rows arrive in `order` (RGB / BGR / RGBA / BGRA / GRAY); alpha is ignored
+  bool Begin(int width, int height, int channels, const std::string& order, int quality) {
+    J_COLOR_SPACE space;
+    switch (channels) {
+      case 1:  space = JCS_GRAYSCALE; break;
+      case 3:  space = order == "RGB" ? JCS_EXT_RGB : JCS_EXT_BGR; break;
+      case 4:  space = order == "RGBA" ? JCS_EXT_RGBX : JCS_EXT_BGRX; break;
+      default: return false;
+    }
+    return Guard([&] {
+      jpeg_create_compress(&cinfo_);
+      created_ = true;
+      jpeg_mem_dest(&cinfo_, &buffer_, &size_);
+      cinfo_.image_width = width;
+      cinfo_.image_height = height;
+      cinfo_.input_components = channels;
+      cinfo_.in_color_space = space;
+      jpeg_set_defaults(&cinfo_);
+      jpeg_set_quality(&cinfo_, quality, TRUE);
+      jpeg_start_compress(&cinfo_, TRUE);
+    });
+  }
+
+  bool Write(const cv::Mat& rows) {
+    std::vector<JSAMPROW> ptrs = jpeg_strips_detail::RowPointers(rows);
+    return Guard([&] {
+      jpeg_write_scanlines(&cinfo_, ptrs.data(), static_cast<JDIMENSION>(ptrs.size()));
+    });
+  }
+
+  bool Finish(std::vector<uchar>& out) {
+    if (!Guard([&] { jpeg_finish_compress(&cinfo_); })) return false;
+    out.assign(buffer_, buffer_ + size_);
+    return true;
+  }
+
+  const char* Error() const { return err_.message; }
+
+private:
+  template <typename F> bool Guard(F&& f) {
+    if (setjmp(err_.jump)) return false;
+    f();
+    return true;
+  }
+
+  jpeg_compress_struct cinfo_{};
+  jpeg_strips_detail::ErrorManager err_;
+  bool created_ = false;
+  unsigned char* buffer_ = nullptr;
+  unsigned long size_ = 0;
+};
+#endif // HAVE_JPEG_STRIPS
+
+#endif // JPEG_STRIPS_H
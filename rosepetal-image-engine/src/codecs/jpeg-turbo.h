@@ -0,0 +1,97 @@
+// Fichero: src/codecs/jpeg-turbo.h
+//
+// Direct libjpeg-turbo (TurboJPEG API) encoder used by EncodeImage().
+// - One compressor handle per worker thread (thread_local), created lazily
+//   and reused for every frame that thread encodes.
+// - Encodes straight from RGB/BGR/RGBA/BGRA/GRAY pixels (stride-aware, so
+//   ROIs work), no cvtColor copy beforehand.
+// - Compresses into a per-thread scratch buffer sized with tjBufSize() and
+//   grown only when a larger frame arrives; the result is copied once into
+//   an exactly-sized vector that is handed to JS.
+// Built only when binding.gyp finds libturbojpeg (HAVE_TURBOJPEG); without
+// it EncodeJpegTurbo() returns false and callers fall back to cv::imencode.
+
+#ifndef JPEG_TURBO_H
+#define JPEG_TURBO_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+
+class TurboJpegCompressor {
+public:
+  static TurboJpegCompressor& ForThisThread() {
+    thread_local TurboJpegCompressor instance;
+    return instance;
+  }
+
+  // Returns false if libjpeg-turbo rejected the frame (caller falls back).
+  bool Compress(const cv::Mat& src, int pixelFormat, int quality,
+                std::vector<uchar>& out) {
+    if (!handle_) return false;
+
+    const int subsamp = (pixelFormat == TJPF_GRAY) ? TJSAMP_GRAY : TJSAMP_420;
+    const unsigned long needed = tjBufSize(src.cols, src.rows, subsamp);
+    if (needed > scratchSize_) {
+      if (scratch_) tjFree(scratch_);
+      scratch_ = tjAlloc(static_cast<int>(needed));
+      scratchSize_ = scratch_ ? needed : 0;
+      if (!scratch_) return false;
+    }
+
+    unsigned long jpegSize = scratchSize_;
+    const int rc = tjCompress2(handle_, src.data, src.cols, static_cast<int>(src.step),
+                               src.rows, pixelFormat, &scratch_, &jpegSize,
+                               subsamp, quality, TJFLAG_NOREALLOC);
+    if (rc != 0) return false;
+
+    out.assign(scratch_, scratch_ + jpegSize);
+    return true;
+  }
+
+  TurboJpegCompressor(const TurboJpegCompressor&) = delete;
+  TurboJpegCompressor& operator=(const TurboJpegCompressor&) = delete;
+
+private:
+  TurboJpegCompressor() : handle_(tjInitCompress()) {}
+  ~TurboJpegCompressor() {
+    if (scratch_) tjFree(scratch_);
+    if (handle_) tjDestroy(handle_);
+  }
+
+  tjhandle handle_ = nullptr;
+  unsigned char* scratch_ = nullptr;
+  unsigned long scratchSize_ = 0;
+};
+
+// TurboJPEG pixel format for a channel order; -1 if unsupported
+inline int TurboPixelFormat(const cv::Mat& src, const std::string& order) {
+  switch (src.channels()) {
+    case 1: return TJPF_GRAY;
+    case 3: return (order == "RGB")  ? TJPF_RGB  : TJPF_BGR;
+    case 4: return (order == "RGBA") ? TJPF_RGBA : TJPF_BGRA;   // alpha ignored
+    default: return -1;
+  }
+}
+#endif // HAVE_TURBOJPEG
+
+// true  → `out` holds the JPEG
+// false → not built with TurboJPEG or unsupported input; use cv::imencode
+inline bool EncodeJpegTurbo(const cv::Mat& src, const std::string& order,
+                            std::vector<uchar>& out, int quality) {
+#ifdef HAVE_TURBOJPEG
+  if (src.depth() != CV_8U || src.empty()) return false;
+  const int pixelFormat = TurboPixelFormat(src, order);
+  if (pixelFormat < 0) return false;
+  return TurboJpegCompressor::ForThisThread().Compress(
+      src, pixelFormat, std::max(1, std::min(quality, 100)), out);
+#else
+  (void)src; (void)order; (void)out; (void)quality;
+  return false;
+#endif
+}
+
+#endif // JPEG_TURBO_H
@@ -0,0 +1,297 @@
+// Fichero: src/codecs/tensor.h
+//
+// "tensor" output format: the result image written as a normalized planar
+// float blob, ready to be fed to an inference runtime.
+// - One pass per row: channel reorder (BGR↔RGB, alpha dropped, GRAY
+//   replicated), value = (pixel·scale − mean[c]) / std[c] folded into one
+//   FMA, and HWC → CHW scatter into the channel planes.
+// - 8-bit rows use 128-bit universal intrinsics (deinterleave, widen to
+//   float, FMA), or the x86 sse4.2 / avx2 / avx512 variant picked by
+//   PickSimd() (src/runtime/cpu-dispatch.h); other depths go through a
+//   scalar path.
+// - float16 output converts each finished row with cv::Mat::convertTo.
+// Batches (BatchWorker) write every image into one contiguous NCHW blob.
+
+#ifndef TENSOR_CODEC_H
+#define TENSOR_CODEC_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../runtime/cpu-dispatch.h"
+
+struct TensorOptions {
+  std::string dtype = "float32";       // float32 | float16
+  std::string channelOrder = "RGB";    // RGB | BGR | GRAY
+  std::array<double, 3> mean{ 0.0, 0.0, 0.0 };   // in channelOrder, after scale
+  std::array<double, 3> stddev{ 1.0, 1.0, 1.0 };
+  double scale = 0.0;                  // 0 → 1/255 (8-bit), 1/65535 (16-bit), 1 (float)
+
+  int Channels() const { return channelOrder == "GRAY" ? 1 : 3; }
+  size_t ElemSize() const { return dtype == "float16" ? 2 : 4; }
+  size_t Bytes(const cv::Size& s) const { return size_t(s.area()) * Channels() * ElemSize(); }
+};
+
+namespace tensor_detail {
+
+// Source channel feeding each tensor channel
+inline void ChannelMap(const std::string& order, int srcCn, const TensorOptions& t, int map[3]) {
+  const std::string out = t.channelOrder == "GRAY" ? "G" : t.channelOrder;
+  for (int c = 0; c < t.Channels(); ++c) {
+    if (srcCn == 1) { map[c] = 0; continue; }
+    const size_t pos = order.find(out[c]);
+    if (pos == std::string::npos || static_cast<int>(pos) >= srcCn) {
+      throw std::runtime_error("tensor: cannot map " + order + " to " + t.channelOrder);
+    }
+    map[c] = static_cast<int>(pos);
+  }
+}
+
+// Scalar rest of an 8-bit row from pixel x
+inline void RowU8Tail(const uchar* src, int x, int width, int cn, const int map[3], int C,
+                      const float a[3], const float b[3], float* const planes[3]) {
+  for (; x < width; ++x) {
+    const uchar* px = src + x * cn;
+    for (int c = 0; c < C; ++c) planes[c][x] = px[map[c]] * a[c] + b[c];
+  }
+}
+
+// One 8-bit row into C float planes: plane[c][x] = src[x·cn + map[c]]·a[c] + b[c]
+inline void RowU8(const uchar* src, int width, int cn, const int map[3], int C,
+                  const float a[3], const float b[3], float* const planes[3]) {
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_uint8x16::nlanes;
+  if (cn == 1 || cn == 3 || cn == 4) {
+    cv::v_float32x4 va[3], vb[3];
+    for (int c = 0; c < C; ++c) { va[c] = cv::v_setall_f32(a[c]); vb[c] = cv::v_setall_f32(b[c]); }
+    for (; x <= width - N; x += N) {
+      cv::v_uint8x16 ch[4];
+      if (cn == 1)      ch[0] = cv::v_load(src + x);
+      else if (cn == 3) cv::v_load_deinterleave(src + 3 * x, ch[0], ch[1], ch[2]);
+      else              cv::v_load_deinterleave(src + 4 * x, ch[0], ch[1], ch[2], ch[3]);
+
+      for (int c = 0; c < C; ++c) {
+        cv::v_uint16x8 lo, hi;
+        cv::v_expand(ch[map[c]], lo, hi);
+        cv::v_uint32x4 q0, q1, q2, q3;
+        cv::v_expand(lo, q0, q1);
+        cv::v_expand(hi, q2, q3);
+        float* p = planes[c] + x;
+        cv::v_store(p,      cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(q0)), va[c], vb[c]));
+        cv::v_store(p + 4,  cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(q1)), va[c], vb[c]));
+        cv::v_store(p + 8,  cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(q2)), va[c], vb[c]));
+        cv::v_store(p + 12, cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(q3)), va[c], vb[c]));
+      }
+    }
+  }
+#endif
+  RowU8Tail(src, x, width, cn, map, C, a, b, planes);
+}
+
+/*──────── x86 variants of RowU8 (4 / 8 / 16 pixels per step) ────────*/
+// A pshufb per tensor channel gathers that channel of the 4 pixels of each
+// 128-bit lane into the lane's low dword; a dword permute packs the lanes
+// together and the bytes are widened straight to float. 3-channel rows are
+// spread so each lane starts on a pixel, as in alpha-blend.h.
+#if ROSEPETAL_X86_SIMD
+// Low dword of a pshufb mask: bytes k, k+cn, k+2cn, k+3cn
+inline int ChannelBytes(int k, int cn) {
+  return k | (k + cn) << 8 | (k + 2 * cn) << 16 | (k + 3 * cn) << 24;
+}
+
+ROSEPETAL_TARGET_SSE42
+inline void RowU8_sse42(const uchar* src, int width, int cn, const int map[3], int C,
+                        const float a[3], const float b[3], float* const planes[3]) {
+  int x = 0;
+  if (cn == 1 || cn == 3 || cn == 4) {
+    __m128i pick[3];
+    __m128 va[3], vb[3];
+    for (int c = 0; c < C; ++c) {
+      pick[c] = _mm_setr_epi32(ChannelBytes(map[c], cn), -1, -1, -1);
+      va[c] = _mm_set1_ps(a[c]);
+      vb[c] = _mm_set1_ps(b[c]);
+    }
+    for (; x <= width - 4; x += 4) {
+      const uchar* p = src + x * cn;
+      __m128i px;
+      if (cn == 4) {
+        px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      } else {
+        int tail;
+        std::memcpy(&tail, p + 4 * (cn - 1), 4);
+        px = cn == 1 ? _mm_cvtsi32_si128(tail)
+                     : _mm_insert_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), tail, 2);
+      }
+      for (int c = 0; c < C; ++c) {
+        const __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_shuffle_epi8(px, pick[c])));
+        _mm_storeu_ps(planes[c] + x, _mm_add_ps(_mm_mul_ps(f, va[c]), vb[c]));
+      }
+    }
+  }
+  RowU8Tail(src, x, width, cn, map, C, a, b, planes);
+}
+
+ROSEPETAL_TARGET_AVX2
+inline void RowU8_avx2(const uchar* src, int width, int cn, const int map[3], int C,
+                       const float a[3], const float b[3], float* const planes[3]) {
+  int x = 0;
+  if (cn == 1 || cn == 3 || cn == 4) {
+    const __m256i rows  = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+    const __m256i split = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i join  = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+    __m256i pick[3];
+    __m256 va[3], vb[3];
+    for (int c = 0; c < C; ++c) {
+      const int m = ChannelBytes(map[c], cn);
+      pick[c] = _mm256_setr_epi32(m, -1, -1, -1, m, -1, -1, -1);
+      va[c] = _mm256_set1_ps(a[c]);
+      vb[c] = _mm256_set1_ps(b[c]);
+    }
+    for (; x <= width - 8; x += 8) {
+      const uchar* p = src + x * cn;
+      if (cn == 1) {
+        const __m256 f = _mm256_cvtepi32_ps(
+          _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+        for (int c = 0; c < C; ++c) _mm256_storeu_ps(planes[c] + x, _mm256_fmadd_ps(f, va[c], vb[c]));
+        continue;
+      }
+      const __m256i px = cn == 4
+        ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))
+        : _mm256_permutevar8x32_epi32(_mm256_maskload_epi32(reinterpret_cast<const int*>(p), rows), split);
+      for (int c = 0; c < C; ++c) {
+        const __m128i bytes = _mm256_castsi256_si128(
+          _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(px, pick[c]), join));
+        const __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        _mm256_storeu_ps(planes[c] + x, _mm256_fmadd_ps(f, va[c], vb[c]));
+      }
+    }
+  }
+  RowU8Tail(src, x, width, cn, map, C, a, b, planes);
+}
+
+ROSEPETAL_TARGET_AVX512
+inline void RowU8_avx512(const uchar* src, int width, int cn, const int map[3], int C,
+                         const float a[3], const float b[3], float* const planes[3]) {
+  int x = 0;
+  if (cn == 1 || cn == 3 || cn == 4) {
+    const __mmask64 rows = 0xFFFFFFFFFFFFull;
+    const __m512i split = _mm512_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12);
+    const __m512i join  = _mm512_setr_epi32(0, 4, 8, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m512i pick[3];
+    __m512 va[3], vb[3];
+    for (int c = 0; c < C; ++c) {
+      pick[c] = _mm512_setr4_epi32(ChannelBytes(map[c], cn), -1, -1, -1);
+      va[c] = _mm512_set1_ps(a[c]);
+      vb[c] = _mm512_set1_ps(b[c]);
+    }
+    for (; x <= width - 16; x += 16) {
+      const uchar* p = src + x * cn;
+      if (cn == 1) {
+        const __m512 f = _mm512_cvtepi32_ps(
+          _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+        for (int c = 0; c < C; ++c) _mm512_storeu_ps(planes[c] + x, _mm512_fmadd_ps(f, va[c], vb[c]));
+        continue;
+      }
+      const __m512i px = cn == 4
+        ? _mm512_loadu_si512(p)
+        : _mm512_permutexvar_epi32(split, _mm512_maskz_loadu_epi8(rows, p));
+      for (int c = 0; c < C; ++c) {
+        const __m128i bytes = _mm512_castsi512_si128(
+          _mm512_permutexvar_epi32(join, _mm512_shuffle_epi8(px, pick[c])));
+        const __m512 f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes));
+        _mm512_storeu_ps(planes[c] + x, _mm512_fmadd_ps(f, va[c], vb[c]));
+      }
+    }
+  }
+  RowU8Tail(src, x, width, cn, map, C, a, b, planes);
+}
+#endif // ROSEPETAL_X86_SIMD
+
+// Same for a row already converted to float (16-bit / float inputs)
+inline void RowF32(const float* src, int width, int cn, const int map[3], int C,
+                   const float a[3], const float b[3], float* const planes[3]) {
+  for (int x = 0; x < width; ++x) {
+    const float* px = src + x * cn;
+    for (int c = 0; c < C; ++c) planes[c][x] = px[map[c]] * a[c] + b[c];
+  }
+}
+
+}  // namespace tensor_detail
+
+// Writes `src` (channel order `order`) as a C×H×W tensor at `dst`, which
+// must hold t.Bytes(src.size()). Returns ms.
+inline double EncodeTensor(const cv::Mat& src, const std::string& order,
+                           uchar* dst, const TensorOptions& t) {
+  const int64 t0 = cv::getTickCount();
+  if (src.empty()) throw std::runtime_error("tensor: empty image");
+
+  // Color → GRAY tensors go through cvtColor; everything else is a channel map
+  cv::Mat img = src;
+  std::string imgOrder = order;
+  if (t.Channels() == 1 && src.channels() > 1) {
+    const bool rgb = order.rfind("RGB", 0) == 0;
+    cv::cvtColor(src, img, src.channels() == 4 ? (rgb ? cv::COLOR_RGBA2GRAY : cv::COLOR_BGRA2GRAY)
+                                               : (rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY));
+    imgOrder = "GRAY";
+  }
+
+  const int C = t.Channels(), W = img.cols, H = img.rows, cn = img.channels();
+  int map[3] = { 0, 0, 0 };
+  tensor_detail::ChannelMap(imgOrder, cn, t, map);
+
+  const double scale = t.scale > 0.0 ? t.scale
+                     : img.depth() == CV_8U  ? 1.0 / 255.0
+                     : img.depth() == CV_16U ? 1.0 / 65535.0 : 1.0;
+  float a[3], b[3];
+  for (int c = 0; c < C; ++c) {
+    const double sd = t.stddev[c] != 0.0 ? t.stddev[c] : 1.0;
+    a[c] = static_cast<float>(scale / sd);
+    b[c] = static_cast<float>(-t.mean[c] / sd);
+  }
+
+  using RowFn = void (*)(const uchar*, int, int, const int*, int, const float*, const float*, float* const*);
+  const RowFn rowU8 = PickSimd<RowFn>(tensor_detail::RowU8,
+    SIMD_VARIANT(tensor_detail::RowU8_sse42), SIMD_VARIANT(tensor_detail::RowU8_avx2),
+    SIMD_VARIANT(tensor_detail::RowU8_avx512));
+
+  const bool half = t.dtype == "float16";
+  const size_t plane = size_t(W) * H;
+  cv::parallel_for_(cv::Range(0, H), [&](const cv::Range& r) {
+    std::vector<float> rowF, rowIn;
+    if (half) rowF.resize(size_t(W) * C);
+    if (img.depth() != CV_8U) rowIn.resize(size_t(W) * cn);
+
+    for (int y = r.start; y < r.end; ++y) {
+      float* planes[3];
+      for (int c = 0; c < C; ++c) {
+        planes[c] = half ? rowF.data() + size_t(c) * W
+                         : reinterpret_cast<float*>(dst) + c * plane + size_t(y) * W;
+      }
+
+      if (img.depth() == CV_8U) {
+        rowU8(img.ptr<uchar>(y), W, cn, map, C, a, b, planes);
+      } else {
+        cv::Mat in(1, W, CV_MAKETYPE(CV_32F, cn), rowIn.data());
+        img.row(y).convertTo(in, CV_32F);
+        tensor_detail::RowF32(rowIn.data(), W, cn, map, C, a, b, planes);
+      }
+
+      if (half) {
+        for (int c = 0; c < C; ++c) {
+          cv::Mat out(1, W, CV_16F, dst + (c * plane + size_t(y) * W) * 2);
+          cv::Mat(1, W, CV_32F, planes[c]).convertTo(out, CV_16F);
+        }
+      }
+    }
+  }, std::max(1, H / 64));
+
+  return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+}
+
+#endif // TENSOR_CODEC_H
@@ -0,0 +1,84 @@
+// Fichero: src/codecs/webp.h
+//
+// Direct libwebp encoder used by EncodeImage() for "webp" output.
+// - Exposes what cv::imencode cannot: compression method (0 = fastest,
+//   6 = smallest), lossless mode and libwebp's multi-threaded encoder.
+// - Imports RGB/BGR/RGBA/BGRA pixels as they are (stride-aware, alpha is
+//   ignored like the other encoders do); only GRAY needs a cvtColor.
+// Built only when binding.gyp finds libwebp (HAVE_LIBWEBP); without it
+// EncodeWebpDirect() returns false and callers fall back to cv::imencode.
+
+#ifndef WEBP_CODEC_H
+#define WEBP_CODEC_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_LIBWEBP
+#include <webp/encode.h>
+#endif
+
+// true  → `out` holds the WebP
+// false → not built with libwebp or the encoder failed; use cv::imencode
+inline bool EncodeWebpDirect(const cv::Mat& src, const std::string& order,
+                             std::vector<uchar>& out, int quality,
+                             int method, bool lossless, bool threaded) {
+#ifdef HAVE_LIBWEBP
+  if (src.depth() != CV_8U || src.empty()) return false;
+
+  WebPConfig config;
+  if (!WebPConfigInit(&config)) return false;
+  config.quality  = static_cast<float>(std::max(0, std::min(quality, 100)));
+  config.lossless = lossless ? 1 : 0;
+  if (method >= 0) config.method = std::min(method, 6);
+  config.thread_level = threaded ? 1 : 0;
+  if (!WebPValidateConfig(&config)) return false;
+
+  cv::Mat px = src;
+  std::string pxOrder = order;
+  if (src.channels() == 1) {
+    cv::cvtColor(src, px, cv::COLOR_GRAY2BGR);
+    pxOrder = "BGR";
+  }
+
+  WebPPicture pic;
+  if (!WebPPictureInit(&pic)) return false;
+  pic.use_argb = config.lossless;
+  pic.width    = px.cols;
+  pic.height   = px.rows;
+
+  const int stride = static_cast<int>(px.step);
+  int imported = 0;
+  switch (px.channels()) {
+    case 3: imported = (pxOrder == "RGB")
+                ? WebPPictureImportRGB(&pic, px.data, stride)
+                : WebPPictureImportBGR(&pic, px.data, stride);
+            break;
+    case 4: imported = (pxOrder == "RGBA")
+                ? WebPPictureImportRGBX(&pic, px.data, stride)
+                : WebPPictureImportBGRX(&pic, px.data, stride);
+            break;
+    default: break;
+  }
+  if (!imported) { WebPPictureFree(&pic); return false; }
+
+  WebPMemoryWriter writer;
+  WebPMemoryWriterInit(&writer);
+  pic.writer     = WebPMemoryWrite;
+  pic.custom_ptr = &writer;
+
+  const bool ok = WebPEncode(&config, &pic) != 0;
+  if (ok) out.assign(writer.mem, writer.mem + writer.size);
+
+  WebPMemoryWriterClear(&writer);
+  WebPPictureFree(&pic);
+  return ok;
+#else
+  (void)src; (void)order; (void)out; (void)quality;
+  (void)method; (void)lossless; (void)threaded;
+  return false;
+#endif
+}
+
+#endif // WEBP_CODEC_H
@@ -0,0 +1,604 @@
+// Fichero: src/compositing/alpha-blend.h
+//
+// Vectorised "over" compositing shared by advanced-mosaic, mosaic and blend.
+// Kernels are written with OpenCV universal intrinsics (SSE2/NEON/VSX at
+// the build's baseline) and fall back to scalar code for the row tail. The
+// 8-bit ones also have x86 sse4.2 / avx2 / avx512 variants that work on
+// interleaved pixels; the Mat entry points pick one per call with PickSimd()
+// (src/runtime/cpu-dispatch.h).
+//
+//   straight alpha (colour not multiplied by alpha)
+//     AlphaOverRow_u8   ─ 8-bit fixed point, destination assumed opaque
+//     AlphaOverRow_f32  ─ float [0,1], any destination alpha
+//   premultiplied alpha
+//     AlphaOverPremulRow_u8 / AlphaOverPremulRow_f32
+//
+//   separate alpha plane
+//     AlphaOverGrayRow_u8 ─ 1-channel src + 8-bit alpha over 1-channel dst
+//
+// Source rows are always 4 channels (except the gray kernel); straight-alpha
+// kernels accept a 3- or 4-channel destination (4-over-3 / 4-over-4). Channel order is irrelevant
+// as long as alpha is last and src/dst share the colour order.
+
+#ifndef ALPHA_BLEND_H
+#define ALPHA_BLEND_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <cstring>
+#include "../runtime/cpu-dispatch.h"
+
+/*──────────────────────── fixed-point helpers ────────────────────────*/
+// Exact round(x / 255) for x in [0, 255*255]
+inline unsigned AlphaDiv255(unsigned x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+#if CV_SIMD128
+inline cv::v_uint16x8 AlphaDiv255(const cv::v_uint16x8& x) {
+  const cv::v_uint16x8 t = x + cv::v_setall_u16(128);
+  return (t + (t >> 8)) >> 8;
+}
+
+// (s*a + d*ia) / 255 on 16 lanes; a + ia == 255
+inline cv::v_uint8x16 AlphaMix(const cv::v_uint8x16& s, const cv::v_uint8x16& d,
+                               const cv::v_uint16x8& aLo, const cv::v_uint16x8& aHi,
+                               const cv::v_uint16x8& iaLo, const cv::v_uint16x8& iaHi) {
+  cv::v_uint16x8 sLo, sHi, dLo, dHi;
+  cv::v_expand(s, sLo, sHi);
+  cv::v_expand(d, dLo, dHi);
+  return cv::v_pack(AlphaDiv255(sLo * aLo + dLo * iaLo),
+                    AlphaDiv255(sHi * aHi + dHi * iaHi));
+}
+
+// s + d*ia/255 on 16 lanes (premultiplied over)
+inline cv::v_uint8x16 AlphaPremulMix(const cv::v_uint8x16& s, const cv::v_uint8x16& d,
+                                     const cv::v_uint16x8& iaLo, const cv::v_uint16x8& iaHi) {
+  cv::v_uint16x8 sLo, sHi, dLo, dHi;
+  cv::v_expand(s, sLo, sHi);
+  cv::v_expand(d, dLo, dHi);
+  return cv::v_pack(sLo + AlphaDiv255(dLo * iaLo),
+                    sHi + AlphaDiv255(dHi * iaHi));
+}
+#endif
+
+/*──────────────────────── 8-bit kernels ──────────────────────────────*/
+// Scalar row tails from pixel x, shared by every variant below
+inline void AlphaOverTail_u8(const uchar* src, uchar* dst, int x, int width, int dstCn)
+{
+  for (; x < width; ++x) {
+    const uchar* s = src + 4 * x;
+    uchar* d = dst + dstCn * x;
+    const unsigned a = s[3], ia = 255 - a;
+    d[0] = static_cast<uchar>(AlphaDiv255(s[0] * a + d[0] * ia));
+    d[1] = static_cast<uchar>(AlphaDiv255(s[1] * a + d[1] * ia));
+    d[2] = static_cast<uchar>(AlphaDiv255(s[2] * a + d[2] * ia));
+    if (dstCn == 4) d[3] = static_cast<uchar>(a + AlphaDiv255(d[3] * ia));
+  }
+}
+
+inline void AlphaOverGrayTail_u8(const uchar* src, const uchar* alpha, uchar* dst, int x, int width)
+{
+  for (; x < width; ++x) {
+    const unsigned a = alpha[x];
+    dst[x] = static_cast<uchar>(AlphaDiv255(src[x] * a + dst[x] * (255 - a)));
+  }
+}
+
+inline void AlphaOverPremulTail_u8(const uchar* src, uchar* dst, int x, int width)
+{
+  for (; x < width; ++x) {
+    const uchar* s = src + 4 * x;
+    uchar* d = dst + 4 * x;
+    const unsigned ia = 255 - s[3];
+    for (int c = 0; c < 4; ++c) {
+      d[c] = cv::saturate_cast<uchar>(s[c] + AlphaDiv255(d[c] * ia));
+    }
+  }
+}
+
+// Straight-alpha src over an opaque dst: c = (s·a + d·(255−a)) / 255.
+// For a 4-channel dst the alpha becomes a + dA·(255−a)/255 (stays 255 on
+// an opaque canvas, which is what the mosaics always start from).
+inline void AlphaOverRow_u8(const uchar* src, uchar* dst, int width, int dstCn)
+{
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_uint8x16::nlanes;
+  const cv::v_uint16x8 v255 = cv::v_setall_u16(255);
+  for (; x <= width - N; x += N) {
+    cv::v_uint8x16 s0, s1, s2, sa, d0, d1, d2, da;
+    cv::v_load_deinterleave(src + 4 * x, s0, s1, s2, sa);
+
+    cv::v_uint16x8 aLo, aHi;
+    cv::v_expand(sa, aLo, aHi);
+    const cv::v_uint16x8 iaLo = v255 - aLo, iaHi = v255 - aHi;
+
+    if (dstCn == 4) {
+      cv::v_load_deinterleave(dst + 4 * x, d0, d1, d2, da);
+      cv::v_uint16x8 daLo, daHi;
+      cv::v_expand(da, daLo, daHi);
+      da = cv::v_pack(aLo + AlphaDiv255(daLo * iaLo), aHi + AlphaDiv255(daHi * iaHi));
+      cv::v_store_interleave(dst + 4 * x,
+                             AlphaMix(s0, d0, aLo, aHi, iaLo, iaHi),
+                             AlphaMix(s1, d1, aLo, aHi, iaLo, iaHi),
+                             AlphaMix(s2, d2, aLo, aHi, iaLo, iaHi), da);
+    } else {
+      cv::v_load_deinterleave(dst + 3 * x, d0, d1, d2);
+      cv::v_store_interleave(dst + 3 * x,
+                             AlphaMix(s0, d0, aLo, aHi, iaLo, iaHi),
+                             AlphaMix(s1, d1, aLo, aHi, iaLo, iaHi),
+                             AlphaMix(s2, d2, aLo, aHi, iaLo, iaHi));
+    }
+  }
+#endif
+  AlphaOverTail_u8(src, dst, x, width, dstCn);
+}
+
+// Gray src with its own alpha plane over a gray dst: d = (s·a + d·(255−a)) / 255
+inline void AlphaOverGrayRow_u8(const uchar* src, const uchar* alpha, uchar* dst, int width)
+{
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_uint8x16::nlanes;
+  const cv::v_uint16x8 v255 = cv::v_setall_u16(255);
+  for (; x <= width - N; x += N) {
+    cv::v_uint16x8 aLo, aHi;
+    cv::v_expand(cv::v_load(alpha + x), aLo, aHi);
+    cv::v_store(dst + x, AlphaMix(cv::v_load(src + x), cv::v_load(dst + x),
+                                  aLo, aHi, v255 - aLo, v255 - aHi));
+  }
+#endif
+  AlphaOverGrayTail_u8(src, alpha, dst, x, width);
+}
+
+// Premultiplied src over premultiplied dst (4 channels): d = s + d·(255−a)/255
+inline void AlphaOverPremulRow_u8(const uchar* src, uchar* dst, int width)
+{
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_uint8x16::nlanes;
+  const cv::v_uint16x8 v255 = cv::v_setall_u16(255);
+  for (; x <= width - N; x += N) {
+    cv::v_uint8x16 s0, s1, s2, sa, d0, d1, d2, da;
+    cv::v_load_deinterleave(src + 4 * x, s0, s1, s2, sa);
+    cv::v_load_deinterleave(dst + 4 * x, d0, d1, d2, da);
+
+    cv::v_uint16x8 aLo, aHi;
+    cv::v_expand(sa, aLo, aHi);
+    const cv::v_uint16x8 iaLo = v255 - aLo, iaHi = v255 - aHi;
+
+    cv::v_store_interleave(dst + 4 * x,
+                           AlphaPremulMix(s0, d0, iaLo, iaHi),
+                           AlphaPremulMix(s1, d1, iaLo, iaHi),
+                           AlphaPremulMix(s2, d2, iaLo, iaHi),
+                           AlphaPremulMix(sa, da, iaLo, iaHi));
+  }
+#endif
+  AlphaOverPremulTail_u8(src, dst, x, width);
+}
+
+/*──────────────────────── float kernels ([0,1]) ──────────────────────*/
+// Straight-alpha src over dst with any alpha:
+//   oA = a + dA·(1−a);  c = (s·a + d·dA·(1−a)) / oA
+// 3-channel dst is treated as opaque: c = s·a + d·(1−a)
+inline void AlphaOverRow_f32(const float* src, float* dst, int width, int dstCn)
+{
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_float32x4::nlanes;
+  const cv::v_float32x4 one = cv::v_setall_f32(1.f), eps = cv::v_setall_f32(1e-6f);
+  for (; x <= width - N; x += N) {
+    cv::v_float32x4 s0, s1, s2, a, d0, d1, d2, da;
+    cv::v_load_deinterleave(src + 4 * x, s0, s1, s2, a);
+    const cv::v_float32x4 ia = one - a;
+
+    if (dstCn == 4) {
+      cv::v_load_deinterleave(dst + 4 * x, d0, d1, d2, da);
+      const cv::v_float32x4 w  = da * ia;
+      const cv::v_float32x4 oA = a + w;
+      const cv::v_float32x4 inv = one / cv::v_max(oA, eps);
+      cv::v_store_interleave(dst + 4 * x,
+                             (s0 * a + d0 * w) * inv,
+                             (s1 * a + d1 * w) * inv,
+                             (s2 * a + d2 * w) * inv, oA);
+    } else {
+      cv::v_load_deinterleave(dst + 3 * x, d0, d1, d2);
+      cv::v_store_interleave(dst + 3 * x,
+                             cv::v_muladd(s0, a, d0 * ia),
+                             cv::v_muladd(s1, a, d1 * ia),
+                             cv::v_muladd(s2, a, d2 * ia));
+    }
+  }
+#endif
+  for (; x < width; ++x) {
+    const float* s = src + 4 * x;
+    float* d = dst + dstCn * x;
+    const float a = s[3], ia = 1.f - a;
+    if (dstCn == 4) {
+      const float w = d[3] * ia, oA = a + w;
+      const float inv = 1.f / std::max(oA, 1e-6f);
+      d[0] = (s[0] * a + d[0] * w) * inv;
+      d[1] = (s[1] * a + d[1] * w) * inv;
+      d[2] = (s[2] * a + d[2] * w) * inv;
+      d[3] = oA;
+    } else {
+      d[0] = s[0] * a + d[0] * ia;
+      d[1] = s[1] * a + d[1] * ia;
+      d[2] = s[2] * a + d[2] * ia;
+    }
+  }
+}
+
+// Premultiplied src over premultiplied dst (4 channels): d = s + d·(1−a)
+inline void AlphaOverPremulRow_f32(const float* src, float* dst, int width)
+{
+  int x = 0;
+#if CV_SIMD128
+  const int N = cv::v_float32x4::nlanes;
+  const cv::v_float32x4 one = cv::v_setall_f32(1.f);
+  for (; x <= width - N; x += N) {
+    cv::v_float32x4 s0, s1, s2, a, d0, d1, d2, da;
+    cv::v_load_deinterleave(src + 4 * x, s0, s1, s2, a);
+    cv::v_load_deinterleave(dst + 4 * x, d0, d1, d2, da);
+    const cv::v_float32x4 ia = one - a;
+    cv::v_store_interleave(dst + 4 * x,
+                           cv::v_muladd(d0, ia, s0), cv::v_muladd(d1, ia, s1),
+                           cv::v_muladd(d2, ia, s2), cv::v_muladd(da, ia, a));
+  }
+#endif
+  for (; x < width; ++x) {
+    const float* s = src + 4 * x;
+    float* d = dst + 4 * x;
+    const float ia = 1.f - s[3];
+    for (int c = 0; c < 4; ++c) d[c] = s[c] + d[c] * ia;
+  }
+}
+
+/*──────────────────────── x86 variants (8-bit) ───────────────────────*/
+// Same results as the kernels above, on interleaved pixels: one pshufb
+// copies each pixel's alpha over its 4 bytes, so a register of pixels is
+// mixed without deinterleaving (4 / 8 / 16 pixels per step). The alpha byte
+// of a 4-channel dst gets weight 255 for s, which turns the colour formula
+// into a + dA·(255−a)/255. A 3-channel dst is widened to 4 bytes per pixel
+// by a shuffle and packed back before the store; loads and stores of those
+// rows never touch bytes past the pixels of the step.
+#if ROSEPETAL_X86_SIMD
+// Byte shuffles of one 128-bit lane, as 4 dwords (repeated in every lane):
+//   bcast  3333 7777 ...      alpha of each pixel into its 4 bytes
+//   widen  012- 345- ...      12 bytes BGR → 16 bytes BGR0
+//   narrow 0124 5689 ... ---- back to 12 bytes
+#define ALPHA_BCAST_MASK  0x03030303, 0x07070707, 0x0B0B0B0B, 0x0F0F0F0F
+#define ALPHA_WIDEN_MASK  0xFF020100, 0xFF050403, 0xFF080706, 0xFF0B0A09
+#define ALPHA_NARROW_MASK 0x04020100, 0x09080605, 0x0E0D0C0A, 0xFFFFFFFF
+
+ROSEPETAL_TARGET_SSE42 inline __m128i AlphaDiv255_sse42(__m128i t) {
+  t = _mm_add_epi16(t, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// (s·ws + d·wd) / 255 per byte; ws + wd == 255
+ROSEPETAL_TARGET_SSE42 inline __m128i AlphaMix_sse42(__m128i s, __m128i d, __m128i ws, __m128i wd) {
+  const __m128i z = _mm_setzero_si128();
+  const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, z), _mm_unpacklo_epi8(ws, z)),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, z), _mm_unpacklo_epi8(wd, z)));
+  const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, z), _mm_unpackhi_epi8(ws, z)),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, z), _mm_unpackhi_epi8(wd, z)));
+  return _mm_packus_epi16(AlphaDiv255_sse42(lo), AlphaDiv255_sse42(hi));
+}
+
+// s + d·wd / 255 per byte, saturated
+ROSEPETAL_TARGET_SSE42 inline __m128i AlphaPremulMix_sse42(__m128i s, __m128i d, __m128i wd) {
+  const __m128i z = _mm_setzero_si128();
+  const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(s, z),
+    AlphaDiv255_sse42(_mm_mullo_epi16(_mm_unpacklo_epi8(d, z), _mm_unpacklo_epi8(wd, z))));
+  const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(s, z),
+    AlphaDiv255_sse42(_mm_mullo_epi16(_mm_unpackhi_epi8(d, z), _mm_unpackhi_epi8(wd, z))));
+  return _mm_packus_epi16(lo, hi);
+}
+
+ROSEPETAL_TARGET_SSE42
+inline void AlphaOverRow_u8_sse42(const uchar* src, uchar* dst, int width, int dstCn)
+{
+  const __m128i bcast  = _mm_setr_epi32(ALPHA_BCAST_MASK);
+  const __m128i widen  = _mm_setr_epi32(ALPHA_WIDEN_MASK);
+  const __m128i narrow = _mm_setr_epi32(ALPHA_NARROW_MASK);
+  const __m128i aLane  = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m128i ones   = _mm_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 4; x += 4) {
+    const __m128i s  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+    const __m128i a  = _mm_shuffle_epi8(s, bcast);
+    const __m128i ws = _mm_or_si128(a, aLane), wd = _mm_xor_si128(a, ones);
+    if (dstCn == 4) {
+      __m128i* p = reinterpret_cast<__m128i*>(dst + 4 * x);
+      _mm_storeu_si128(p, AlphaMix_sse42(s, _mm_loadu_si128(p), ws, wd));
+    } else {
+      uchar* p = dst + 3 * x;
+      int last;
+      std::memcpy(&last, p + 8, 4);
+      const __m128i d = _mm_shuffle_epi8(
+        _mm_insert_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), last, 2), widen);
+      const __m128i o = _mm_shuffle_epi8(AlphaMix_sse42(s, d, ws, wd), narrow);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(p), o);
+      last = _mm_extract_epi32(o, 2);
+      std::memcpy(p + 8, &last, 4);
+    }
+  }
+  AlphaOverTail_u8(src, dst, x, width, dstCn);
+}
+
+ROSEPETAL_TARGET_SSE42
+inline void AlphaOverGrayRow_u8_sse42(const uchar* src, const uchar* alpha, uchar* dst, int width)
+{
+  const __m128i ones = _mm_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 16; x += 16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + x));
+    __m128i* p = reinterpret_cast<__m128i*>(dst + x);
+    _mm_storeu_si128(p, AlphaMix_sse42(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)),
+                                       _mm_loadu_si128(p), a, _mm_xor_si128(a, ones)));
+  }
+  AlphaOverGrayTail_u8(src, alpha, dst, x, width);
+}
+
+ROSEPETAL_TARGET_SSE42
+inline void AlphaOverPremulRow_u8_sse42(const uchar* src, uchar* dst, int width)
+{
+  const __m128i bcast = _mm_setr_epi32(ALPHA_BCAST_MASK);
+  const __m128i ones  = _mm_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 4; x += 4) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+    __m128i* p = reinterpret_cast<__m128i*>(dst + 4 * x);
+    _mm_storeu_si128(p, AlphaPremulMix_sse42(s, _mm_loadu_si128(p),
+                                             _mm_xor_si128(_mm_shuffle_epi8(s, bcast), ones)));
+  }
+  AlphaOverPremulTail_u8(src, dst, x, width);
+}
+
+ROSEPETAL_TARGET_AVX2 inline __m256i AlphaDiv255_avx2(__m256i t) {
+  t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+ROSEPETAL_TARGET_AVX2 inline __m256i AlphaMix_avx2(__m256i s, __m256i d, __m256i ws, __m256i wd) {
+  const __m256i z = _mm256_setzero_si256();
+  const __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, z), _mm256_unpacklo_epi8(ws, z)),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, z), _mm256_unpacklo_epi8(wd, z)));
+  const __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, z), _mm256_unpackhi_epi8(ws, z)),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, z), _mm256_unpackhi_epi8(wd, z)));
+  return _mm256_packus_epi16(AlphaDiv255_avx2(lo), AlphaDiv255_avx2(hi));
+}
+
+ROSEPETAL_TARGET_AVX2 inline __m256i AlphaPremulMix_avx2(__m256i s, __m256i d, __m256i wd) {
+  const __m256i z = _mm256_setzero_si256();
+  const __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(s, z),
+    AlphaDiv255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, z), _mm256_unpacklo_epi8(wd, z))));
+  const __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(s, z),
+    AlphaDiv255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, z), _mm256_unpackhi_epi8(wd, z))));
+  return _mm256_packus_epi16(lo, hi);
+}
+
+ROSEPETAL_TARGET_AVX2
+inline void AlphaOverRow_u8_avx2(const uchar* src, uchar* dst, int width, int dstCn)
+{
+  const __m256i bcast  = _mm256_setr_epi32(ALPHA_BCAST_MASK, ALPHA_BCAST_MASK);
+  const __m256i widen  = _mm256_setr_epi32(ALPHA_WIDEN_MASK, ALPHA_WIDEN_MASK);
+  const __m256i narrow = _mm256_setr_epi32(ALPHA_NARROW_MASK, ALPHA_NARROW_MASK);
+  const __m256i aLane  = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m256i ones   = _mm256_set1_epi8(-1);
+  // 8 pixels of a 3-channel row are 6 dwords; lane k takes pixels 4k..4k+3
+  const __m256i rows  = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+  const __m256i split = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+  const __m256i join  = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+  int x = 0;
+  for (; x <= width - 8; x += 8) {
+    const __m256i s  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+    const __m256i a  = _mm256_shuffle_epi8(s, bcast);
+    const __m256i ws = _mm256_or_si256(a, aLane), wd = _mm256_xor_si256(a, ones);
+    if (dstCn == 4) {
+      __m256i* p = reinterpret_cast<__m256i*>(dst + 4 * x);
+      _mm256_storeu_si256(p, AlphaMix_avx2(s, _mm256_loadu_si256(p), ws, wd));
+    } else {
+      int* p = reinterpret_cast<int*>(dst + 3 * x);
+      const __m256i d = _mm256_shuffle_epi8(
+        _mm256_permutevar8x32_epi32(_mm256_maskload_epi32(p, rows), split), widen);
+      _mm256_maskstore_epi32(p, rows, _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(AlphaMix_avx2(s, d, ws, wd), narrow), join));
+    }
+  }
+  AlphaOverTail_u8(src, dst, x, width, dstCn);
+}
+
+ROSEPETAL_TARGET_AVX2
+inline void AlphaOverGrayRow_u8_avx2(const uchar* src, const uchar* alpha, uchar* dst, int width)
+{
+  const __m256i ones = _mm256_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 32; x += 32) {
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alpha + x));
+    __m256i* p = reinterpret_cast<__m256i*>(dst + x);
+    _mm256_storeu_si256(p, AlphaMix_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x)),
+                                         _mm256_loadu_si256(p), a, _mm256_xor_si256(a, ones)));
+  }
+  AlphaOverGrayTail_u8(src, alpha, dst, x, width);
+}
+
+ROSEPETAL_TARGET_AVX2
+inline void AlphaOverPremulRow_u8_avx2(const uchar* src, uchar* dst, int width)
+{
+  const __m256i bcast = _mm256_setr_epi32(ALPHA_BCAST_MASK, ALPHA_BCAST_MASK);
+  const __m256i ones  = _mm256_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 8; x += 8) {
+    const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+    __m256i* p = reinterpret_cast<__m256i*>(dst + 4 * x);
+    _mm256_storeu_si256(p, AlphaPremulMix_avx2(s, _mm256_loadu_si256(p),
+                                               _mm256_xor_si256(_mm256_shuffle_epi8(s, bcast), ones)));
+  }
+  AlphaOverPremulTail_u8(src, dst, x, width);
+}
+
+// The 4 dwords of a mask in every lane (a function, so the mask macros expand)
+ROSEPETAL_TARGET_AVX512 inline __m512i AlphaLanes_avx512(int d0, int d1, int d2, int d3) {
+  return _mm512_setr4_epi32(d0, d1, d2, d3);
+}
+
+ROSEPETAL_TARGET_AVX512 inline __m512i AlphaDiv255_avx512(__m512i t) {
+  t = _mm512_add_epi16(t, _mm512_set1_epi16(128));
+  return _mm512_srli_epi16(_mm512_add_epi16(t, _mm512_srli_epi16(t, 8)), 8);
+}
+
+ROSEPETAL_TARGET_AVX512 inline __m512i AlphaMix_avx512(__m512i s, __m512i d, __m512i ws, __m512i wd) {
+  const __m512i z = _mm512_setzero_si512();
+  const __m512i lo = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(s, z), _mm512_unpacklo_epi8(ws, z)),
+                                      _mm512_mullo_epi16(_mm512_unpacklo_epi8(d, z), _mm512_unpacklo_epi8(wd, z)));
+  const __m512i hi = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(s, z), _mm512_unpackhi_epi8(ws, z)),
+                                      _mm512_mullo_epi16(_mm512_unpackhi_epi8(d, z), _mm512_unpackhi_epi8(wd, z)));
+  return _mm512_packus_epi16(AlphaDiv255_avx512(lo), AlphaDiv255_avx512(hi));
+}
+
+ROSEPETAL_TARGET_AVX512 inline __m512i AlphaPremulMix_avx512(__m512i s, __m512i d, __m512i wd) {
+  const __m512i z = _mm512_setzero_si512();
+  const __m512i lo = _mm512_add_epi16(_mm512_unpacklo_epi8(s, z),
+    AlphaDiv255_avx512(_mm512_mullo_epi16(_mm512_unpacklo_epi8(d, z), _mm512_unpacklo_epi8(wd, z))));
+  const __m512i hi = _mm512_add_epi16(_mm512_unpackhi_epi8(s, z),
+    AlphaDiv255_avx512(_mm512_mullo_epi16(_mm512_unpackhi_epi8(d, z), _mm512_unpackhi_epi8(wd, z))));
+  return _mm512_packus_epi16(lo, hi);
+}
+
+ROSEPETAL_TARGET_AVX512
+inline void AlphaOverRow_u8_avx512(const uchar* src, uchar* dst, int width, int dstCn)
+{
+  const __m512i bcast  = AlphaLanes_avx512(ALPHA_BCAST_MASK);
+  const __m512i widen  = AlphaLanes_avx512(ALPHA_WIDEN_MASK);
+  const __m512i narrow = AlphaLanes_avx512(ALPHA_NARROW_MASK);
+  const __m512i aLane  = _mm512_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m512i ones   = _mm512_set1_epi8(-1);
+  // 16 pixels of a 3-channel row are 48 bytes; lane k takes pixels 4k..4k+3
+  const __mmask64 rows = 0xFFFFFFFFFFFFull;
+  const __m512i split = _mm512_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12);
+  const __m512i join  = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 15, 15, 15, 15);
+  int x = 0;
+  for (; x <= width - 16; x += 16) {
+    const __m512i s  = _mm512_loadu_si512(src + 4 * x);
+    const __m512i a  = _mm512_shuffle_epi8(s, bcast);
+    const __m512i ws = _mm512_or_si512(a, aLane), wd = _mm512_xor_si512(a, ones);
+    if (dstCn == 4) {
+      uchar* p = dst + 4 * x;
+      _mm512_storeu_si512(p, AlphaMix_avx512(s, _mm512_loadu_si512(p), ws, wd));
+    } else {
+      uchar* p = dst + 3 * x;
+      const __m512i d = _mm512_shuffle_epi8(
+        _mm512_permutexvar_epi32(split, _mm512_maskz_loadu_epi8(rows, p)), widen);
+      _mm512_mask_storeu_epi8(p, rows, _mm512_permutexvar_epi32(
+        join, _mm512_shuffle_epi8(AlphaMix_avx512(s, d, ws, wd), narrow)));
+    }
+  }
+  AlphaOverTail_u8(src, dst, x, width, dstCn);
+}
+
+ROSEPETAL_TARGET_AVX512
+inline void AlphaOverGrayRow_u8_avx512(const uchar* src, const uchar* alpha, uchar* dst, int width)
+{
+  const __m512i ones = _mm512_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 64; x += 64) {
+    const __m512i a = _mm512_loadu_si512(alpha + x);
+    _mm512_storeu_si512(dst + x, AlphaMix_avx512(_mm512_loadu_si512(src + x), _mm512_loadu_si512(dst + x),
+                                                 a, _mm512_xor_si512(a, ones)));
+  }
+  AlphaOverGrayTail_u8(src, alpha, dst, x, width);
+}
+
+ROSEPETAL_TARGET_AVX512
+inline void AlphaOverPremulRow_u8_avx512(const uchar* src, uchar* dst, int width)
+{
+  const __m512i bcast = AlphaLanes_avx512(ALPHA_BCAST_MASK);
+  const __m512i ones  = _mm512_set1_epi8(-1);
+  int x = 0;
+  for (; x <= width - 16; x += 16) {
+    const __m512i s = _mm512_loadu_si512(src + 4 * x);
+    uchar* p = dst + 4 * x;
+    _mm512_storeu_si512(p, AlphaPremulMix_avx512(s, _mm512_loadu_si512(p),
+                                                 _mm512_xor_si512(_mm512_shuffle_epi8(s, bcast), ones)));
+  }
+  AlphaOverPremulTail_u8(src, dst, x, width);
+}
+
+#undef ALPHA_BCAST_MASK
+#undef ALPHA_WIDEN_MASK
+#undef ALPHA_NARROW_MASK
+#endif // ROSEPETAL_X86_SIMD
+
+/*──────────────────────── Mat-level entry points ─────────────────────*/
+// 8-bit row kernels as picked by PickSimd()
+using AlphaRowFn = void (*)(const uchar*, uchar*, int, int);
+using AlphaGrayRowFn = void (*)(const uchar*, const uchar*, uchar*, int);
+using AlphaPremulRowFn = void (*)(const uchar*, uchar*, int);
+
+// src: CV_8UC4 / CV_32FC4 straight alpha. dst: same depth and size,
+// 3 or 4 channels, usually a canvas ROI (written in place).
+// Rows are split with cv::parallel_for_ for large tiles.
+inline void AlphaOver(const cv::Mat& src, cv::Mat& dst)
+{
+  CV_Assert(src.size() == dst.size() && src.channels() == 4 &&
+            src.depth() == dst.depth() &&
+            (dst.channels() == 3 || dst.channels() == 4) &&
+            (src.depth() == CV_8U || src.depth() == CV_32F));
+
+  const int dstCn = dst.channels();
+  const bool isFloat = src.depth() == CV_32F;
+  const double nstripes = std::max(1, (src.rows * src.cols) >> 16);
+  const AlphaRowFn row = PickSimd<AlphaRowFn>(AlphaOverRow_u8,
+    SIMD_VARIANT(AlphaOverRow_u8_sse42), SIMD_VARIANT(AlphaOverRow_u8_avx2),
+    SIMD_VARIANT(AlphaOverRow_u8_avx512));
+
+  cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& r) {
+    for (int y = r.start; y < r.end; ++y) {
+      if (isFloat) AlphaOverRow_f32(src.ptr<float>(y), dst.ptr<float>(y), src.cols, dstCn);
+      else         row(src.ptr<uchar>(y), dst.ptr<uchar>(y), src.cols, dstCn);
+    }
+  }, nstripes);
+}
+
+// Gray variant: src and dst CV_8UC1, alpha CV_8UC1, all the same size.
+inline void AlphaOverGray(const cv::Mat& src, const cv::Mat& alpha, cv::Mat& dst)
+{
+  CV_Assert(src.size() == dst.size() && alpha.size() == src.size() &&
+            src.type() == CV_8UC1 && dst.type() == CV_8UC1 && alpha.type() == CV_8UC1);
+
+  const double nstripes = std::max(1, (src.rows * src.cols) >> 16);
+  const AlphaGrayRowFn row = PickSimd<AlphaGrayRowFn>(AlphaOverGrayRow_u8,
+    SIMD_VARIANT(AlphaOverGrayRow_u8_sse42), SIMD_VARIANT(AlphaOverGrayRow_u8_avx2),
+    SIMD_VARIANT(AlphaOverGrayRow_u8_avx512));
+  cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& r) {
+    for (int y = r.start; y < r.end; ++y) {
+      row(src.ptr<uchar>(y), alpha.ptr<uchar>(y), dst.ptr<uchar>(y), src.cols);
+    }
+  }, nstripes);
+}
+
+// Premultiplied variant: src and dst CV_8UC4 / CV_32FC4, same size.
+inline void AlphaOverPremul(const cv::Mat& src, cv::Mat& dst)
+{
+  CV_Assert(src.size() == dst.size() && src.type() == dst.type() &&
+            (src.type() == CV_8UC4 || src.type() == CV_32FC4));
+
+  const bool isFloat = src.depth() == CV_32F;
+  const double nstripes = std::max(1, (src.rows * src.cols) >> 16);
+  const AlphaPremulRowFn row = PickSimd<AlphaPremulRowFn>(AlphaOverPremulRow_u8,
+    SIMD_VARIANT(AlphaOverPremulRow_u8_sse42), SIMD_VARIANT(AlphaOverPremulRow_u8_avx2),
+    SIMD_VARIANT(AlphaOverPremulRow_u8_avx512));
+
+  cv::parallel_for_(cv::Range(0, src.rows), [&](const cv::Range& r) {
+    for (int y = r.start; y < r.end; ++y) {
+      if (isFloat) AlphaOverPremulRow_f32(src.ptr<float>(y), dst.ptr<float>(y), src.cols);
+      else         row(src.ptr<uchar>(y), dst.ptr<uchar>(y), src.cols);
+    }
+  }, nstripes);
+}
+
+#endif // ALPHA_BLEND_H
@@ -7,27 +7,6 @@
 enum class Direction { RIGHT, LEFT, UP, DOWN };
 enum class Strategy { RESIZE, PAD_START, PAD_END, PAD_BOTH };
 
-// Helper function to detect channel format for individual images
-std::string DetectChannelFormat(const Napi::Value& jsImg, const cv::Mat& mat) {
-  if (jsImg.IsObject() && !jsImg.IsBuffer()) {
-    Napi::Object obj = jsImg.As<Napi::Object>();
-    
-    // Check for new colorSpace field first
-    if (obj.Has("colorSpace")) {
-      return obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-    }
-    // Default based on channel count
-    else {
-      const int channels = mat.channels();
-      return (channels == 4) ? "BGRA" : (channels == 3) ? "BGR" : "GRAY";
-    }
-  } else {
-    // Buffer input - determine from OpenCV Mat
-    const int channels = mat.channels();
-    return (channels == 4) ? "BGRA" : (channels == 3) ? "BGR" : "GRAY";
-  }
-}
-
 // Helper function to determine the best output channel format from a list
 std::string DetermineOutputFormat(const std::vector<std::string>& channels) {
   bool hasRGBA = false, hasBGRA = false, hasRGB = false, hasBGR = false;
@@ -56,53 +35,48 @@ cv::Scalar PreparePadColor(const cv::Scalar& originalColor, const std::string& c
   return padColor;
 }
 
-// Helper function to convert image to target channel format
-cv::Mat ConvertToTargetFormat(const cv::Mat& src, const std::string& srcFormat, const std::string& targetFormat) {
-  if (srcFormat == targetFormat) {
-    return src; // No conversion needed
+// cvtColor code from srcFormat to targetFormat; -1 when the layouts match
+static int ConversionCode(const std::string& srcFormat, const std::string& targetFormat) {
+  if (srcFormat == targetFormat) return -1;
+
+  static const std::unordered_map<std::string, int> codes = {
+    { "GRAY>BGR",  cv::COLOR_GRAY2BGR },  { "GRAY>RGB",  cv::COLOR_GRAY2RGB },
+    { "GRAY>BGRA", cv::COLOR_GRAY2BGRA }, { "GRAY>RGBA", cv::COLOR_GRAY2RGBA },
+    { "BGR>RGB",   cv::COLOR_BGR2RGB },   { "RGB>BGR",   cv::COLOR_RGB2BGR },
+    { "BGR>BGRA",  cv::COLOR_BGR2BGRA },  { "BGR>RGBA",  cv::COLOR_BGR2RGBA },
+    { "RGB>RGBA",  cv::COLOR_RGB2RGBA },  { "RGB>BGRA",  cv::COLOR_RGB2BGRA },
+    { "BGRA>BGR",  cv::COLOR_BGRA2BGR },  { "RGBA>RGB",  cv::COLOR_RGBA2RGB },
+    { "BGRA>RGBA", cv::COLOR_BGRA2RGBA }, { "RGBA>BGRA", cv::COLOR_RGBA2BGRA },
+  };
+  auto it = codes.find(srcFormat + ">" + targetFormat);
+  if (it == codes.end()) {
+    throw std::runtime_error("concat: cannot convert " + srcFormat + " to " + targetFormat);
   }
-  
-  cv::Mat dst;
-  
-  // Convert to target format
-  if (srcFormat == "GRAY" && targetFormat == "BGR") {
-    cv::cvtColor(src, dst, cv::COLOR_GRAY2BGR);
-  } else if (srcFormat == "GRAY" && targetFormat == "RGB") {
-    cv::cvtColor(src, dst, cv::COLOR_GRAY2RGB);
-  } else if (srcFormat == "GRAY" && targetFormat == "BGRA") {
-    cv::cvtColor(src, dst, cv::COLOR_GRAY2BGRA);
-  } else if (srcFormat == "GRAY" && targetFormat == "RGBA") {
-    cv::cvtColor(src, dst, cv::COLOR_GRAY2RGBA);
-  } else if (srcFormat == "BGR" && targetFormat == "RGB") {
-    cv::cvtColor(src, dst, cv::COLOR_BGR2RGB);
-  } else if (srcFormat == "RGB" && targetFormat == "BGR") {
-    cv::cvtColor(src, dst, cv::COLOR_RGB2BGR);
-  } else if (srcFormat == "BGR" && targetFormat == "BGRA") {
-    cv::cvtColor(src, dst, cv::COLOR_BGR2BGRA);
-  } else if (srcFormat == "BGR" && targetFormat == "RGBA") {
-    cv::cvtColor(src, dst, cv::COLOR_BGR2RGBA);
-  } else if (srcFormat == "RGB" && targetFormat == "RGBA") {
-    cv::cvtColor(src, dst, cv::COLOR_RGB2RGBA);
-  } else if (srcFormat == "RGB" && targetFormat == "BGRA") {
-    cv::cvtColor(src, dst, cv::COLOR_RGB2BGRA);
-  } else if (srcFormat == "BGRA" && targetFormat == "BGR") {
-    cv::cvtColor(src, dst, cv::COLOR_BGRA2BGR);
-  } else if (srcFormat == "RGBA" && targetFormat == "RGB") {
-    cv::cvtColor(src, dst, cv::COLOR_RGBA2RGB);
-  } else if (srcFormat == "BGRA" && targetFormat == "RGBA") {
-    cv::cvtColor(src, dst, cv::COLOR_BGRA2RGBA);
-  } else if (srcFormat == "RGBA" && targetFormat == "BGRA") {
-    cv::cvtColor(src, dst, cv::COLOR_RGBA2BGRA);
+  return it->second;
+}
+
+static int ChannelCount(const std::string& format) {
+  if (format == "GRAY") return 1;
+  return format.size() == 4 ? 4 : 3;
+}
+
+// Resizes and converts `src` straight into `dst` (a ROI of the canvas that
+// already has the output size and type); at most one temporary
+static void DrawInto(const cv::Mat& src, int code, cv::Mat dst) {
+  if (src.size() == dst.size()) {
+    if (code < 0) src.copyTo(dst);
+    else cv::cvtColor(src, dst, code);
+  } else if (code < 0) {
+    cv::resize(src, dst, dst.size());
   } else {
-    // Fallback: return source if no conversion available
-    dst = src;
+    cv::Mat scaled;
+    cv::resize(src, scaled, dst.size());
+    cv::cvtColor(scaled, dst, code);
   }
-  
-  return dst;
 }
 
 /*------------------------------------------------------------------------*/
-class ConcatWorker final : public Napi::AsyncWorker {
+class ConcatWorker final : public EngineWorker {
 public:
   ConcatWorker(Napi::Function cb,
                const std::vector<Napi::Value>& jsImgs,
@@ -111,12 +85,14 @@ public:
                cv::Scalar padRGB,
                std::string outputFormat,
                int quality = 90,
-               bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+               EncodeOptions encodeOpts = {},
+               OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "concat"),
       padColorRGB(padRGB),
       outputFormat(std::move(outputFormat)),
       quality(quality),
-      pngOptimize(pngOptimize)
+      encodeOpts(encodeOpts),
+      outTarget(std::move(outTarget))
   {
     // Convert string enums to faster integer types
     if (dir == "right") direction = Direction::RIGHT;
@@ -129,147 +105,148 @@ public:
     else if (strat == "pad-end") strategy = Strategy::PAD_END;
     else strategy = Strategy::PAD_BOTH;
 
-    // Timing and conversion
-    const int64 t0 = cv::getTickCount();
-    const size_t imgCount = jsImgs.size();
-    mats.reserve(imgCount);
-    channels.reserve(imgCount);
-    
-    // Process all images and detect their channel formats
-    for (size_t i = 0; i < imgCount; ++i) {
-      mats.emplace_back(ConvertToMat(jsImgs[i]));
-      channels.push_back(DetectChannelFormat(jsImgs[i], mats[i]));
+    // Wrap inputs only; decoding happens on the worker thread
+    inputs.reserve(jsImgs.size());
+    for (const auto& jsImg : jsImgs) {
+      inputs.push_back(PrepareInput(jsImg));
     }
-    
+  }
+
+protected:
+  void Execute() override {
+    // Decode all inputs in parallel and detect their channel formats
+    convertMs = DecodeInputs(inputs);
+    mats.reserve(inputs.size());
+    channels.reserve(inputs.size());
+    for (const auto& in : inputs) {
+      mats.push_back(in.mat);
+      channels.push_back(in.colorSpace);
+    }
+
     // Determine output channel format
     outputChannel = DetermineOutputFormat(channels);
-    
-    convertMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
 
-    // Store original pad color (channel-specific preparation will be done per image)
-    padClrImg = padColorRGB;
-    
-    // Pre-calculate max dimensions after channel format detection
+    // Pre-calculate max dimensions
     // (dimensions shouldn't change with channel conversion)
     for (const auto& m : mats) {
       maxW = std::max(maxW, m.cols);
       maxH = std::max(maxH, m.rows);
     }
-  }
 
-protected:
-  void Execute() override {
     const int64 t0 = cv::getTickCount();
     
     const bool isHorizontal = (direction == Direction::RIGHT || direction == Direction::LEFT);
     const int baseSize = isHorizontal ? maxH : maxW;
-    
-    // Prepare tiles with optimized preprocessing
-    std::vector<cv::Mat> tiles;
-    tiles.reserve(mats.size());
-    
-    for (size_t i = 0; i < mats.size(); ++i) {
-      auto& m = mats[i];
-      const std::string& imgChannel = channels[i];
-      
-      // Convert image to target output format first
-      cv::Mat convertedMat = ConvertToTargetFormat(m, imgChannel, outputChannel);
-      cv::Mat processed;
-      
-      // Debug: log the converted image properties
-      // std::cout << "Image " << i << ": " << imgChannel << " -> " << outputChannel
-      //           << " size: " << convertedMat.cols << "x" << convertedMat.rows 
-      //           << " channels: " << convertedMat.channels() << " type: " << convertedMat.type() << std::endl;
-      
-      // Prepare pad color for the target output format
-      cv::Scalar imgPadColor = PreparePadColor(padColorRGB, outputChannel);
-      
-      // Directly handle resize case without branches
+    const int depth = mats.empty() ? CV_8U : mats[0].depth();
+    for (const auto& m : mats) {
+      if (m.depth() != depth) throw std::runtime_error("concat: all images must have the same bit depth");
+    }
+
+    // Layout first: each input gets a cell along the stacking axis and the
+    // rect its pixels land in (the rest of the cell is padding).
+    // LEFT / UP stack in reverse input order.
+    struct Tile { cv::Rect cell, image; };
+    std::vector<Tile> tiles(mats.size());
+    int offset = 0;
+    for (size_t k = 0; k < mats.size(); ++k) {
+      const bool reversed = direction == Direction::LEFT || direction == Direction::UP;
+      const size_t i = reversed ? mats.size() - 1 - k : k;
+      const cv::Mat& m = mats[i];
+
+      // Extent along the stacking axis and across it
+      int along = isHorizontal ? m.cols : m.rows;
+      int across = isHorizontal ? m.rows : m.cols;
+      int before = 0;
       if (strategy == Strategy::RESIZE) {
-        if (isHorizontal) {
-          double scale = static_cast<double>(baseSize) / convertedMat.rows;
-          cv::resize(convertedMat, processed, cv::Size(static_cast<int>(convertedMat.cols * scale), baseSize));
-        } else {
-          double scale = static_cast<double>(baseSize) / convertedMat.cols;
-          cv::resize(convertedMat, processed, cv::Size(baseSize, static_cast<int>(convertedMat.rows * scale)));
-        }
+        along = static_cast<int>(along * (static_cast<double>(baseSize) / across));
+        across = baseSize;
       } else {
-        // Handle padding cases
-        const int delta = isHorizontal ? (baseSize - convertedMat.rows) : (baseSize - convertedMat.cols);
-        if (delta <= 0) {
-          processed = convertedMat; // No padding needed
-        } else {
-          int before = 0, after = 0;
-          
-          switch (strategy) {
-            case Strategy::PAD_START:
-              before = delta;
-              break;
-            case Strategy::PAD_END:
-              after = delta;
-              break;
-            case Strategy::PAD_BOTH:
-              before = delta / 2;
-              after = delta - before;
-              break;
-            default: break;
-          }
-          
-          if (isHorizontal) {
-            cv::copyMakeBorder(convertedMat, processed, before, after, 0, 0, cv::BORDER_CONSTANT, imgPadColor);
-          } else {
-            cv::copyMakeBorder(convertedMat, processed, 0, 0, before, after, cv::BORDER_CONSTANT, imgPadColor);
-          }
-        }
+        const int delta = std::max(0, baseSize - across);
+        if (strategy == Strategy::PAD_START)     before = delta;
+        else if (strategy == Strategy::PAD_BOTH) before = delta / 2;
       }
-      
-      tiles.push_back(std::move(processed));
+
+      if (isHorizontal) {
+        tiles[i].cell  = cv::Rect(offset, 0, along, baseSize);
+        tiles[i].image = cv::Rect(offset, before, along, across);
+      } else {
+        tiles[i].cell  = cv::Rect(0, offset, baseSize, along);
+        tiles[i].image = cv::Rect(before, offset, across, along);
+      }
+      offset += along;
     }
 
-    // Perform concatenation based on direction
-    if (isHorizontal) {
-      cv::hconcat(tiles, result);
-      if (direction == Direction::LEFT) {
-        cv::flip(result, result, 1);
+    // One canvas; every input is resized / converted directly into its ROI
+    // and only the padding strips are painted, in parallel across inputs
+    const cv::Size canvas = isHorizontal ? cv::Size(offset, baseSize) : cv::Size(baseSize, offset);
+    result.create(canvas, CV_MAKETYPE(depth, ChannelCount(outputChannel)));
+    const cv::Scalar padColor = PreparePadColor(padColorRGB, outputChannel);
+
+    std::vector<std::string> errors(mats.size());
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(mats.size())), [&](const cv::Range& r) {
+      JobCountersScope scope(counters);
+      for (int i = r.start; i < r.end; ++i) {
+        const Tile& t = tiles[i];
+        try {
+          if (t.image != t.cell) {
+            const cv::Rect head = isHorizontal
+                ? cv::Rect(t.cell.x, 0, t.cell.width, t.image.y)
+                : cv::Rect(0, t.cell.y, t.image.x, t.cell.height);
+            const cv::Rect tail = isHorizontal
+                ? cv::Rect(t.cell.x, t.image.br().y, t.cell.width, t.cell.br().y - t.image.br().y)
+                : cv::Rect(t.image.br().x, t.cell.y, t.cell.br().x - t.image.br().x, t.cell.height);
+            if (!head.empty()) result(head).setTo(padColor);
+            if (!tail.empty()) result(tail).setTo(padColor);
+          }
+          if (!t.image.empty()) {
+            DrawInto(mats[i], ConversionCode(channels[i], outputChannel), result(t.image));
+          }
+        } catch (const std::exception& e) {
+          errors[i] = e.what();
+        }
       }
-    } else {
-      if (direction == Direction::UP) {
-        std::reverse(tiles.begin(), tiles.end());
+    });
+    for (size_t i = 0; i < errors.size(); ++i) {
+      if (!errors[i].empty()) {
+        CheckJob("encoding");
+        throw std::runtime_error("Image " + std::to_string(i) + ": " + errors[i]);
       }
-      cv::vconcat(tiles, result);
     }
 
     taskMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
 
     // Multi-format encoding if needed
     if (outputFormat != "raw") {
-      cv::Mat tmp = ToBgrForJpg(result, outputChannel);
-      encodeMs = EncodeToFormat(tmp, encodedBuf, outputFormat, quality, pngOptimize);
+      encodeMs = EncodeImage(result, outputChannel, encodedBuf, outputFormat, quality, encodeOpts);
     }
+    outTarget.Capture(outputFormat, result, encodedBuf, outputChannel);
   }
 
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value jsImg = (outputFormat != "raw") ? VectorToBuffer(env, std::move(encodedBuf))
-                                                 : MatToRawJS(env, result, outputChannel);
+    Napi::Value jsImg = outTarget.ToJS(env, outputFormat, result, outputChannel, encodedBuf);
 
     Napi::Object out = Napi::Object::New(env);
     out.Set("image", jsImg);
-    out.Set("timing", MakeTimingJS(env, convertMs, taskMs, encodeMs));
+    out.Set("timing", TimingJS(convertMs, taskMs, encodeMs));
+    outTarget.AttachPreview(out);
     Callback().Call({env.Null(), out});
   }
 
 private:
+  std::vector<InputImage> inputs;
   std::vector<cv::Mat> mats;
   std::vector<std::string> channels;
   cv::Mat result;
   Direction direction;
   Strategy strategy;
   std::string outputChannel;
-  cv::Scalar padColorRGB, padClrImg;
+  cv::Scalar padColorRGB;
   std::string outputFormat;
   int quality;
-  bool pngOptimize;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
   double convertMs = 0, taskMs = 0, encodeMs = 0;
   std::vector<uchar> encodedBuf;
   int maxW = 0, maxH = 0;
@@ -305,7 +282,9 @@ Napi::Value Concat(const Napi::CallbackInfo& info) {
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
   size_t cbIdx = 4;
   
   if (info.Length() >= 6) {
@@ -319,11 +298,13 @@ Napi::Value Concat(const Napi::CallbackInfo& info) {
   }
   
   if (info.Length() == 8) {
-    pngOptimize = info[6].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[6]);
+    job        = ParseJobOptions(info[6]);
+    outTarget  = ParseOutputTarget(info[6]);
     cbIdx = 7;
   }
 
   // Create and queue worker
-  (new ConcatWorker(info[cbIdx].As<Napi::Function>(), raw, dir, st, pad, outputFormat, quality, pngOptimize))->Queue();
+  (new ConcatWorker(info[cbIdx].As<Napi::Function>(), raw, dir, st, pad, outputFormat, quality, encodeOpts, std::move(outTarget)))->Queue(job);
   return env.Undefined();
 }
\ No newline at end of file
@@ -2,83 +2,221 @@
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
 #include "utils.h"          // ConvertToMat, ToBgrForJpg, EncodeToJpgFast…
+#include "ops.h"
+#include "codecs/jpeg-strips.h"
+
+/*──────────────────────── core op (shared with pipeline) ─────────────*/
+cv::Rect ResolveCropRect(const cv::Size& src, const CropParams& p)
+{
+  const int W=src.width, H=src.height;
+  int x = p.normalized? int(std::round(p.x*W)) : int(std::lround(p.x));
+  int y = p.normalized? int(std::round(p.y*H)) : int(std::lround(p.y));
+  int width = p.normalized? int(std::round(p.width*W)) : int(std::lround(p.width));
+  int height = p.normalized? int(std::round(p.height*H)) : int(std::lround(p.height));
+
+  // Clamp position and dimensions to valid ranges
+  x = std::clamp(x, 0, W-1);
+  y = std::clamp(y, 0, H-1);
+  width = std::clamp(width, 1, W-x);   // Ensure width doesn't exceed image boundary
+  height = std::clamp(height, 1, H-y); // Ensure height doesn't exceed image boundary
+
+  return cv::Rect(x, y, width, height);
+}
+
+cv::Mat ApplyCrop(const cv::Mat& src, const CropParams& p)
+{
+  return src(ResolveCropRect(src.size(), p));          // view, no copy
+}
+
+/*──────────────────────── region decode ──────────────────────────────*/
+// Encoded JPEGs whose crops cover a small part of the frame only decode
+// those regions (DecodeJpegRegion, src/codecs/jpeg-strips.h). Rectangles
+// that overlap or lie within kBandGap of each other share one band. A band
+// still entropy-decodes every row above its bottom edge across the whole
+// width, so the region path is taken only when that plus the bands' own
+// pixels stays well under a full decode. A frame already in the decode
+// cache (fan-out flows) is cropped from the cached Mat instead; region
+// decodes themselves are not cached.
+namespace {
+
+constexpr int kBandGap = 16;                 // one MCU
+constexpr double kEntropyShare = 0.35;       // Huffman part of a full decode
+constexpr double kMaxRegionCost = 0.75;      // of a full decode
+
+std::vector<cv::Rect> MergeBands(std::vector<cv::Rect> bands)
+{
+  for (bool merged = true; merged; ) {
+    merged = false;
+    for (size_t a = 0; a < bands.size() && !merged; ++a) {
+      const cv::Rect grown(bands[a].x - kBandGap, bands[a].y - kBandGap,
+                           bands[a].width + 2 * kBandGap, bands[a].height + 2 * kBandGap);
+      for (size_t b = a + 1; b < bands.size(); ++b) {
+        if ((grown & bands[b]).area() > 0) {
+          bands[a] |= bands[b];
+          bands.erase(bands.begin() + b);
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+  return bands;
+}
+
+#ifdef HAVE_JPEG_STRIPS
+// Region decode of the bands around `rects`; false when that would cost
+// too much or the decoder fails
+bool DecodeRegions(const InputImage& in, const cv::Size& full,
+                   const std::vector<CropParams>& rects, std::vector<cv::Mat>& crops)
+{
+  std::vector<cv::Rect> boxes;
+  boxes.reserve(rects.size());
+  for (const CropParams& p : rects) boxes.push_back(ResolveCropRect(full, p));
+  const std::vector<cv::Rect> bands = MergeBands(boxes);
+
+  double cost = 0.0;
+  for (const cv::Rect& b : bands) {
+    cost += kEntropyShare * double(b.y + b.height) * full.width + (1.0 - kEntropyShare) * double(b.area());
+  }
+  if (cost > kMaxRegionCost * double(full.area())) return false;
+
+  std::vector<cv::Mat> decoded(bands.size());
+  for (size_t b = 0; b < bands.size(); ++b) {
+    std::string error;
+    if (!DecodeJpegRegion(in.encoded, in.encodedSize, bands[b], decoded[b], error)) return false;
+  }
+
+  crops.assign(boxes.size(), cv::Mat());
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    for (size_t b = 0; b < bands.size(); ++b) {
+      if ((bands[b] & boxes[i]) != boxes[i]) continue;
+      crops[i] = decoded[b](cv::Rect(boxes[i].x - bands[b].x, boxes[i].y - bands[b].y,
+                                     boxes[i].width, boxes[i].height));
+      break;
+    }
+  }
+  return true;
+}
+#endif
+
+}  // namespace
+
+// Worker thread. Decodes only what `rects` need from `in` (or takes the
+// frame from the decode cache): crops[i] is then a view of rect i, `ms` the
+// decode time, and the input counts as decoded. false → nothing done (not a
+// JPEG, crops too large, decoder error): decode the whole frame.
+static bool DecodeCropRegions(InputImage& in, const std::vector<CropParams>& rects,
+                              std::vector<cv::Mat>& crops, double& ms)
+{
+#ifdef HAVE_JPEG_STRIPS
+  cv::Size full;
+  int components = 0;
+  if (!in.IsEncoded() || rects.empty() ||
+      !ProbeJpegSize(in.encoded, in.encodedSize, full, components) ||
+      (components != 1 && components != 3)) {
+    return false;
+  }
+
+  const int64 t0 = cv::getTickCount();
+  DecodeCache& cache = DecodeCache::Instance();
+  cv::Mat cached = cache.Peek(in.encoded, in.encodedSize, cv::IMREAD_UNCHANGED);
+  if (!cached.empty()) {
+    CountDecodeCache(true);
+    in.mat = cached;
+    in.shared = true;
+    crops.clear();
+    for (const CropParams& p : rects) crops.push_back(ApplyCrop(in.mat, p));
+  } else if (!DecodeRegions(in, full, rects, crops)) {
+    return false;
+  }
+
+  if (in.colorSpace.empty()) in.colorSpace = components == 1 ? "GRAY" : "BGR";
+  in.sourceSize = full;
+  ms = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+  CountInput(in.encodedSize, ms, true);
+  in.encoded = nullptr;
+  CheckJob("processing");
+  return true;
+#else
+  (void)in; (void)rects; (void)crops; (void)ms;
+  return false;
+#endif
+}
 
 /*────────────────────────── Worker ───────────────────────────────────*/
-class CropWorker : public Napi::AsyncWorker {
+class CropWorker : public EngineWorker {
 public:
   CropWorker(Napi::Function cb,
              const Napi::Value& imgVal,
              double x,double y,double width,double height,
-             bool normalized,std::string outputFormat,int quality = 90,bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+             bool normalized,std::string outputFormat,int quality = 90,EncodeOptions encodeOpts = {},
+             OutputTarget outTarget = OutputTarget(),
+             StreamMode streamMode = StreamMode::OFF)
+    : EngineWorker(cb, "crop"),
       x_(x),y_(y),width_(width),height_(height),
-      normalized_(normalized),outputFormat_(std::move(outputFormat)),quality_(quality),pngOptimize_(pngOptimize)
+      normalized_(normalized),outputFormat_(std::move(outputFormat)),quality_(quality),encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget)),
+      streamMode_(streamMode)
   {
-    /* ─ medir convertMs ─ */
-    const int64 t0 = cv::getTickCount();
-    input_ = ConvertToMat(imgVal);                    // zero-copy
-    convertMs_ = (cv::getTickCount()-t0)/cv::getTickFrequency()*1e3;
-
-    if (imgVal.IsObject() && !imgVal.IsBuffer()) {
-      Napi::Object obj = imgVal.As<Napi::Object>();
-      
-      // Check for colorSpace field
-      if (obj.Has("colorSpace")) {
-        channel_ = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-      }
-      // Default based on channel count
-      else {
-        channel_ = (input_.channels() == 4) ? "BGRA"
-                 : (input_.channels() == 3) ? "BGR" 
-                 : "GRAY";
-      }
-    } else {
-      // Buffer input - determine from OpenCV Mat
-      channel_ = (input_.channels() == 4) ? "BGRA"
-               : (input_.channels() == 3) ? "BGR"
-               : "GRAY";
-    }
+    input_ = PrepareInput(imgVal);                    // decode deferred to Execute()
   }
 
 protected:
   void Execute() override {
-    /* ─ medir taskMs (recorte) ─ */
-    const int64 t0 = cv::getTickCount();
+    /* ─ JPEG muy grande: sólo se decodifican las filas / columnas del recorte ─ */
+    if (ShouldStream(input_, streamMode_)) {
+      StreamResult s;
+      StreamCrop(input_, { x_, y_, width_, height_, normalized_ }, outputFormat_, quality_, s);
+      convertMs_ = s.decodeMs;
+      taskMs_ = s.taskMs;
+      channel_ = s.colorSpace;
+      result_ = s.mat;
+      if (s.encodedDone) {
+        encodedBuf_ = std::move(s.encoded);
+        encodeMs_ = s.encodeMs;
+      } else if (outputFormat_ != "raw") {
+        encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
+      }
+      out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
+      return;
+    }
 
-    const int W=input_.cols, H=input_.rows;
-    int x = normalized_? int(std::round(x_*W)) : int(std::lround(x_));
-    int y = normalized_? int(std::round(y_*H)) : int(std::lround(y_));
-    int width = normalized_? int(std::round(width_*W)) : int(std::lround(width_));
-    int height = normalized_? int(std::round(height_*H)) : int(std::lround(height_));
+    /* ─ JPEG con recorte pequeño: sólo se decodifica la región ─ */
+    std::vector<cv::Mat> crops;
+    if (DecodeCropRegions(input_, { { x_, y_, width_, height_, normalized_ } }, crops, convertMs_)) {
+      result_ = crops[0];
+    } else {
+      /* ─ medir convertMs (decode en el hilo de trabajo) ─ */
+      convertMs_ = DecodeInput(input_);
 
-    // Clamp position and dimensions to valid ranges
-    x = std::clamp(x, 0, W-1);
-    y = std::clamp(y, 0, H-1);
-    width = std::clamp(width, 1, W-x);   // Ensure width doesn't exceed image boundary
-    height = std::clamp(height, 1, H-y); // Ensure height doesn't exceed image boundary
+      /* ─ medir taskMs (recorte) ─ */
+      const int64 t0 = cv::getTickCount();
 
-    result_ = input_(cv::Rect(x, y, width, height));
+      result_ = ApplyCrop(input_.mat, { x_, y_, width_, height_, normalized_ });
 
-    taskMs_ = (cv::getTickCount()-t0)/cv::getTickFrequency()*1e3;
+      taskMs_ = (cv::getTickCount()-t0)/cv::getTickFrequency()*1e3;
+    }
+    channel_ = input_.colorSpace;
 
     /* ─ Multi-format encoding (encodeMs) ─ */
     if(outputFormat_ != "raw"){
-      const cv::Mat& srcForEncoding = (channel_=="BGR")? result_
-                         : ToBgrForJpg(result_,channel_);
-      encodeMs_ = EncodeToFormat(srcForEncoding, encodedBuf_, outputFormat_, quality_, pngOptimize_);
+      encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
     }
+    out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
   }
 
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value jsImg = (outputFormat_ != "raw")
-        ? VectorToBuffer(env,std::move(encodedBuf_))        // 0-copy
-        : MatToRawJS(env,result_.clone(),channel_);         // contiguo
+    Napi::Value jsImg = out_.ToJS(env,outputFormat_,result_,channel_,encodedBuf_);   // 0-copy; clona sólo si no es contiguo
 
     Napi::Object out = Napi::Object::New(env);
     out.Set("image",  jsImg);
-    out.Set("timing", MakeTimingJS(env,convertMs_,taskMs_,encodeMs_));
+    out.Set("timing", TimingJS(convertMs_,taskMs_,encodeMs_));
+    out_.AttachPreview(out);
     Callback().Call({ env.Null(), out });
   }
 
@@ -87,12 +225,15 @@ protected:
   }
 
 private:
-  cv::Mat input_, result_;
+  InputImage input_;
+  cv::Mat result_;
   double x_, y_, width_, height_;
   bool   normalized_;
   std::string outputFormat_;
   int quality_;
-  bool pngOptimize_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
+  StreamMode streamMode_;
   std::string channel_;
 
   double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
@@ -118,7 +259,10 @@ Napi::Value Crop(const Napi::CallbackInfo& info)
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
+  StreamMode streamMode = StreamMode::OFF;
   
   if (info.Length() >= 8) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -129,11 +273,279 @@ Napi::Value Crop(const Napi::CallbackInfo& info)
   }
   
   if (info.Length() == 10) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    streamMode = ParseStreamMode(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
   
   Napi::Function cb = info[i].As<Napi::Function>();
 
-  (new CropWorker(cb,img,x,y,width,height,norm,outputFormat,quality,pngOptimize))->Queue();
+  (new CropWorker(cb,img,x,y,width,height,norm,outputFormat,quality,encodeOpts,std::move(outTarget),streamMode))->Queue(job);
+  return env.Undefined();
+}
+
+/*────────────────────────── Multi-ROI worker ─────────────────────────*/
+// cropMany: every frame is decoded once (only the bands around its ROIs
+// when that is cheaper, see DecodeCropRegions), all its ROIs are sliced as
+// views and resized/encoded in parallel. Single image → rects[]; array of images
+// → rects[][] (one detection list per frame).
+struct CropManyOptions {
+  bool normalized = false;
+  std::string outputFormat = "raw";
+  int quality = 90;
+  EncodeOptions encodeOpts;
+  bool resize = false;
+  ResizeParams resizeTo{ "set", std::numeric_limits<double>::quiet_NaN(),
+                         "set", std::numeric_limits<double>::quiet_NaN() };
+};
+
+class CropManyWorker : public EngineWorker {
+public:
+  CropManyWorker(Napi::Function cb,
+                 const Napi::Value& imagesVal,
+                 const Napi::Array& rectsVal,
+                 CropManyOptions opts,
+                 const Napi::Value& optsVal)
+    : EngineWorker(cb, "cropMany"),
+      batched_(imagesVal.IsArray()),
+      opts_(std::move(opts))
+  {
+    Napi::Env env = imagesVal.Env();
+
+    if (!batched_) {
+      inputs_.push_back(PrepareInput(imagesVal));
+      AddRects(env, rectsVal, 0);
+      AttachOutputs(optsVal);
+      return;
+    }
+
+    Napi::Array images = imagesVal.As<Napi::Array>();
+    if (rectsVal.Length() != images.Length()) {
+      throw Napi::TypeError::New(env,
+        "cropMany: rects must have one list per image (" +
+        std::to_string(images.Length()) + " images, " +
+        std::to_string(rectsVal.Length()) + " lists)");
+    }
+    for (uint32_t i = 0; i < images.Length(); ++i) {
+      inputs_.push_back(PrepareInput(images.Get(i)));
+      Napi::Value list = rectsVal.Get(i);
+      if (!list.IsArray()) {
+        throw Napi::TypeError::New(env, "cropMany: rects[" + std::to_string(i) + "] must be an array");
+      }
+      AddRects(env, list.As<Napi::Array>(), static_cast<int>(i));
+    }
+    AttachOutputs(optsVal);
+  }
+
+protected:
+  void Execute() override {
+    /* ─ convertMs: one decode per frame, frames in parallel ─ */
+    DecodeFrames();
+
+    /* ─ taskMs / encodeMs: every ROI is independent ─ */
+    std::vector<std::string> errors(jobs_.size());
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(jobs_.size())),
+      [&](const cv::Range& r) {
+        JobCountersScope scope(counters);
+        for (int j = r.start; j < r.end; ++j) {
+          try { ProcessJob(jobs_[j]); }
+          catch (const std::exception& e) { errors[j] = e.what(); }
+        }
+      });
+
+    for (size_t j = 0; j < errors.size(); ++j) {
+      if (!errors[j].empty()) {
+        CheckJob("encoding");
+        throw std::runtime_error("Crop " + std::to_string(j) + ": " + errors[j]);
+      }
+    }
+    for (const auto& job : jobs_) {
+      taskMs_   += job.taskMs;
+      encodeMs_ += job.encodeMs;
+    }
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+
+    std::vector<Napi::Array> lists;
+    lists.reserve(inputs_.size());
+    for (size_t i = 0; i < inputs_.size(); ++i) {
+      lists.push_back(Napi::Array::New(env, perImage_[i]));
+    }
+    std::vector<uint32_t> next(inputs_.size(), 0);
+
+    for (auto& job : jobs_) {
+      Napi::Value jsImg = job.out.ToJS(env, opts_.outputFormat, job.result,
+                                       inputs_[job.image].colorSpace, job.encoded);
+      lists[job.image].Set(next[job.image]++, jsImg);
+    }
+
+    Napi::Value images;
+    if (batched_) {
+      Napi::Array all = Napi::Array::New(env, lists.size());
+      for (size_t i = 0; i < lists.size(); ++i) all.Set(static_cast<uint32_t>(i), lists[i]);
+      images = all;
+    } else {
+      images = lists[0];
+    }
+
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("images", images);
+    out.Set("timing", TimingJS(convertMs_, taskMs_, encodeMs_));
+    if (!jobs_.empty()) jobs_[0].out.AttachPreview(out);
+    Callback().Call({ env.Null(), out });
+  }
+
+  void OnError(const Napi::Error& e) override {
+    Callback().Call({ e.Value(), Env().Null() });
+  }
+
+private:
+  struct Job {
+    int image;
+    CropParams rect;
+    cv::Mat region;          // set when the frame was region-decoded
+    cv::Mat result;
+    std::vector<uchar> encoded;
+    OutputTarget out;
+    double taskMs = 0.0, encodeMs = 0.0;
+  };
+
+  // options.out: one Buffer per crop, in the (flattened) output order
+  void AttachOutputs(const Napi::Value& optsVal) {
+    std::vector<OutputTarget> targets = ParseOutputTargets(optsVal, jobs_.size());
+    for (size_t j = 0; j < jobs_.size(); ++j) jobs_[j].out = std::move(targets[j]);
+  }
+
+  void AddRects(Napi::Env env, const Napi::Array& rects, int image) {
+    perImage_.push_back(rects.Length());
+    for (uint32_t k = 0; k < rects.Length(); ++k) {
+      Napi::Value v = rects.Get(k);
+      // Each field a finite Number: NaN / Infinity would reach the int
+      // conversions of ResolveCropRect
+      double f[4];
+      bool valid = v.IsObject();
+      const char* keys[4] = { "x", "y", "width", "height" };
+      for (int i = 0; valid && i < 4; ++i) {
+        Napi::Value field = v.As<Napi::Object>().Get(keys[i]);
+        valid = field.IsNumber() && std::isfinite(f[i] = field.As<Napi::Number>().DoubleValue());
+      }
+      if (!valid) {
+        throw Napi::TypeError::New(env, "cropMany: rect " + std::to_string(k) + " must be {x,y,width,height}");
+      }
+      Job job;
+      job.image = image;
+      job.rect = { f[0], f[1], f[2], f[3], opts_.normalized };
+      jobs_.push_back(std::move(job));
+    }
+  }
+
+  // Region decode per frame when it pays off, full decode otherwise;
+  // frames without ROIs are not decoded at all
+  void DecodeFrames() {
+    const int64 t0 = cv::getTickCount();
+    std::vector<std::vector<size_t>> byImage(inputs_.size());
+    for (size_t j = 0; j < jobs_.size(); ++j) byImage[jobs_[j].image].push_back(j);
+
+    std::vector<std::string> errors(inputs_.size());
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(inputs_.size())),
+      [&](const cv::Range& r) {
+        JobCountersScope scope(counters);
+        for (int i = r.start; i < r.end; ++i) {
+          if (byImage[i].empty()) continue;
+          try {
+            std::vector<CropParams> rects;
+            for (size_t j : byImage[i]) rects.push_back(jobs_[j].rect);
+            std::vector<cv::Mat> crops;
+            double ms = 0.0;
+            if (DecodeCropRegions(inputs_[i], rects, crops, ms)) {
+              for (size_t k = 0; k < crops.size(); ++k) jobs_[byImage[i][k]].region = crops[k];
+            } else {
+              DecodeInput(inputs_[i]);
+            }
+          } catch (const std::exception& e) { errors[i] = e.what(); }
+        }
+      });
+    for (size_t i = 0; i < errors.size(); ++i) {
+      if (!errors[i].empty()) {
+        CheckJob("processing");
+        throw std::runtime_error("Image " + std::to_string(i) + ": " + errors[i]);
+      }
+    }
+    convertMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+  }
+
+  void ProcessJob(Job& job) {
+    const InputImage& in = inputs_[job.image];
+
+    const int64 t0 = cv::getTickCount();
+    cv::Mat roi = job.region.empty() ? ApplyCrop(in.mat, job.rect)    // view
+                                     : job.region;                    // region decode
+    if (opts_.resize) {
+      roi = ApplyResize(roi, opts_.resizeTo);
+    } else if (opts_.outputFormat == "raw" && (!roi.isContinuous() || roi.u == nullptr)) {
+      roi = roi.clone();     // do the copy here, not in OnOK on the JS thread
+    }
+    job.result = roi;
+    job.taskMs = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+
+    if (opts_.outputFormat != "raw") {
+      job.encodeMs = EncodeImage(job.result, in.colorSpace, job.encoded,
+                                 opts_.outputFormat, opts_.quality, opts_.encodeOpts);
+    }
+    job.out.Capture(opts_.outputFormat, job.result, job.encoded, in.colorSpace);
+  }
+
+  std::vector<InputImage> inputs_;
+  std::vector<uint32_t> perImage_;      // rect count per frame
+  std::vector<Job> jobs_;
+  bool batched_;
+  CropManyOptions opts_;
+
+  double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
+};
+
+/*──────── binding: cropMany(image|images, rects|rects[], [options], callback) ─*/
+// options: { normalized, outputFormat, quality, pngOptimize | pngMode,
+//            webpMethod, webpLossless, webpThreads, out: Buffer[],
+//            resize: { width, height } }   (missing side = Auto)
+Napi::Value CropMany(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 3 || info.Length() > 4 || !info[1].IsArray() ||
+      !info[info.Length()-1].IsFunction()) {
+    Napi::TypeError::New(env,
+      "cropMany(image|images, rects|rects[], [options], callback)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  CropManyOptions opts;
+  if (info.Length() == 4 && info[2].IsObject()) {
+    Napi::Object o = info[2].As<Napi::Object>();
+    if (o.Has("normalized"))   opts.normalized   = o.Get("normalized").ToBoolean().Value();
+    if (o.Has("outputFormat")) opts.outputFormat = o.Get("outputFormat").As<Napi::String>().Utf8Value();
+    if (o.Has("quality"))      opts.quality      = o.Get("quality").ToNumber().Int32Value();
+    opts.encodeOpts = ParseEncodeOptions(o);        // pngOptimize / pngMode / webp*
+    if (o.Has("resize") && o.Get("resize").IsObject()) {
+      Napi::Object r = o.Get("resize").As<Napi::Object>();
+      if (r.Has("width") && r.Get("width").IsNumber()) {
+        opts.resizeTo.widthValue = r.Get("width").As<Napi::Number>().DoubleValue();
+        opts.resize = true;
+      }
+      if (r.Has("height") && r.Get("height").IsNumber()) {
+        opts.resizeTo.heightValue = r.Get("height").As<Napi::Number>().DoubleValue();
+        opts.resize = true;
+      }
+    }
+  }
+
+  Napi::Function cb = info[info.Length()-1].As<Napi::Function>();
+  Napi::Value optsVal = (info.Length() == 4) ? info[2] : env.Undefined();
+  (new CropManyWorker(cb, info[0], info[1].As<Napi::Array>(), std::move(opts), optsVal))
+      ->Queue(ParseJobOptions(optsVal));
   return env.Undefined();
 }
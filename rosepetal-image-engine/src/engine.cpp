@@ -0,0 +1,251 @@
+// ───────── src/engine.cpp ────────────────────────────────────────────────
+// configure() / stats(): synchronous control and statistics of the engine
+// worker pool (src/runtime/worker-pool.h, src/runtime/metrics.h), of the
+// frame pool's idle limit (src/memory/frame-pool.h), of the OpenCL device
+// dispatch (src/runtime/device.h) and of the SIMD kernel level
+// (src/runtime/cpu-dispatch.h).
+#include <napi.h>
+#include <algorithm>
+#include <string>
+#include "codecs/decode-cache.h"
+#include "geometry/remap-cache.h"
+#include "memory/frame-pool.h"
+#include "runtime/cpu-dispatch.h"
+#include "runtime/device.h"
+#include "runtime/metrics.h"
+#include "runtime/worker-pool.h"
+
+static const char* DeviceModeName(ComputeDevice::Mode m) {
+  switch (m) {
+    case ComputeDevice::Mode::GPU:  return "gpu";
+    case ComputeDevice::Mode::AUTO: return "auto";
+    default:                        return "cpu";
+  }
+}
+
+static Napi::Object ConfigToJS(Napi::Env env, const EngineThreadPool::Config& c,
+                               const ComputeDevice::Config& d) {
+  Napi::Object o = Napi::Object::New(env);
+  o.Set("threads",       Napi::Number::New(env, c.threads));
+  o.Set("queueLimit",    Napi::Number::New(env, static_cast<double>(c.queueLimit)));
+  o.Set("queuePolicy",   Napi::String::New(env,
+                           c.policy == EngineThreadPool::Policy::SHED ? "shed" : "reject"));
+  o.Set("opencvThreads", Napi::Number::New(env, c.opencvThreads));
+  o.Set("framePoolMB",   Napi::Number::New(env,
+                           static_cast<double>(FramePool::Instance().GetStats().idleLimit >> 20)));
+  o.Set("device",        Napi::String::New(env, DeviceModeName(d.mode)));
+
+  Napi::Object minPixels = Napi::Object::New(env);
+  for (int i = 0; i < ComputeDevice::kOps; ++i) {
+    minPixels.Set(GpuOpName(static_cast<GpuOp>(i)), Napi::Number::New(env, d.minPixels[i]));
+  }
+  o.Set("gpuMinPixels",  minPixels);
+  return o;
+}
+
+/*──────── binding: configure([{ threads, queueLimit, queuePolicy, opencvThreads, framePoolMB, device, gpuMinPixels }]) → config ─*/
+// Missing keys keep their value (opencvThreads is re-derived from threads
+// unless given). queueLimit 0 = unbounded; queuePolicy "reject" | "shed".
+// framePoolMB = idle frame memory kept for reuse (0 disables); lowering it
+// frees the cached blocks above the new limit.
+// device "cpu" | "gpu" | "auto"; gpuMinPixels { resize, rotate, filter,
+// blend, mosaic } = image size from which "auto" offloads that op.
+Napi::Value Configure(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  EngineThreadPool& pool = EngineThreadPool::Instance();
+  ComputeDevice& device = ComputeDevice::Instance();
+
+  if (info.Length() == 0 || info[0].IsUndefined()) {
+    return ConfigToJS(env, pool.GetConfig(), device.GetConfig());
+  }
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env,
+      "configure({ threads, queueLimit, queuePolicy, opencvThreads, framePoolMB, device, gpuMinPixels })")
+      .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Object o = info[0].As<Napi::Object>();
+  auto getInt = [&](const char* key, long def) -> long {
+    return (o.Has(key) && o.Get(key).IsNumber()) ? o.Get(key).ToNumber().Int64Value() : def;
+  };
+
+  int policy = -1;
+  if (o.Has("queuePolicy") && o.Get("queuePolicy").IsString()) {
+    const std::string p = o.Get("queuePolicy").As<Napi::String>().Utf8Value();
+    if (p == "reject")    policy = static_cast<int>(EngineThreadPool::Policy::REJECT);
+    else if (p == "shed") policy = static_cast<int>(EngineThreadPool::Policy::SHED);
+    else {
+      Napi::TypeError::New(env, "queuePolicy must be 'reject' or 'shed'").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+  }
+
+  int mode = -1;
+  if (o.Has("device") && o.Get("device").IsString()) {
+    const std::string d = o.Get("device").As<Napi::String>().Utf8Value();
+    if (d == "cpu")       mode = static_cast<int>(ComputeDevice::Mode::CPU);
+    else if (d == "gpu")  mode = static_cast<int>(ComputeDevice::Mode::GPU);
+    else if (d == "auto") mode = static_cast<int>(ComputeDevice::Mode::AUTO);
+    else {
+      Napi::TypeError::New(env, "device must be 'cpu', 'gpu' or 'auto'").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+  }
+
+  double minPixels[ComputeDevice::kOps];
+  for (double& v : minPixels) v = -1;
+  if (o.Has("gpuMinPixels") && o.Get("gpuMinPixels").IsObject()) {
+    Napi::Object t = o.Get("gpuMinPixels").As<Napi::Object>();
+    for (int i = 0; i < ComputeDevice::kOps; ++i) {
+      const char* name = GpuOpName(static_cast<GpuOp>(i));
+      if (t.Has(name) && t.Get(name).IsNumber()) {
+        minPixels[i] = std::max(0.0, t.Get(name).ToNumber().DoubleValue());
+      }
+    }
+  }
+
+  const long threads = getInt("threads", 0);
+  if (o.Has("threads") && threads < 1) {
+    Napi::RangeError::New(env, "threads must be >= 1").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  const long framePoolMB = getInt("framePoolMB", -1);
+  if (o.Has("framePoolMB") && framePoolMB < 0) {
+    Napi::RangeError::New(env, "framePoolMB must be >= 0").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  if (framePoolMB >= 0) FramePool::Instance().SetIdleLimit(size_t(framePoolMB) << 20);
+
+  const ComputeDevice::Config d = device.Configure(mode, minPixels);
+  return ConfigToJS(env, pool.Configure(static_cast<int>(threads),
+                                        getInt("queueLimit", -1), policy,
+                                        static_cast<int>(getInt("opencvThreads", 0))), d);
+}
+
+static Napi::Object HistogramToJS(Napi::Env env, const LatencyHistogram& h) {
+  Napi::Object o = Napi::Object::New(env);
+  o.Set("p50",  Napi::Number::New(env, h.Percentile(0.50)));
+  o.Set("p95",  Napi::Number::New(env, h.Percentile(0.95)));
+  o.Set("p99",  Napi::Number::New(env, h.Percentile(0.99)));
+  o.Set("mean", Napi::Number::New(env, h.Mean()));
+  o.Set("max",  Napi::Number::New(env, h.Max()));
+  return o;
+}
+
+static Napi::Number Count(Napi::Env env, uint64_t v) {
+  return Napi::Number::New(env, static_cast<double>(v));
+}
+
+/*──────── binding: stats([{ reset }]) → { uptimeMs, windowMs, queue, memory, remap, decodeCache, device, cpu, ops } ─*/
+// ops: per op name { count, errors, perSecond, bytesIn, bytesOut, allocations,
+// gpu, totalMs, queueMs, convertMs, taskMs, encodeMs } with { p50, p95, p99,
+// mean, max } histograms, counted since start or the last reset (gpu = jobs
+// that ran at least one call on the OpenCL device). queue.expired /
+// cancelled / superseded count jobs dropped by options.deadlineMs, cancel
+// and latestKey (src/runtime/job-control.h). cpu.simd is the level the
+// hand-written kernels run at, cpu.detected the best one of the host.
+Napi::Value Stats(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  const EngineStats::Snapshot snap = EngineStats::Instance().Get();
+  const EngineThreadPool::Stats q = EngineThreadPool::Instance().GetStats();
+  const FramePool::Stats mem = FramePool::Instance().GetStats();
+  AddonData* data = env.GetInstanceData<AddonData>();
+
+  Napi::Object queued = Napi::Object::New(env);
+  queued.Set("high",   Count(env, q.queued[0]));
+  queued.Set("normal", Count(env, q.queued[1]));
+  queued.Set("low",    Count(env, q.queued[2]));
+
+  Napi::Object queue = Napi::Object::New(env);
+  queue.Set("threads",   Napi::Number::New(env, q.threads));
+  queue.Set("running",   Napi::Number::New(env, q.running));
+  queue.Set("queued",    queued);
+  queue.Set("inFlight",  Napi::Number::New(env, data ? data->inFlight : 0));
+  queue.Set("completed", Count(env, q.completed));
+  queue.Set("rejected",  Count(env, q.rejected));
+  queue.Set("shed",      Count(env, q.shed));
+  queue.Set("expired",   Count(env, q.expired));
+  queue.Set("cancelled", Count(env, q.cancelled));
+  queue.Set("superseded", Count(env, q.superseded));
+
+  Napi::Object memory = Napi::Object::New(env);
+  memory.Set("hits",      Count(env, mem.hits));
+  memory.Set("misses",    Count(env, mem.misses));
+  memory.Set("idleBytes", Count(env, mem.idleBytes));
+  memory.Set("liveBytes", Count(env, mem.liveBytes));
+  memory.Set("idleLimit", Count(env, mem.idleLimit));
+
+  const RemapCache::Stats rc = RemapCache::Instance().GetStats();
+  Napi::Object remap = Napi::Object::New(env);
+  remap.Set("hits",     Count(env, rc.hits));
+  remap.Set("misses",   Count(env, rc.misses));
+  remap.Set("bypassed", Count(env, rc.bypassed));
+  remap.Set("entries",  Count(env, rc.entries));
+  remap.Set("bytes",    Count(env, rc.bytes));
+
+  const DecodeCache::Stats dc = DecodeCache::Instance().GetStats();
+  Napi::Object decodeCache = Napi::Object::New(env);
+  decodeCache.Set("hits",      Count(env, dc.hits));
+  decodeCache.Set("misses",    Count(env, dc.misses));
+  decodeCache.Set("coalesced", Count(env, dc.coalesced));
+  decodeCache.Set("bypassed",  Count(env, dc.bypassed));
+  decodeCache.Set("entries",   Count(env, dc.entries));
+  decodeCache.Set("bytes",     Count(env, dc.bytes));
+  decodeCache.Set("budget",    Count(env, dc.budget));
+
+  const ComputeDevice::Stats ds = ComputeDevice::Instance().GetStats();
+  Napi::Object device = Napi::Object::New(env);
+  device.Set("mode",      Napi::String::New(env,
+                            DeviceModeName(ComputeDevice::Instance().GetConfig().mode)));
+  device.Set("available", Napi::Boolean::New(env, ds.available));
+  device.Set("name",      Napi::String::New(env, ds.name));
+  device.Set("offloaded", Count(env, ds.offloaded));
+  device.Set("fallbacks", Count(env, ds.fallbacks));
+
+  Napi::Object cpu = Napi::Object::New(env);
+  cpu.Set("simd",     Napi::String::New(env, SimdLevelName(ActiveSimd())));
+  cpu.Set("detected", Napi::String::New(env, SimdLevelName(DetectedSimd())));
+
+  const double seconds = snap.windowMs / 1e3;
+  Napi::Object ops = Napi::Object::New(env);
+  for (const auto& kv : snap.ops) {
+    const EngineStats::OpStats& s = kv.second;
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("count",       Count(env, s.count));
+    o.Set("errors",      Count(env, s.errors));
+    o.Set("perSecond",   Napi::Number::New(env, seconds > 0 ? s.count / seconds : 0.0));
+    o.Set("bytesIn",     Count(env, s.bytesIn));
+    o.Set("bytesOut",    Count(env, s.bytesOut));
+    o.Set("allocations", Count(env, s.allocations));
+    o.Set("gpu",         Count(env, s.gpu));
+    o.Set("totalMs",     HistogramToJS(env, s.totalMs));
+    o.Set("queueMs",     HistogramToJS(env, s.queueMs));
+    o.Set("convertMs",   HistogramToJS(env, s.convertMs));
+    o.Set("taskMs",      HistogramToJS(env, s.taskMs));
+    o.Set("encodeMs",    HistogramToJS(env, s.encodeMs));
+    ops.Set(kv.first, o);
+  }
+
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("uptimeMs", Napi::Number::New(env, snap.uptimeMs));
+  out.Set("windowMs", Napi::Number::New(env, snap.windowMs));
+  out.Set("queue",    queue);
+  out.Set("memory",   memory);
+  out.Set("remap",    remap);
+  out.Set("decodeCache", decodeCache);
+  out.Set("device",   device);
+  out.Set("cpu",      cpu);
+  out.Set("ops",      ops);
+
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object opts = info[0].As<Napi::Object>();
+    if (opts.Has("reset") && opts.Get("reset").ToBoolean().Value()) {
+      EngineStats::Instance().Reset();
+    }
+  }
+  return out;
+}
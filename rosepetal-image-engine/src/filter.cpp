@@ -5,9 +5,169 @@
 #include "filters/kernels.h"
 #include <unordered_map>
 #include <string>
+#include "ops.h"
+#include "runtime/device.h"
+
+/*──────────────────────── core op (shared with pipeline) ───────────────*/
+namespace {
+
+void ApplyBlurFilter(const cv::Mat& input, cv::Mat& result,
+                     int kernelSize, double intensity) {
+  // Box blur using OpenCV's optimized function (running sums, O(1) per pixel)
+  cv::Size ksize(kernelSize, kernelSize);
+  if (intensity >= 1.0) {
+    cv::boxFilter(input, result, -1, ksize);
+    return;
+  }
+
+  // Intensity < 1: blend with the original band by band, in the same pass
+  FilterAndBlendInBands(input, result,
+    [&](const cv::Mat& src, cv::Mat& dst) { cv::boxFilter(src, dst, -1, ksize); },
+    1.0 - intensity, intensity);
+}
+
+void ApplySharpenFilter(const cv::Mat& input, cv::Mat& result,
+                        int kernelSize, double intensity) {
+  if (kernelSize == 3) {
+    // Standard 3x3 kernel, built once per intensity
+    cv::Mat kernel = KernelCache::Instance().Get("sharpen", 3, intensity,
+      [&] { return CreateSharpenKernel(3, intensity); });
+    cv::filter2D(input, result, -1, kernel);
+    return;
+  }
+
+  // Larger sizes: unsharp mask over a separable Gaussian of that size,
+  //   result = input * (1 + intensity) - gaussian(input) * intensity
+  const cv::Size ksize(kernelSize, kernelSize);
+  const double sigma = kernelSize / 6.0;
+  FilterAndBlendInBands(input, result,
+    [&](const cv::Mat& src, cv::Mat& dst) { cv::GaussianBlur(src, dst, ksize, sigma); },
+    1.0 + intensity, -intensity);
+}
+
+void ApplyEdgeFilter(const cv::Mat& input, cv::Mat& result,
+                     int kernelSize, double intensity) {
+  // Sobel edge detection
+  cv::Mat grad_x, grad_y;
+  cv::Mat gray;
+  
+  // Convert to grayscale for edge detection
+  if (input.channels() > 1) {
+    cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+  } else {
+    gray = input;
+  }
+  
+  // Apply Sobel
+  cv::Sobel(gray, grad_x, CV_16S, 1, 0, kernelSize);
+  cv::Sobel(gray, grad_y, CV_16S, 0, 1, kernelSize);
+  
+  // Calculate gradient magnitude
+  cv::Mat abs_grad_x, abs_grad_y;
+  cv::convertScaleAbs(grad_x, abs_grad_x);
+  cv::convertScaleAbs(grad_y, abs_grad_y);
+  
+  // Average of both gradients with the intensity folded in (one pass)
+  cv::addWeighted(abs_grad_x, 0.5 * intensity, abs_grad_y, 0.5 * intensity, 0, result);
+  
+  // Convert back to original channels if needed
+  if (input.channels() > 1) {
+    cv::cvtColor(result, result, cv::COLOR_GRAY2BGR);
+    if (input.channels() == 4) {
+      cv::cvtColor(result, result, cv::COLOR_BGR2BGRA);
+    }
+  }
+}
+
+void ApplyEmbossFilter(const cv::Mat& input, cv::Mat& result,
+                       double intensity) {
+  // Emboss kernel, built once per intensity
+  cv::Mat kernel = KernelCache::Instance().Get("emboss", 3, intensity,
+    [&] { return CreateEmbossKernel(intensity); });
+
+  // +128 (mid-gray relief) applied as the filter delta, in the same pass
+  cv::filter2D(input, result, -1, kernel, cv::Point(-1, -1), 128.0);
+}
+
+void ApplyGaussianFilter(const cv::Mat& input, cv::Mat& result,
+                         int kernelSize, double intensity) {
+  // Gaussian blur with OpenCV's optimized function
+  cv::Size ksize(kernelSize, kernelSize);
+  double sigma = kernelSize / 6.0 * intensity; // Scale sigma with intensity
+  cv::GaussianBlur(input, result, ksize, sigma);
+}
+
+// The same filters on the OpenCL device: whole-frame calls (the device
+// parallelises them itself) and the blends as one addWeighted each
+cv::UMat ApplyFilterOnDevice(const cv::Mat& input, const std::string& type,
+                             int kernelSize, double intensity) {
+  const cv::UMat src = Upload(input);
+  const cv::Size ksize(kernelSize, kernelSize);
+  cv::UMat result;
+
+  if (type == "blur") {
+    cv::boxFilter(src, result, -1, ksize);
+    if (intensity < 1.0) cv::addWeighted(src, 1.0 - intensity, result, intensity, 0, result);
+  } else if (type == "sharpen" && kernelSize == 3) {
+    cv::Mat kernel = KernelCache::Instance().Get("sharpen", 3, intensity,
+      [&] { return CreateSharpenKernel(3, intensity); });
+    cv::filter2D(src, result, -1, kernel);
+  } else if (type == "sharpen") {
+    cv::GaussianBlur(src, result, ksize, kernelSize / 6.0);
+    cv::addWeighted(src, 1.0 + intensity, result, -intensity, 0, result);
+  } else if (type == "edge") {
+    cv::UMat gray, gradX, gradY, absX, absY;
+    if (src.channels() > 1) cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+    else gray = src;
+    cv::Sobel(gray, gradX, CV_16S, 1, 0, kernelSize);
+    cv::Sobel(gray, gradY, CV_16S, 0, 1, kernelSize);
+    cv::convertScaleAbs(gradX, absX);
+    cv::convertScaleAbs(gradY, absY);
+    cv::addWeighted(absX, 0.5 * intensity, absY, 0.5 * intensity, 0, result);
+    if (src.channels() > 1) {
+      cv::cvtColor(result, result, src.channels() == 4 ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2BGR);
+    }
+  } else if (type == "emboss") {
+    cv::Mat kernel = KernelCache::Instance().Get("emboss", 3, intensity,
+      [&] { return CreateEmbossKernel(intensity); });
+    cv::filter2D(src, result, -1, kernel, cv::Point(-1, -1), 128.0);
+  } else if (type == "gaussian") {
+    cv::GaussianBlur(src, result, ksize, kernelSize / 6.0 * intensity);
+  } else {
+    throw std::runtime_error("Unknown filter type: " + type);
+  }
+  return result;
+}
+
+}  // namespace
+
+cv::Mat ApplyFilter(const cv::Mat& src, const FilterParams& p) {
+  const int kernelSize = ValidateKernelSize(p.kernelSize);
+
+  return OnDevice(GpuOp::FILTER, static_cast<double>(src.total()),
+    [&] {
+      cv::Mat result;
+      // Apply filter based on type
+      if (p.type == "blur") {
+        ApplyBlurFilter(src, result, kernelSize, p.intensity);
+      } else if (p.type == "sharpen") {
+        ApplySharpenFilter(src, result, kernelSize, p.intensity);
+      } else if (p.type == "edge") {
+        ApplyEdgeFilter(src, result, kernelSize, p.intensity);
+      } else if (p.type == "emboss") {
+        ApplyEmbossFilter(src, result, p.intensity);
+      } else if (p.type == "gaussian") {
+        ApplyGaussianFilter(src, result, kernelSize, p.intensity);
+      } else {
+        throw std::runtime_error("Unknown filter type: " + p.type);
+      }
+      return result;
+    },
+    [&] { return ApplyFilterOnDevice(src, p.type, kernelSize, p.intensity); });
+}
 
 /*------------------------------------------------------------------------*/
-class FilterWorker final : public Napi::AsyncWorker {
+class FilterWorker final : public EngineWorker {
 public:
   FilterWorker(Napi::Function cb,
                const Napi::Value& imgVal,
@@ -16,70 +176,64 @@ public:
                double intensity,
                std::string outputFormat,
                int quality = 90,
-               bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+               EncodeOptions encodeOpts = {},
+               OutputTarget outTarget = OutputTarget(),
+               StreamMode streamMode = StreamMode::OFF)
+    : EngineWorker(cb, "filter"),
       filterType_(filterType),
       kernelSize_(kernelSize),
       intensity_(intensity),
       outputFormat_(std::move(outputFormat)),
       quality_(quality),
-      pngOptimize_(pngOptimize)
+      encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget)),
+      streamMode_(streamMode)
   {
-    // Convert input image and measure timing
-    const int64 t0 = cv::getTickCount();
-    input_ = ConvertToMat(imgVal);
-    convertMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
-
-    // Determine channel format
-    if (imgVal.IsObject() && !imgVal.IsBuffer()) {
-      Napi::Object obj = imgVal.As<Napi::Object>();
-      
-      // Check for colorSpace field
-      if (obj.Has("colorSpace")) {
-        channel_ = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-      }
-      // Default based on channel count
-      else {
-        channel_ = (input_.channels() == 4) ? "BGRA"
-                 : (input_.channels() == 3) ? "BGR" 
-                 : "GRAY";
-      }
-    } else {
-      // Buffer input - determine from OpenCV Mat
-      channel_ = (input_.channels() == 4) ? "BGRA"
-               : (input_.channels() == 3) ? "BGR"
-               : "GRAY";
+    // Decoding is deferred to Execute() so it never blocks the event loop
+    try {
+      inputImage_ = PrepareInput(imgVal);
+    } catch (const Napi::Error& e) {
+      SetError(e.Message());
     }
   }
 
 protected:
   void Execute() override {
-    const int64 t0 = cv::getTickCount();
-    
     try {
-      // Apply filter based on type
-      if (filterType_ == "blur") {
-        ApplyBlurFilter();
-      } else if (filterType_ == "sharpen") {
-        ApplySharpenFilter();
-      } else if (filterType_ == "edge") {
-        ApplyEdgeFilter();
-      } else if (filterType_ == "emboss") {
-        ApplyEmbossFilter();
-      } else if (filterType_ == "gaussian") {
-        ApplyGaussianFilter();
-      } else {
-        throw std::runtime_error("Unknown filter type: " + filterType_);
+      // Very large JPEGs: decode / filter / encode in row strips
+      if (ShouldStream(inputImage_, streamMode_)) {
+        StreamResult s;
+        StreamFilter(inputImage_, { filterType_, kernelSize_, intensity_ }, outputFormat_, quality_, s);
+        convertMs_ = s.decodeMs;
+        taskMs_ = s.taskMs;
+        channel_ = s.colorSpace;
+        result_ = s.mat;
+        if (s.encodedDone) {
+          encodedBuf_ = std::move(s.encoded);
+          encodeMs_ = s.encodeMs;
+        } else if (outputFormat_ != "raw") {
+          encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
+        }
+        out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
+        return;
       }
+
+      // Decode / wrap input on the worker thread
+      convertMs_ = DecodeInput(inputImage_);
+      input_ = inputImage_.mat;
+      channel_ = inputImage_.colorSpace;
+
+      const int64 t0 = cv::getTickCount();
+
+      result_ = ApplyFilter(input_, { filterType_, kernelSize_, intensity_ });
       
       taskMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
       
       // Multi-format encoding
       if (outputFormat_ != "raw") {
-        const cv::Mat& srcForEncoding = (channel_ == "BGR") ? result_ 
-                                       : ToBgrForJpg(result_, channel_);
-        encodeMs_ = EncodeToFormat(srcForEncoding, encodedBuf_, outputFormat_, quality_, pngOptimize_);
+        encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
       }
+      out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
     } catch (const std::exception& e) {
       SetError(e.what());
     }
@@ -87,13 +241,12 @@ protected:
 
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value jsImg = (outputFormat_ != "raw")
-        ? VectorToBuffer(env, std::move(encodedBuf_))
-        : MatToRawJS(env, result_, channel_);
+    Napi::Value jsImg = out_.ToJS(env, outputFormat_, result_, channel_, encodedBuf_);
 
     Napi::Object out = Napi::Object::New(env);
     out.Set("image", jsImg);
-    out.Set("timing", MakeTimingJS(env, convertMs_, taskMs_, encodeMs_));
+    out.Set("timing", TimingJS(convertMs_, taskMs_, encodeMs_));
+    out_.AttachPreview(out);
     Callback().Call({ env.Null(), out });
   }
 
@@ -102,85 +255,20 @@ protected:
   }
 
 private:
+  InputImage inputImage_;
   cv::Mat input_, result_;
   std::string filterType_;
   int kernelSize_;
   double intensity_;
   std::string outputFormat_;
   int quality_;
-  bool pngOptimize_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
+  StreamMode streamMode_;
   std::string channel_;
   
   double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
   std::vector<uchar> encodedBuf_;
-
-  void ApplyBlurFilter() {
-    // Box blur using OpenCV's optimized function
-    cv::Size ksize(kernelSize_, kernelSize_);
-    cv::boxFilter(input_, result_, -1, ksize);
-    
-    // Apply intensity (blend with original)
-    if (intensity_ < 1.0) {
-      cv::addWeighted(input_, 1.0 - intensity_, result_, intensity_, 0, result_);
-    }
-  }
-
-  void ApplySharpenFilter() {
-    // Create sharpening kernel
-    cv::Mat kernel = CreateSharpenKernel(kernelSize_, intensity_);
-    cv::filter2D(input_, result_, -1, kernel);
-  }
-
-  void ApplyEdgeFilter() {
-    // Sobel edge detection
-    cv::Mat grad_x, grad_y;
-    cv::Mat gray;
-    
-    // Convert to grayscale for edge detection
-    if (input_.channels() > 1) {
-      cv::cvtColor(input_, gray, cv::COLOR_BGR2GRAY);
-    } else {
-      gray = input_;
-    }
-    
-    // Apply Sobel
-    cv::Sobel(gray, grad_x, CV_16S, 1, 0, kernelSize_);
-    cv::Sobel(gray, grad_y, CV_16S, 0, 1, kernelSize_);
-    
-    // Calculate gradient magnitude
-    cv::Mat abs_grad_x, abs_grad_y;
-    cv::convertScaleAbs(grad_x, abs_grad_x);
-    cv::convertScaleAbs(grad_y, abs_grad_y);
-    
-    cv::addWeighted(abs_grad_x, 0.5, abs_grad_y, 0.5, 0, result_);
-    
-    // Apply intensity
-    cv::convertScaleAbs(result_, result_, intensity_);
-    
-    // Convert back to original channels if needed
-    if (input_.channels() > 1) {
-      cv::cvtColor(result_, result_, cv::COLOR_GRAY2BGR);
-      if (input_.channels() == 4) {
-        cv::cvtColor(result_, result_, cv::COLOR_BGR2BGRA);
-      }
-    }
-  }
-
-  void ApplyEmbossFilter() {
-    // Create emboss kernel
-    cv::Mat kernel = CreateEmbossKernel(intensity_);
-    cv::filter2D(input_, result_, -1, kernel);
-    
-    // Add 128 to bring to mid-gray range for emboss effect
-    result_ += cv::Scalar::all(128);
-  }
-
-  void ApplyGaussianFilter() {
-    // Gaussian blur with OpenCV's optimized function
-    cv::Size ksize(kernelSize_, kernelSize_);
-    double sigma = kernelSize_ / 6.0 * intensity_; // Scale sigma with intensity
-    cv::GaussianBlur(input_, result_, ksize, sigma);
-  }
 };
 
 /*──────── binding: filter(image, filterType, kernelSize, intensity, [outputFormat], [quality], [pngOptimize], callback) ─*/
@@ -202,7 +290,10 @@ Napi::Value Filter(const Napi::CallbackInfo& info) {
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
+  StreamMode streamMode = StreamMode::OFF;
   
   if (info.Length() - i >= 2) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -213,7 +304,10 @@ Napi::Value Filter(const Napi::CallbackInfo& info) {
   }
   
   if (info.Length() - i >= 2) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    streamMode = ParseStreamMode(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
   
   Napi::Function cb = info[i].As<Napi::Function>();
@@ -225,6 +319,6 @@ Napi::Value Filter(const Napi::CallbackInfo& info) {
   kernelSize = std::max(3, std::min(kernelSize, 15)); // Clamp to reasonable range
 
   // Create and queue worker
-  (new FilterWorker(cb, img, filterType, kernelSize, intensity, outputFormat, quality, pngOptimize))->Queue();
+  (new FilterWorker(cb, img, filterType, kernelSize, intensity, outputFormat, quality, encodeOpts, std::move(outTarget), streamMode))->Queue(job);
   return env.Undefined();
 }
\ No newline at end of file
@@ -3,6 +3,13 @@
 #define KERNELS_H
 
 #include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
 
 // Optimized kernel creation functions for image filtering
@@ -118,6 +125,61 @@ inline cv::Mat CreateEdgeKernel(int direction, int size) {
     return kernel;
 }
 
+/**
+ * Kernels built once per (type, size, intensity) and shared read-only by all
+ * worker threads. Intensity is keyed at 1e-6 precision; the cache is cleared
+ * when it reaches kMaxEntries (intensities driven by msg values).
+ */
+class KernelCache {
+public:
+    static constexpr size_t kMaxEntries = 256;
+
+    static KernelCache& Instance() {
+        static KernelCache* cache = new KernelCache();
+        return *cache;
+    }
+
+    cv::Mat Get(const std::string& type, int size, double intensity,
+                const std::function<cv::Mat()>& build) {
+        const Key key(type, size, static_cast<int64_t>(std::llround(intensity * 1e6)));
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = kernels_.find(key);
+        if (it != kernels_.end()) return it->second;
+        if (kernels_.size() >= kMaxEntries) kernels_.clear();
+        return kernels_[key] = build();
+    }
+
+private:
+    using Key = std::tuple<std::string, int, int64_t>;
+
+    KernelCache() = default;
+
+    std::mutex mutex_;
+    std::map<Key, cv::Mat> kernels_;
+};
+
+/**
+ * Runs `filter` on row bands of `input` in parallel and blends each band
+ * with the source while it is still in cache:
+ *   result = input * alpha + filter(input) * beta
+ * Bands are ROIs of `input`, so filters read their real neighbours across
+ * band edges and the output matches one full-image pass.
+ * @param filter Writes the filtered band (same size/type) into its second argument
+ */
+inline void FilterAndBlendInBands(const cv::Mat& input, cv::Mat& result,
+                                  const std::function<void(const cv::Mat&, cv::Mat&)>& filter,
+                                  double alpha, double beta) {
+    result.create(input.size(), input.type());
+    const int rows = input.rows;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& r) {
+        const cv::Mat src = input.rowRange(r.start, r.end);
+        cv::Mat dst = result.rowRange(r.start, r.end);
+        cv::Mat filtered;
+        filter(src, filtered);
+        cv::addWeighted(src, alpha, filtered, beta, 0.0, dst);
+    }, std::max(1, rows / 64));
+}
+
 /**
  * Utility function to validate and adjust kernel size
  * @param size Input kernel size
@@ -144,28 +206,4 @@ inline double ValidateIntensity(double intensity, double min = 0.0, double max =
     return std::max(min, std::min(intensity, max));
 }
 
-/**
- * Pre-computed optimized kernels for common operations
- */
-namespace OptimizedKernels {
-    // Common 3x3 kernels
-    const cv::Mat SHARPEN_3X3 = (cv::Mat_<float>(3, 3) <<
-        0, -1, 0,
-        -1, 5, -1,
-        0, -1, 0
-    );
-    
-    const cv::Mat EMBOSS_3X3 = (cv::Mat_<float>(3, 3) <<
-        -2, -1, 0,
-        -1, 1, 1,
-        0, 1, 2
-    );
-    
-    const cv::Mat EDGE_3X3 = (cv::Mat_<float>(3, 3) <<
-        0, -1, 0,
-        -1, 4, -1,
-        0, -1, 0
-    );
-}
-
 #endif // KERNELS_H
\ No newline at end of file
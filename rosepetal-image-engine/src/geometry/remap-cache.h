@@ -0,0 +1,231 @@
+// Fichero: src/geometry/remap-cache.h
+//
+// LRU cache of fixed-point remap tables for arbitrary-angle rotations.
+// - Cameras usually rotate every frame by the same angle (mounting
+//   correction), so the inverse mapping is computed once per
+//   (source size, angle, interpolation) and converted with cv::convertMaps
+//   to CV_16SC2 + CV_16UC1 (integer coords + interpolation table index).
+// - Each frame is then a table-driven gather: cv::remap over row stripes
+//   in parallel, no per-pixel matrix math.
+// - Angles are quantised to 1e-4° for the key; the maps are built from the
+//   quantised angle so a hit and a miss give the same pixels.
+// - Tables cost 6 bytes per destination pixel; the cache keeps at most
+//   kMaxEntries / kMaxBytes and rotations whose tables would exceed half
+//   the budget fall back to a plain warpAffine. So do frames with a source
+//   or destination side above SHRT_MAX, whose coordinates do not fit the
+//   CV_16SC2 map (wide line-scan images); both count as bypassed.
+// Used by ApplyRotate (rotate node, pipeline, rotateBatch) and by
+// advanced-mosaic for unscaled tiles fully on the canvas; other mosaic
+// tiles only borrow RotationMatrix() for the single warp that resizes,
+// rotates and places them. RotateOnDevice() runs the same rotation as a
+// warpAffine on the OpenCL device when that pays off.
+
+#ifndef REMAP_CACHE_H
+#define REMAP_CACHE_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "../runtime/device.h"
+
+struct RotationMaps {
+  cv::Mat xy;              // CV_16SC2: integer source coordinates
+  cv::Mat frac;            // CV_16UC1: interpolation table index (empty for NEAREST)
+  cv::Mat matrix;          // forward 2×3 matrix, for the warpAffine fallback
+  cv::Size dstSize;
+
+  size_t Bytes() const { return xy.total() * xy.elemSize() + frac.total() * frac.elemSize(); }
+};
+
+class RemapCache {
+public:
+  static constexpr size_t kMaxEntries = 16;
+  static constexpr size_t kMaxBytes   = size_t(256) << 20;
+
+  struct Stats {
+    uint64_t hits = 0, misses = 0, bypassed = 0;
+    size_t entries = 0, bytes = 0;
+  };
+
+  static RemapCache& Instance() {
+    static RemapCache* cache = new RemapCache();
+    return *cache;
+  }
+
+  static double QuantizeAngle(double angleDeg) {
+    return std::round(angleDeg * 1e4) / 1e4;
+  }
+
+  // Matrix and bounding-box size of a rotation about the image centre
+  // (same geometry as getRotationMatrix2D + warpAffine onto the full canvas)
+  static cv::Mat RotationMatrix(const cv::Size& src, double angleDeg, cv::Size& dstSize) {
+    const cv::Point2f c(src.width / 2.f, src.height / 2.f);
+    cv::Mat M = cv::getRotationMatrix2D(c, angleDeg, 1.0);
+    const double cosA = std::abs(M.at<double>(0, 0));
+    const double sinA = std::abs(M.at<double>(0, 1));
+    dstSize = cv::Size(int(src.height * sinA + src.width * cosA),
+                       int(src.height * cosA + src.width * sinA));
+    M.at<double>(0, 2) += dstSize.width / 2.0 - c.x;
+    M.at<double>(1, 2) += dstSize.height / 2.0 - c.y;
+    return M;
+  }
+
+  // Tables for rotating a `src`-sized image; built on a miss. Entries too
+  // large for the cache, or beyond the 16-bit map range, come back without
+  // tables (maps->xy.empty()).
+  std::shared_ptr<const RotationMaps> GetRotation(const cv::Size& src, double angleDeg,
+                                                  int interpolation) {
+    const Key key{ src.width, src.height,
+                   static_cast<int64_t>(std::llround(QuantizeAngle(angleDeg) * 1e4)), interpolation };
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = index_.find(key);
+      if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        ++stats_.hits;
+        return it->second->maps;
+      }
+    }
+
+    // Built outside the lock; two threads missing on the same key both build
+    auto maps = std::make_shared<RotationMaps>();
+    maps->matrix = RotationMatrix(src, QuantizeAngle(angleDeg), maps->dstSize);
+    const size_t bytes = size_t(maps->dstSize.area()) * 6;
+    const bool overflows = std::max({ src.width, src.height,
+                                      maps->dstSize.width, maps->dstSize.height }) > SHRT_MAX;
+
+    if (bytes > kMaxBytes / 2 || overflows) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.bypassed;
+      return maps;
+    }
+    BuildTables(*maps, interpolation);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.misses;
+
+    auto it = index_.find(key);
+    if (it != index_.end()) return it->second->maps;    // built meanwhile
+    lru_.push_front({ key, maps });
+    index_[key] = lru_.begin();
+    stats_.bytes += maps->Bytes();
+    while (lru_.size() > kMaxEntries || stats_.bytes > kMaxBytes) {
+      stats_.bytes -= lru_.back().maps->Bytes();
+      index_.erase(lru_.back().key);
+      lru_.pop_back();
+    }
+    return maps;
+  }
+
+  Stats GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    s.entries = lru_.size();
+    return s;
+  }
+
+private:
+  struct Key {
+    int width, height;
+    int64_t angle;         // degrees × 1e4
+    int interpolation;
+    bool operator==(const Key& o) const {
+      return width == o.width && height == o.height && angle == o.angle &&
+             interpolation == o.interpolation;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& k) const {
+      size_t h = std::hash<int64_t>()(k.angle);
+      h ^= std::hash<int>()(k.width) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      h ^= std::hash<int>()(k.height) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      h ^= std::hash<int>()(k.interpolation) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      return h;
+    }
+  };
+
+  struct Entry {
+    Key key;
+    std::shared_ptr<const RotationMaps> maps;
+  };
+
+  RemapCache() = default;
+
+  // Inverse mapping dst → src, evaluated per row incrementally, then packed
+  // into OpenCV's fixed-point remap format
+  static void BuildTables(RotationMaps& m, int interpolation) {
+    cv::Mat inv;
+    cv::invertAffineTransform(m.matrix, inv);
+    const double a = inv.at<double>(0, 0), b = inv.at<double>(0, 1), c = inv.at<double>(0, 2);
+    const double d = inv.at<double>(1, 0), e = inv.at<double>(1, 1), f = inv.at<double>(1, 2);
+
+    cv::Mat mapX(m.dstSize, CV_32FC1), mapY(m.dstSize, CV_32FC1);
+    cv::parallel_for_(cv::Range(0, m.dstSize.height), [&](const cv::Range& r) {
+      for (int y = r.start; y < r.end; ++y) {
+        float* mx = mapX.ptr<float>(y);
+        float* my = mapY.ptr<float>(y);
+        const double x0 = b * y + c, y0 = e * y + f;
+        for (int x = 0; x < m.dstSize.width; ++x) {
+          mx[x] = static_cast<float>(a * x + x0);
+          my[x] = static_cast<float>(d * x + y0);
+        }
+      }
+    });
+    cv::convertMaps(mapX, mapY, m.xy, m.frac, CV_16SC2,
+                    interpolation == cv::INTER_NEAREST);
+  }
+
+  mutable std::mutex mutex_;
+  std::list<Entry> lru_;                               // front = most recent
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  Stats stats_;
+};
+
+// Rotates `src` by angleDeg (OpenCV convention: positive = counter-clockwise)
+// about its centre onto its bounding box, through the cached tables.
+inline cv::Mat RotateWithCache(const cv::Mat& src, double angleDeg, int interpolation,
+                               const cv::Scalar& borderValue) {
+  auto maps = RemapCache::Instance().GetRotation(src.size(), angleDeg, interpolation);
+
+  cv::Mat dst;
+  if (maps->xy.empty()) {
+    cv::warpAffine(src, dst, maps->matrix, maps->dstSize, interpolation,
+                   cv::BORDER_CONSTANT, borderValue);
+    return dst;
+  }
+
+  dst.create(maps->dstSize, src.type());
+  const int rows = maps->dstSize.height;
+  cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& r) {
+    cv::Mat band = dst.rowRange(r.start, r.end);
+    cv::remap(src, band, maps->xy.rowRange(r.start, r.end),
+              maps->frac.empty() ? cv::Mat() : maps->frac.rowRange(r.start, r.end),
+              interpolation, cv::BORDER_CONSTANT, borderValue);
+  }, std::max(1, rows / 64));
+  return dst;
+}
+
+// RotateWithCache(), or one warpAffine on the OpenCL device when `op` is
+// offloaded for this size (no tables to build or upload there)
+inline cv::Mat RotateOnDevice(GpuOp op, const cv::Mat& src, double angleDeg, int interpolation,
+                              const cv::Scalar& borderValue) {
+  return OnDevice(op, static_cast<double>(src.total()),
+    [&] { return RotateWithCache(src, angleDeg, interpolation, borderValue); },
+    [&] {
+      cv::Size dstSize;
+      const cv::Mat M = RemapCache::RotationMatrix(src.size(),
+                                                   RemapCache::QuantizeAngle(angleDeg), dstSize);
+      cv::UMat dst;
+      cv::warpAffine(Upload(src), dst, M, dstSize, interpolation, cv::BORDER_CONSTANT, borderValue);
+      return dst;
+    });
+}
+
+#endif // REMAP_CACHE_H
@@ -0,0 +1,212 @@
+// Fichero: src/letterbox.cpp
+//
+// Letterbox for model inputs: resize (keep aspect) + pad in one pass. The
+// canvas is allocated once at the target size, only the border strips are
+// painted and the image is resampled straight into its ROI, so there is no
+// intermediate resized Mat and no copyMakeBorder copy.
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "ops.h"
+
+/*──────────────────────── core op (shared with pipeline / batch) ───────*/
+LetterboxInfo ResolveLetterbox(const cv::Size& src, const LetterboxParams& p) {
+  if (p.width <= 0 || p.height <= 0) {
+    throw std::runtime_error("Letterbox target size must be positive");
+  }
+  if (src.width <= 0 || src.height <= 0) {
+    throw std::runtime_error("Letterbox input is empty");
+  }
+
+  LetterboxInfo info;
+  info.source = src;
+  info.scale = std::min(static_cast<double>(p.width) / src.width,
+                        static_cast<double>(p.height) / src.height);
+  if (!p.scaleUp) info.scale = std::min(info.scale, 1.0);
+
+  info.scaled = cv::Size(
+    std::max(1, std::min(p.width,  static_cast<int>(std::lround(src.width  * info.scale)))),
+    std::max(1, std::min(p.height, static_cast<int>(std::lround(src.height * info.scale)))));
+
+  const int dx = p.width - info.scaled.width, dy = p.height - info.scaled.height;
+  const bool top    = p.align.find("top")    != std::string::npos;
+  const bool bottom = p.align.find("bottom") != std::string::npos;
+  const bool left   = p.align.find("left")   != std::string::npos;
+  const bool right  = p.align.find("right")  != std::string::npos;
+  info.offsetX = left ? 0 : right ? dx : dx / 2;
+  info.offsetY = top ? 0 : bottom ? dy : dy / 2;
+  return info;
+}
+
+cv::Mat ApplyLetterbox(const cv::Mat& src, const std::string& channelOrder,
+                       const LetterboxParams& p, const cv::Size& sourceSize,
+                       LetterboxInfo* infoOut) {
+  const LetterboxInfo info = ResolveLetterbox(sourceSize, p);
+  if (infoOut) *infoOut = info;
+
+  cv::Scalar pad = p.padColor;
+  if (channelOrder == "RGB" || channelOrder == "RGBA") std::swap(pad[0], pad[2]);
+
+  cv::Mat dst(p.height, p.width, src.type());
+  const cv::Rect roi(info.offsetX, info.offsetY, info.scaled.width, info.scaled.height);
+
+  // Border strips only: above / below the image, then left / right of it
+  if (roi.y > 0) dst.rowRange(0, roi.y).setTo(pad);
+  if (roi.br().y < dst.rows) dst.rowRange(roi.br().y, dst.rows).setTo(pad);
+  if (roi.x > 0) dst(cv::Rect(0, roi.y, roi.x, roi.height)).setTo(pad);
+  if (roi.br().x < dst.cols) dst(cv::Rect(roi.br().x, roi.y, dst.cols - roi.br().x, roi.height)).setTo(pad);
+
+  cv::Mat target = dst(roi);
+  if (src.size() == roi.size()) src.copyTo(target);
+  else cv::resize(src, target, roi.size(), 0, 0, cv::INTER_LINEAR);
+  return dst;
+}
+
+double DecodeForLetterbox(InputImage& in, const LetterboxParams& p) {
+  int reduce = 1;
+  cv::Size full;
+  int components = 0;
+  if (in.IsEncoded() && ProbeJpegSize(in.encoded, in.encodedSize, full, components)) {
+    reduce = ChooseReducedScale(full, ResolveLetterbox(full, p).scaled);
+  }
+  return DecodeInput(in, reduce);
+}
+
+Napi::Object LetterboxInfoJS(Napi::Env env, const LetterboxInfo& info) {
+  Napi::Object o = Napi::Object::New(env);
+  o.Set("scale",        Napi::Number::New(env, info.scale));
+  o.Set("offsetX",      Napi::Number::New(env, info.offsetX));
+  o.Set("offsetY",      Napi::Number::New(env, info.offsetY));
+  o.Set("width",        Napi::Number::New(env, info.scaled.width));
+  o.Set("height",       Napi::Number::New(env, info.scaled.height));
+  o.Set("sourceWidth",  Napi::Number::New(env, info.source.width));
+  o.Set("sourceHeight", Napi::Number::New(env, info.source.height));
+  return o;
+}
+
+/*------------------------------------------------------------------------*/
+class LetterboxWorker final : public EngineWorker {
+public:
+  LetterboxWorker(Napi::Function cb,
+                  const Napi::Value& imgVal,
+                  LetterboxParams params,
+                  std::string outputFormat,
+                  int quality = 90,
+                  EncodeOptions encodeOpts = {},
+                  OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "letterbox"),
+      params_(std::move(params)),
+      outputFormat_(std::move(outputFormat)),
+      quality_(quality),
+      encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget))
+  {
+    input_ = PrepareInput(imgVal);                     // decode deferred to Execute()
+  }
+
+protected:
+  void Execute() override {
+    // JPEGs shrunk ≥2× decode with DCT scaling; geometry stays full-res
+    convertMs_ = DecodeForLetterbox(input_, params_);
+    channel_ = input_.colorSpace;
+
+    const int64 t0 = cv::getTickCount();
+    result_ = ApplyLetterbox(input_.mat, channel_, params_, input_.sourceSize, &info_);
+    taskMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+
+    if (outputFormat_ != "raw") {
+      encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
+    }
+    out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("image",     out_.ToJS(env, outputFormat_, result_, channel_, encodedBuf_));
+    out.Set("letterbox", LetterboxInfoJS(env, info_));
+    out.Set("timing",    TimingJS(convertMs_, taskMs_, encodeMs_));
+    out_.AttachPreview(out);
+    Callback().Call({ env.Null(), out });
+  }
+
+  void OnError(const Napi::Error& e) override {
+    Callback().Call({ e.Value(), Env().Null() });
+  }
+
+private:
+  InputImage input_;
+  LetterboxParams params_;
+  LetterboxInfo info_;
+  cv::Mat result_;
+  std::string channel_;
+
+  std::string outputFormat_;
+  int quality_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
+
+  double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
+  std::vector<uchar> encodedBuf_;
+};
+
+// `scaleUp` of an options object (default true)
+bool ParseLetterboxScaleUp(const Napi::Value& opts) {
+  if (!opts.IsObject() || opts.IsBuffer()) return true;
+  Napi::Object o = opts.As<Napi::Object>();
+  return !o.Has("scaleUp") || o.Get("scaleUp").IsUndefined() || o.Get("scaleUp").ToBoolean().Value();
+}
+
+/*──────── binding: letterbox(image, width, height, padHex, align, [outputFormat], [quality], [options], callback) ─*/
+Napi::Value Letterbox(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 6 || info.Length() > 9 || !info[1].IsNumber() || !info[2].IsNumber() ||
+      !info[info.Length()-1].IsFunction()) {
+    Napi::TypeError::New(env,
+      "letterbox(image, width, height, padHex, align, [outputFormat], [quality], [options], callback)")
+      .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int i = 0;
+  Napi::Value img = info[i++];
+  LetterboxParams params;
+  params.width  = info[i++].As<Napi::Number>().Int32Value();
+  params.height = info[i++].As<Napi::Number>().Int32Value();
+  if (info[i].IsString()) params.padColor = ParseColor(info[i].As<Napi::String>());
+  i++;
+  if (info[i].IsString()) params.align = info[i].As<Napi::String>().Utf8Value();
+  i++;
+
+  // Handle parameters
+  std::string outputFormat = "raw";
+  int quality = 90;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
+
+  if (info.Length() - i >= 2) {
+    outputFormat = info[i++].As<Napi::String>().Utf8Value();
+  }
+
+  if (info.Length() - i >= 2) {
+    quality = info[i++].As<Napi::Number>().Int32Value();
+  }
+
+  if (info.Length() - i >= 2) {
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    params.scaleUp = ParseLetterboxScaleUp(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
+  }
+
+  Napi::Function cb = info[i].As<Napi::Function>();
+
+  (new LetterboxWorker(cb, img, params, outputFormat, quality, encodeOpts, std::move(outTarget)))->Queue(job);
+  return env.Undefined();
+}
@@ -1,26 +1,64 @@
 #include <napi.h>
+#include "memory/frame-pool.h"
+#include "runtime/cancel-token.h"
+#include "runtime/native-image.h"
+#include "runtime/worker-pool.h"
 
 Napi::Value Resize(const Napi::CallbackInfo& info);
 Napi::Value Rotate(const Napi::CallbackInfo& info);
 Napi::Value Crop(const Napi::CallbackInfo& info); 
+Napi::Value CropMany(const Napi::CallbackInfo& info);
 Napi::Value Concat(const Napi::CallbackInfo& info);
 Napi::Value Padding(const Napi::CallbackInfo& info);
 Napi::Value Filter(const Napi::CallbackInfo& info);
 Napi::Value Mosaic(const Napi::CallbackInfo& info);
 Napi::Value AdvancedMosaic(const Napi::CallbackInfo& info);
 Napi::Value Blend(const Napi::CallbackInfo& info);
+Napi::Value Letterbox(const Napi::CallbackInfo& info);
+Napi::Value Pipeline(const Napi::CallbackInfo& info);
+Napi::Value ResizeBatch(const Napi::CallbackInfo& info);
+Napi::Value RotateBatch(const Napi::CallbackInfo& info);
+Napi::Value FilterBatch(const Napi::CallbackInfo& info);
+Napi::Value CropBatch(const Napi::CallbackInfo& info);
+Napi::Value PaddingBatch(const Napi::CallbackInfo& info);
+Napi::Value LetterboxBatch(const Napi::CallbackInfo& info);
+Napi::Value PoolStats(const Napi::CallbackInfo& info);
+Napi::Value Configure(const Napi::CallbackInfo& info);
+Napi::Value Stats(const Napi::CallbackInfo& info);
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  InstallFramePool();     // engine Mats reuse pooled frame memory from here on
+  InitAddonData(env);     // completion channel for the engine worker pool
+  NativeImage::Init(env, exports);   // outputFormat "native" handles
+  CancelToken::Init(env, exports);   // options.cancel tokens
+
   exports.Set(Napi::String::New(env, "resize"), Napi::Function::New(env, Resize));
   exports.Set(Napi::String::New(env, "rotate"), Napi::Function::New(env, Rotate));
   exports.Set(Napi::String::New(env, "crop"), Napi::Function::New(env, Crop));
+  exports.Set(Napi::String::New(env, "cropMany"), Napi::Function::New(env, CropMany));
   exports.Set(Napi::String::New(env, "concat"), Napi::Function::New(env, Concat));
   exports.Set(Napi::String::New(env, "padding"), Napi::Function::New(env, Padding));
   exports.Set(Napi::String::New(env, "filter"), Napi::Function::New(env, Filter));
   exports.Set(Napi::String::New(env, "mosaic"), Napi::Function::New(env, Mosaic));
   exports.Set(Napi::String::New(env, "advancedMosaic"), Napi::Function::New(env, AdvancedMosaic));
   exports.Set(Napi::String::New(env, "blend"), Napi::Function::New(env, Blend));
+  exports.Set(Napi::String::New(env, "letterbox"), Napi::Function::New(env, Letterbox));
+  exports.Set(Napi::String::New(env, "pipeline"), Napi::Function::New(env, Pipeline));
+  exports.Set(Napi::String::New(env, "resizeBatch"), Napi::Function::New(env, ResizeBatch));
+  exports.Set(Napi::String::New(env, "rotateBatch"), Napi::Function::New(env, RotateBatch));
+  exports.Set(Napi::String::New(env, "filterBatch"), Napi::Function::New(env, FilterBatch));
+  exports.Set(Napi::String::New(env, "cropBatch"), Napi::Function::New(env, CropBatch));
+  exports.Set(Napi::String::New(env, "paddingBatch"), Napi::Function::New(env, PaddingBatch));
+  exports.Set(Napi::String::New(env, "letterboxBatch"), Napi::Function::New(env, LetterboxBatch));
+  exports.Set(Napi::String::New(env, "poolStats"), Napi::Function::New(env, PoolStats));
+  exports.Set(Napi::String::New(env, "configure"), Napi::Function::New(env, Configure));
+  exports.Set(Napi::String::New(env, "stats"), Napi::Function::New(env, Stats));
   return exports;
 }
 
-NODE_API_MODULE(addon, Init)
\ No newline at end of file
+// Context-aware registration: Init runs once per env (main thread and every
+// worker_thread that loads the addon). Per-env state lives in AddonData;
+// the engine thread pool, frame pool and caches are process-wide and shared.
+NAPI_MODULE_INIT() {
+  return Napi::RegisterModule(env, exports, Init);
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+// Fichero: src/memory/frame-pool.h
+//
+// Size-bucketed frame pool installed as OpenCV's default MatAllocator.
+// - Every Mat the engine creates (decode, cvtColor, resize, canvases…) of
+//   at least kMinPooledBytes draws its pixels from here; smaller ones go
+//   straight to cv::fastMalloc.
+// - Blocks are rounded up to one of 8 size classes per power of two
+//   (≤ 12.5 % slack), so same-sized camera frames, and encodes of similar
+//   size, reuse each other's memory.
+// - Released blocks are kept for reuse up to the idle limit
+//   (ROSEPETAL_FRAME_POOL_MB, default 512, 0 disables; configure({
+//   framePoolMB }) changes it at run time and frees the excess at once);
+//   the rest are freed. Mats handed to JS (MatToRawJS) come back here when
+//   the Buffer's finalizer drops the last reference.
+// Thread-safe: Mats are created and released on worker threads and on the
+// JS thread (finalizers).
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "../runtime/metrics.h"
+
+class FramePool {
+public:
+  static constexpr size_t kMinPooledBytes = 64 * 1024;
+
+  struct Stats {
+    uint64_t hits = 0;          // served from a free list
+    uint64_t misses = 0;        // fresh fastMalloc
+    uint64_t recycled = 0;      // blocks returned to a free list
+    uint64_t dropped = 0;       // blocks freed because the pool was full
+    size_t idleBytes = 0;       // cached, ready for reuse
+    size_t liveBytes = 0;       // currently owned by Mats
+    size_t idleLimit = 0;       // most idle bytes kept
+  };
+
+  // Never destroyed: Mats may still be released while statics unwind.
+  static FramePool& Instance() {
+    static FramePool* pool = new FramePool();
+    return *pool;
+  }
+
+  static size_t SizeClass(size_t n) {
+    size_t p = 1;
+    while ((p << 1) <= n) p <<= 1;                  // highest power of two ≤ n
+    const size_t step = std::max<size_t>(p / 8, 4096);
+    return (n + step - 1) / step * step;
+  }
+
+  void* Acquire(size_t n) {
+    CountAllocation();                              // per-job counter, if any
+    if (n < kMinPooledBytes) return cv::fastMalloc(n);
+    const size_t cls = SizeClass(n);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.liveBytes += cls;
+      auto it = free_.find(cls);
+      if (it != free_.end() && !it->second.empty()) {
+        void* p = it->second.back();
+        it->second.pop_back();
+        stats_.idleBytes -= cls;
+        ++stats_.hits;
+        return p;
+      }
+      ++stats_.misses;
+    }
+    return cv::fastMalloc(cls);
+  }
+
+  void Release(void* p, size_t n) {
+    if (!p) return;
+    if (n < kMinPooledBytes) { cv::fastFree(p); return; }
+    const size_t cls = SizeClass(n);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.liveBytes -= cls;
+      if (stats_.idleBytes + cls <= stats_.idleLimit) {
+        free_[cls].push_back(p);
+        stats_.idleBytes += cls;
+        ++stats_.recycled;
+        return;
+      }
+      ++stats_.dropped;
+    }
+    cv::fastFree(p);
+  }
+
+  Stats GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  // New idle limit; cached blocks above it are freed now (live Mats are
+  // untouched, they are dropped on release once the pool is full)
+  void SetIdleLimit(size_t bytes) {
+    std::vector<void*> drained;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.idleLimit = bytes;
+      for (auto it = free_.begin(); it != free_.end() && stats_.idleBytes > bytes; ) {
+        while (!it->second.empty() && stats_.idleBytes > bytes) {
+          drained.push_back(it->second.back());
+          it->second.pop_back();
+          stats_.idleBytes -= it->first;
+        }
+        it = it->second.empty() ? free_.erase(it) : std::next(it);
+      }
+    }
+    for (void* p : drained) cv::fastFree(p);
+  }
+
+private:
+  FramePool() {
+    const char* v = std::getenv("ROSEPETAL_FRAME_POOL_MB");
+    const long mb = (v && *v) ? std::strtol(v, nullptr, 10) : 512;
+    stats_.idleLimit = mb > 0 ? size_t(mb) << 20 : 0;
+  }
+
+  mutable std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<void*>> free_;   // size class → blocks
+  Stats stats_;
+};
+
+// cv::MatAllocator front-end for FramePool (same contract as OpenCV's
+// StdMatAllocator: host memory only, user data is never freed).
+class PooledMatAllocator final : public cv::MatAllocator {
+public:
+  cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0,
+                         size_t* step, cv::AccessFlag /*flags*/,
+                         cv::UMatUsageFlags /*usageFlags*/) const override {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+      if (step) {
+        if (data0 && step[i] != CV_AUTOSTEP) total = step[i];
+        else step[i] = total;
+      }
+      total *= sizes[i];
+    }
+
+    uchar* data = data0 ? static_cast<uchar*>(data0)
+                        : static_cast<uchar*>(FramePool::Instance().Acquire(total));
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = data;
+    u->size = total;
+    if (data0) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+  }
+
+  bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+    return u != nullptr;
+  }
+
+  void deallocate(cv::UMatData* u) const override {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+      FramePool::Instance().Release(u->origdata, u->size);
+      u->origdata = nullptr;
+    }
+    delete u;
+  }
+};
+
+// Called once from the module Init(); later Mats of every thread use the pool
+inline void InstallFramePool() {
+  static PooledMatAllocator* allocator = new PooledMatAllocator();   // outlives every Mat
+  cv::Mat::setDefaultAllocator(allocator);
+}
+
+#endif // FRAME_POOL_H
@@ -1,6 +1,6 @@
 // ───────── src/mosaic.cpp ───────────────────────────────────────────────
 // SUPER FAST mosaic node - Ultra-optimized image compositing
-// Zero-copy operations, parallel processing, SIMD acceleration
+// Zero-copy operations, row-band parallel placement (cv::parallel_for_)
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include <vector>
@@ -30,7 +30,7 @@ std::string DetermineBestCanvasFormat(const std::vector<std::string>& channels)
 }
 
 /*────────────────────────── ULTRA-FAST MosaicWorker ───────────────────────────────────*/
-class MosaicWorker : public Napi::AsyncWorker {
+class MosaicWorker : public EngineWorker {
 public:
   MosaicWorker(Napi::Function cb,
                const Napi::Array& imagesArray,
@@ -39,48 +39,22 @@ public:
                const Napi::Array& positionsArray,
                bool normalized, std::string outputFormat,
                int quality = 90,
-               bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+               EncodeOptions encodeOpts = {},
+               OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "mosaic"),
       canvasWidth_(canvasWidth), canvasHeight_(canvasHeight),
       backgroundColor_(backgroundColor),
       normalized_(normalized), outputFormat_(std::move(outputFormat)),
-      quality_(quality), pngOptimize_(pngOptimize)
+      quality_(quality), encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget))
   {
-    /* ─ SUPER FAST image conversion with timing ─ */
-    const int64 t0 = cv::getTickCount();
-    
     // Pre-allocate vectors for maximum performance
-    images_.reserve(imagesArray.Length());
-    imageChannels_.reserve(imagesArray.Length());
+    inputs_.reserve(imagesArray.Length());
     positions_.reserve(positionsArray.Length());
     
-    // Convert images with zero-copy operations and extract channel formats
+    // Wrap inputs only - decoding is deferred to Execute() (worker thread)
     for (uint32_t i = 0; i < imagesArray.Length(); i++) {
-      images_.emplace_back(ConvertToMat(imagesArray[i]));
-      
-      // Extract and store channel format for each image (like other nodes do)
-      std::string channel;
-      if (imagesArray[i].IsObject() && !imagesArray[i].IsBuffer()) {
-        Napi::Object obj = imagesArray[i].As<Napi::Object>();
-        
-        // Check for new colorSpace field first
-        if (obj.Has("colorSpace")) {
-          channel = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-        }
-        // Default based on channel count
-        else {
-          channel = (images_[i].channels() == 4) ? "BGRA"
-                  : (images_[i].channels() == 3) ? "BGR" 
-                  : "GRAY";
-        }
-      } else {
-        // Buffer input - determine from OpenCV Mat
-        channel = (images_[i].channels() == 4) ? "BGRA"
-                : (images_[i].channels() == 3) ? "BGR"
-                : "GRAY";
-      }
-      
-      imageChannels_.emplace_back(channel);
+      inputs_.push_back(PrepareInput(imagesArray[i]));
     }
     
     // Parse positions - ultra-fast integer operations
@@ -93,14 +67,22 @@ public:
       positions_.emplace_back(p);
     }
     
-    // Determine the best canvas format from all input images (priority: RGBA > BGRA > RGB > BGR > GRAY)
-    canvasChannel_ = DetermineBestCanvasFormat(imageChannels_);
-    
-    convertMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
   }
 
 protected:
   void Execute() override {
+    /* ─ Decode inputs on the worker thread (parallel for encoded buffers) ─ */
+    convertMs_ = DecodeInputs(inputs_);
+    images_.reserve(inputs_.size());
+    imageChannels_.reserve(inputs_.size());
+    for (const auto& in : inputs_) {
+      images_.push_back(in.mat);
+      imageChannels_.push_back(in.colorSpace);
+    }
+    
+    // Determine the best canvas format from all input images (priority: RGBA > BGRA > RGB > BGR > GRAY)
+    canvasChannel_ = DetermineBestCanvasFormat(imageChannels_);
+    
     /* ─ SUPER FAST mosaic composition ─ */
     const int64 t0 = cv::getTickCount();
     
@@ -125,45 +107,45 @@ protected:
     
     canvas_ = cv::Mat(canvasHeight_, canvasWidth_, canvasType, bgColor);
     
-    // Process all positions - PARALLEL when beneficial
-    const size_t numPositions = positions_.size();
+    // Resolve every placement once (clipping + colour conversion code)
+    std::vector<Placement> placements;
+    placements.reserve(positions_.size());
+    for (const auto& pos : positions_) {
+      Placement pl;
+      if (ResolvePlacement(pos, pl)) placements.push_back(pl);
+    }
     
-    if (numPositions > 4) {
-      // Parallel processing for multiple positions
-      #pragma omp parallel for
-      for (int i = 0; i < static_cast<int>(numPositions); i++) {
-        PlaceImageFast(positions_[i]);
-      }
-    } else {
-      // Sequential processing for small batches (avoid threading overhead)
-      for (const auto& pos : positions_) {
-        PlaceImageFast(pos);
+    // PARALLEL by canvas row bands, not by tile: each band is owned by one
+    // thread and walks the positions in input order, so overlapping tiles
+    // composite exactly like the sequential loop (later tile wins).
+    const double nstripes = std::max(1, canvasHeight_ / kMinBandRows);
+    cv::parallel_for_(cv::Range(0, canvasHeight_), [&](const cv::Range& rows) {
+      for (const auto& pl : placements) {
+        PlaceImageBand(pl, rows);
       }
-    }
+    }, nstripes);
     
     taskMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
     
     /* ─ SUPER FAST multi-format encoding (optional) ─ */
     if (outputFormat_ != "raw") {
-      // Convert to BGR format for encoding if needed (like other nodes do)
-      const cv::Mat& srcForEncoding = (canvasChannel_ == "BGR") ? canvas_ 
-                                     : ToBgrForJpg(canvas_, canvasChannel_);
-      encodeMs_ = EncodeToFormat(srcForEncoding, encodedBuf_, outputFormat_, quality_, pngOptimize_);
+      // JPEG encodes straight from the canvas format (BGR conversion otherwise)
+      encodeMs_ = EncodeImage(canvas_, canvasChannel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
     }
+    out_.Capture(outputFormat_, canvas_, encodedBuf_, canvasChannel_);
   }
   
   void OnOK() override {
     Napi::Env env = Env();
     
     // Zero-copy output creation with correct channel format
-    Napi::Value jsImg = (outputFormat_ != "raw")
-        ? VectorToBuffer(env, std::move(encodedBuf_))       // Zero-copy encoded
-        : MatToRawJS(env, canvas_.clone(), canvasChannel_); // Contiguous raw with correct channel format
+    Napi::Value jsImg = out_.ToJS(env, outputFormat_, canvas_, canvasChannel_, encodedBuf_);
     
     Napi::Object result = Napi::Object::New(env);
     result.Set("image", jsImg);
-    result.Set("timing", MakeTimingJS(env, convertMs_, taskMs_, encodeMs_));
+    result.Set("timing", TimingJS(convertMs_, taskMs_, encodeMs_));
     
+    out_.AttachPreview(result);
     Callback().Call({ env.Null(), result });
   }
   
@@ -177,14 +159,23 @@ private:
     double x, y;
   };
   
-  // ULTRA-FAST image placement with bounds checking
-  void PlaceImageFast(const Position& pos) {
+  // Tile clipped to the canvas, plus the cvtColor code to canvas format
+  struct Placement {
+    int index;
+    cv::Rect src, dst;
+    int cvtCode;                // -1 = same format, plain copy
+  };
+  
+  static constexpr int kMinBandRows = 64;  // keeps per-band overhead negligible
+  
+  // FAST bounds checking + intersection rectangle; false = tile not visible
+  bool ResolvePlacement(const Position& pos, Placement& pl) const {
     if (pos.arrayIndex < 0 || pos.arrayIndex >= static_cast<int>(images_.size())) {
-      return; // Skip invalid indices
+      return false; // Skip invalid indices
     }
     
     const cv::Mat& img = images_[pos.arrayIndex];
-    if (img.empty()) return;
+    if (img.empty()) return false;
     
     // Calculate position - FAST integer operations
     int x = normalized_ ? static_cast<int>(std::round(pos.x * canvasWidth_)) 
@@ -193,10 +184,9 @@ private:
                         : static_cast<int>(std::lround(pos.y));
     
     // FAST bounds checking with early exit
-    if (x >= canvasWidth_ || y >= canvasHeight_) return;
-    if (x + img.cols <= 0 || y + img.rows <= 0) return;
+    if (x >= canvasWidth_ || y >= canvasHeight_) return false;
+    if (x + img.cols <= 0 || y + img.rows <= 0) return false;
     
-    // Calculate intersection rectangle - OPTIMIZED
     int srcX = std::max(0, -x);
     int srcY = std::max(0, -y);
     int dstX = std::max(0, x);
@@ -205,105 +195,73 @@ private:
     int width = std::min(img.cols - srcX, canvasWidth_ - dstX);
     int height = std::min(img.rows - srcY, canvasHeight_ - dstY);
     
-    if (width <= 0 || height <= 0) return;
+    if (width <= 0 || height <= 0) return false;
     
-    // ZERO-COPY image placement using OpenCV's optimized copyTo
-    cv::Rect srcROI(srcX, srcY, width, height);
-    cv::Rect dstROI(dstX, dstY, width, height);
-    
-    // Get the channel format for this specific image
-    const std::string& imgChannel = imageChannels_[pos.arrayIndex];
+    pl.index   = pos.arrayIndex;
+    pl.src     = cv::Rect(srcX, srcY, width, height);
+    pl.dst     = cv::Rect(dstX, dstY, width, height);
+    pl.cvtCode = CanvasConversionCode(imageChannels_[pos.arrayIndex]);
+    return true;
+  }
+  
+  // Conversion from an input channel format to the canvas format
+  int CanvasConversionCode(const std::string& imgChannel) const {
+    if (canvasChannel_ == "GRAY") {
+      if (imgChannel == "GRAY") return -1;
+      if (imgChannel == "RGB")  return cv::COLOR_RGB2GRAY;
+      if (imgChannel == "RGBA") return cv::COLOR_RGBA2GRAY;
+      if (imgChannel == "BGRA") return cv::COLOR_BGRA2GRAY;
+      return cv::COLOR_BGR2GRAY;
+    }
+    if (canvasChannel_ == "RGB") {
+      if (imgChannel == "GRAY") return cv::COLOR_GRAY2RGB;
+      if (imgChannel == "RGB")  return -1;
+      if (imgChannel == "RGBA") return cv::COLOR_RGBA2RGB;
+      if (imgChannel == "BGRA") return cv::COLOR_BGRA2RGB;
+      return cv::COLOR_BGR2RGB;
+    }
+    if (canvasChannel_ == "BGRA") {
+      if (imgChannel == "GRAY") return cv::COLOR_GRAY2BGRA;
+      if (imgChannel == "RGB")  return cv::COLOR_RGB2BGRA;
+      if (imgChannel == "RGBA") return cv::COLOR_RGBA2BGRA;
+      if (imgChannel == "BGRA") return -1;
+      return cv::COLOR_BGR2BGRA;
+    }
+    if (canvasChannel_ == "RGBA") {
+      if (imgChannel == "GRAY") return cv::COLOR_GRAY2RGBA;
+      if (imgChannel == "RGB")  return cv::COLOR_RGB2RGBA;
+      if (imgChannel == "RGBA") return -1;
+      if (imgChannel == "BGRA") return cv::COLOR_BGRA2RGBA;
+      return cv::COLOR_BGR2RGBA;
+    }
+    // BGR canvas (default)
+    if (imgChannel == "GRAY") return cv::COLOR_GRAY2BGR;
+    if (imgChannel == "RGB")  return cv::COLOR_RGB2BGR;
+    if (imgChannel == "RGBA") return cv::COLOR_RGBA2BGR;
+    if (imgChannel == "BGRA") return cv::COLOR_BGRA2BGR;
+    return -1;
+  }
+  
+  // Writes the part of one tile that falls inside canvas rows [rows.start, rows.end)
+  void PlaceImageBand(const Placement& pl, const cv::Range& rows) {
+    const int y0 = std::max(pl.dst.y, rows.start);
+    const int y1 = std::min(pl.dst.y + pl.dst.height, rows.end);
+    if (y0 >= y1) return;
     
-    // Convert to canvas format based on actual input format (fixes blue color issue)
-    cv::Mat imgToPlace;
-    cv::Mat srcRegion = img(srcROI);
+    const int dy = y0 - pl.dst.y;
+    cv::Mat srcRegion = images_[pl.index](cv::Rect(pl.src.x, pl.src.y + dy, pl.src.width, y1 - y0));
+    cv::Mat dstRegion = canvas_(cv::Rect(pl.dst.x, y0, pl.dst.width, y1 - y0));
     
-    // Convert input image to match canvas format
-    if (canvasChannel_ == "GRAY") {
-      // Convert to grayscale canvas
-      if (imgChannel == "GRAY") {
-        imgToPlace = srcRegion;
-      } else if (imgChannel == "RGB") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGB2GRAY);
-      } else if (imgChannel == "RGBA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGBA2GRAY);
-      } else if (imgChannel == "BGRA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGRA2GRAY);
-      } else {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGR2GRAY);
-      }
-    } else if (canvasChannel_ == "BGR") {
-      // Convert to BGR canvas
-      if (imgChannel == "GRAY") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_GRAY2BGR);
-      } else if (imgChannel == "RGB") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGB2BGR);
-      } else if (imgChannel == "RGBA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGBA2BGR);
-      } else if (imgChannel == "BGRA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGRA2BGR);
-      } else {
-        imgToPlace = srcRegion; // Already BGR
-      }
-    } else if (canvasChannel_ == "RGB") {
-      // Convert to RGB canvas
-      if (imgChannel == "GRAY") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_GRAY2RGB);
-      } else if (imgChannel == "RGB") {
-        imgToPlace = srcRegion; // Already RGB
-      } else if (imgChannel == "RGBA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGBA2RGB);
-      } else if (imgChannel == "BGRA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGRA2RGB);
-      } else {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGR2RGB);
-      }
-    } else if (canvasChannel_ == "BGRA") {
-      // Convert to BGRA canvas
-      if (imgChannel == "GRAY") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_GRAY2BGRA);
-      } else if (imgChannel == "RGB") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGB2BGRA);
-      } else if (imgChannel == "RGBA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGBA2BGRA);
-      } else if (imgChannel == "BGRA") {
-        imgToPlace = srcRegion; // Already BGRA
-      } else {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGR2BGRA);
-      }
-    } else if (canvasChannel_ == "RGBA") {
-      // Convert to RGBA canvas
-      if (imgChannel == "GRAY") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_GRAY2RGBA);
-      } else if (imgChannel == "RGB") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGB2RGBA);
-      } else if (imgChannel == "RGBA") {
-        imgToPlace = srcRegion; // Already RGBA
-      } else if (imgChannel == "BGRA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGRA2RGBA);
-      } else {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGR2RGBA);
-      }
+    // Convert straight into the canvas view (same size/type → no realloc)
+    if (pl.cvtCode < 0) {
+      srcRegion.copyTo(dstRegion);
     } else {
-      // Default to BGR conversion
-      if (imgChannel == "GRAY") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_GRAY2BGR);
-      } else if (imgChannel == "RGB") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGB2BGR);
-      } else if (imgChannel == "RGBA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_RGBA2BGR);
-      } else if (imgChannel == "BGRA") {
-        cv::cvtColor(srcRegion, imgToPlace, cv::COLOR_BGRA2BGR);
-      } else {
-        imgToPlace = srcRegion;
-      }
+      cv::cvtColor(srcRegion, dstRegion, pl.cvtCode);
     }
-    
-    // FASTEST copy operation - zero-copy when possible
-    imgToPlace.copyTo(canvas_(dstROI));
   }
   
   // Member variables
+  std::vector<InputImage> inputs_;          // Captured on the JS thread
   std::vector<cv::Mat> images_;
   std::vector<std::string> imageChannels_;  // Channel format for each image
   std::vector<Position> positions_;
@@ -315,7 +273,8 @@ private:
   bool normalized_;
   std::string outputFormat_;
   int quality_;
-  bool pngOptimize_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
   
   double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
   std::vector<uchar> encodedBuf_;
@@ -344,7 +303,9 @@ Napi::Value Mosaic(const Napi::CallbackInfo& info) {
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
   
   if (info.Length() - i >= 2) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -355,7 +316,9 @@ Napi::Value Mosaic(const Napi::CallbackInfo& info) {
   }
   
   if (info.Length() - i >= 2) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
   
   Napi::Function callback = info[i].As<Napi::Function>();
@@ -367,7 +330,7 @@ Napi::Value Mosaic(const Napi::CallbackInfo& info) {
   
   // Launch ULTRA-FAST worker
   (new MosaicWorker(callback, imagesArray, canvasWidth, canvasHeight, 
-                    backgroundColor, positions, normalized, outputFormat, quality, pngOptimize))->Queue();
+                    backgroundColor, positions, normalized, outputFormat, quality, encodeOpts, std::move(outTarget)))->Queue(job);
   
   return env.Undefined();
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+// Fichero: src/native-image.cpp
+//
+// NativeImage handles (src/runtime/native-image.h).
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "utils.h"
+#include "runtime/native-image.h"
+
+namespace {
+// What NativeImage::New hands to the constructor through an External
+struct NativeImageInit {
+  cv::Mat mat;
+  std::string colorSpace;
+};
+}  // namespace
+
+void NativeImage::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function ctor = DefineClass(env, "NativeImage", {
+    InstanceAccessor("width",      &NativeImage::GetWidth,      nullptr),
+    InstanceAccessor("height",     &NativeImage::GetHeight,     nullptr),
+    InstanceAccessor("channels",   &NativeImage::GetChannels,   nullptr),
+    InstanceAccessor("colorSpace", &NativeImage::GetColorSpace, nullptr),
+    InstanceAccessor("dtype",      &NativeImage::GetDtype,      nullptr),
+    InstanceAccessor("data",       &NativeImage::GetData,       nullptr),
+    InstanceMethod("toObject",     &NativeImage::ToObject),
+  });
+
+  AddonData* data = env.GetInstanceData<AddonData>();
+  data->nativeImage = Napi::Persistent(ctor);
+  exports.Set("NativeImage", ctor);
+}
+
+Napi::Object NativeImage::New(Napi::Env env, const cv::Mat& mat, const std::string& colorSpace) {
+  // Mats over external memory (a raw JS input aliased by a no-op) are
+  // cloned; the handle must own what it points at.
+  NativeImageInit init{ mat.u != nullptr ? mat : mat.clone(), colorSpace };
+  AddonData* data = env.GetInstanceData<AddonData>();
+  return data->nativeImage.New({ Napi::External<NativeImageInit>::New(env, &init) });
+}
+
+NativeImage* NativeImage::FromValue(const Napi::Value& v) {
+  if (!v.IsObject() || IsBytes(v)) return nullptr;
+  AddonData* data = v.Env().GetInstanceData<AddonData>();
+  if (!data || data->nativeImage.IsEmpty()) return nullptr;
+  Napi::Object obj = v.As<Napi::Object>();
+  if (!obj.InstanceOf(data->nativeImage.Value())) return nullptr;
+  return Unwrap(obj);
+}
+
+NativeImage::NativeImage(const Napi::CallbackInfo& info)
+  : Napi::ObjectWrap<NativeImage>(info)
+{
+  if (info.Length() < 1 || !info[0].IsExternal()) {
+    throw Napi::TypeError::New(info.Env(),
+      "NativeImage handles are created by the engine (outputFormat \"native\")");
+  }
+  NativeImageInit* init = info[0].As<Napi::External<NativeImageInit>>().Data();
+  mat_ = init->mat;
+  colorSpace_ = init->colorSpace;
+
+  // Lets the GC see the pixel memory the handle keeps alive
+  externalBytes_ = static_cast<int64_t>(mat_.total() * mat_.elemSize());
+  Napi::MemoryManagement::AdjustExternalMemory(info.Env(), externalBytes_);
+}
+
+void NativeImage::Finalize(Napi::Env env) {
+  Napi::MemoryManagement::AdjustExternalMemory(env, -externalBytes_);
+}
+
+Napi::Value NativeImage::GetWidth(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), mat_.cols);
+}
+
+Napi::Value NativeImage::GetHeight(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), mat_.rows);
+}
+
+Napi::Value NativeImage::GetChannels(const Napi::CallbackInfo& info) {
+  return Napi::Number::New(info.Env(), mat_.channels());
+}
+
+Napi::Value NativeImage::GetColorSpace(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), colorSpace_);
+}
+
+Napi::Value NativeImage::GetDtype(const Napi::CallbackInfo& info) {
+  return Napi::String::New(info.Env(), DtypeName(mat_.depth()));
+}
+
+// A copy: the handle's pixels stay immutable, and the copy is a plain
+// V8-owned Buffer, so the constructor's external-memory count stays the
+// only one for mat_
+Napi::Value NativeImage::GetData(const Napi::CallbackInfo& info) {
+  const size_t bytes = mat_.total() * mat_.elemSize();
+  if (mat_.isContinuous()) return Napi::Buffer<uint8_t>::Copy(info.Env(), mat_.ptr<uint8_t>(), bytes);
+  const cv::Mat dense = mat_.clone();
+  return Napi::Buffer<uint8_t>::Copy(info.Env(), dense.ptr<uint8_t>(), bytes);
+}
+
+Napi::Value NativeImage::ToObject(const Napi::CallbackInfo& info) {
+  Napi::Object o = RawHeaderJS(info.Env(), mat_, colorSpace_);
+  o.Set("data", GetData(info));
+  return o;
+}
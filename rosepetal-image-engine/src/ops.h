@@ -0,0 +1,137 @@
+// Fichero: src/ops.h
+//
+// Core image operations shared by the per-node workers and the fused
+// pipeline worker. Each Apply* function runs on the worker thread, works on
+// cv::Mat (views where possible) and throws std::exception on bad input.
+
+#ifndef OPS_H
+#define OPS_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "utils.h"
+
+/* resize ─ NaN value = Auto (keeps aspect ratio) */
+struct ResizeParams {
+  std::string widthMode  = "set";     // "set" | "multiply"
+  double      widthValue  = 0.0;
+  std::string heightMode = "set";
+  double      heightValue = 0.0;
+};
+cv::Size ResolveResizeTarget(const cv::Size& src, const ResizeParams& p);
+cv::Mat  ApplyResize(const cv::Mat& src, const ResizeParams& p);
+// Target resolved against `sourceSize` (full resolution) instead of src.size(),
+// for inputs that were decoded with DCT downscaling
+cv::Mat  ApplyResize(const cv::Mat& src, const ResizeParams& p, const cv::Size& sourceSize);
+// DecodeInput() that uses IMREAD_REDUCED_* when a JPEG will be shrunk to
+// ≤½, ¼ or ⅛ by `p`; in.sourceSize keeps the full size for ApplyResize()
+double   DecodeForResize(InputImage& in, const ResizeParams& p);
+
+/* crop ─ result is a view into src (no copy) */
+struct CropParams {
+  double x = 0, y = 0, width = 0, height = 0;
+  bool normalized = false;
+};
+cv::Rect ResolveCropRect(const cv::Size& src, const CropParams& p);
+cv::Mat  ApplyCrop(const cv::Mat& src, const CropParams& p);
+
+/* rotate ─ padColor in (B,G,R) as returned by ParseColor */
+struct RotateParams {
+  double angleDeg = 0.0;
+  cv::Scalar padColor{0, 0, 0};
+};
+cv::Mat ApplyRotate(const cv::Mat& src, const std::string& channelOrder,
+                    const RotateParams& p);
+
+/* letterbox ─ resize keeping the aspect ratio to fit (width, height) and
+   place the result on a canvas of exactly that size, painted with padColor
+   (B,G,R) outside the image. `align` contains top/bottom/left/right or
+   defaults to centred. Resolved against the full-resolution size, so a box
+   (bx, by) in the output maps back with
+   x = (bx - offsetX) / scale, y = (by - offsetY) / scale. */
+struct LetterboxParams {
+  int width = 640, height = 640;
+  cv::Scalar padColor{114, 114, 114};
+  std::string align = "center";
+  bool scaleUp = true;                // false: smaller images are only padded
+};
+struct LetterboxInfo {
+  double scale = 1.0;
+  int offsetX = 0, offsetY = 0;
+  cv::Size scaled;                    // image area inside the canvas
+  cv::Size source;                    // full-resolution input size
+};
+LetterboxInfo ResolveLetterbox(const cv::Size& src, const LetterboxParams& p);
+cv::Mat ApplyLetterbox(const cv::Mat& src, const std::string& channelOrder,
+                       const LetterboxParams& p, const cv::Size& sourceSize,
+                       LetterboxInfo* info = nullptr);
+// DecodeInput() with DCT downscaling when the letterboxed image is ≤½ the JPEG
+double DecodeForLetterbox(InputImage& in, const LetterboxParams& p);
+// { scale, offsetX, offsetY, width, height, sourceWidth, sourceHeight }
+Napi::Object LetterboxInfoJS(Napi::Env env, const LetterboxInfo& info);
+// `scaleUp` of a binding's options object (default true)
+bool ParseLetterboxScaleUp(const Napi::Value& opts);
+
+/* filter ─ blur | sharpen | edge | emboss | gaussian */
+struct FilterParams {
+  std::string type = "blur";
+  int kernelSize = 3;                 // clamped to odd 3–15
+  double intensity = 1.0;
+};
+cv::Mat ApplyFilter(const cv::Mat& src, const FilterParams& p);
+
+/* padding ─ padColor in (B,G,R) as returned by ParseColor */
+struct PaddingParams {
+  int top = 0, bottom = 0, left = 0, right = 0;
+  cv::Scalar padColor{0, 0, 0};
+};
+cv::Mat ApplyPadding(const cv::Mat& src, const std::string& channelOrder,
+                     const PaddingParams& p);
+
+/* blend ─ result = a*opacity + b*(1-opacity); outChannel receives the
+   channel order of the result (priority RGBA > BGRA > RGB > BGR > GRAY) */
+cv::Mat ApplyBlend(const cv::Mat& a, const std::string& formatA,
+                   const cv::Mat& b, const std::string& formatB,
+                   double opacity, std::string& outChannel);
+
+/* blend (placement) ─ `overlay` at (x, y) on `base`, native size, clipped
+   to the base; only the overlay is converted. Per-pixel weight =
+   opacity · mask/255 · overlay alpha (when it has one). The mask (optional,
+   any channel count, 4 → its alpha) is resized to the overlay if needed.
+   The result keeps base's size and channel order; 8-bit only. When
+   `baseOwned` the base is written in place, otherwise into a copy. */
+struct PlaceBlendParams {
+  int x = 0, y = 0;
+  double opacity = 1.0;
+};
+cv::Mat ApplyPlaceBlend(const cv::Mat& base, const std::string& baseFormat,
+                        const cv::Mat& overlay, const std::string& overlayFormat,
+                        const cv::Mat& mask, const PlaceBlendParams& p,
+                        bool baseOwned = false);
+
+/* streaming ─ strip-wise decode → op → encode of encoded JPEG inputs, so
+   the full decoded frame is never held (src/streaming.cpp). Enabled per
+   call with options.streaming: true, or "auto" for frames of at least
+   kStreamAutoPixels. Needs libjpeg-turbo (HAVE_JPEG_STRIPS); otherwise, and for PNG /
+   WebP / raw inputs, ShouldStream() is false and the regular path runs.
+   "jpg" output is encoded strip by strip into `encoded` (encodedDone);
+   other formats get the full result in `mat`. */
+enum class StreamMode { OFF, ON, AUTO };
+constexpr double kStreamAutoPixels = 64e6;
+struct StreamResult {
+  cv::Mat mat;
+  std::vector<uchar> encoded;
+  bool encodedDone = false;
+  std::string colorSpace;
+  double decodeMs = 0.0, taskMs = 0.0, encodeMs = 0.0;
+};
+StreamMode ParseStreamMode(const Napi::Value& opts);
+bool ShouldStream(const InputImage& in, StreamMode mode);
+void StreamResize(InputImage& in, const ResizeParams& p,
+                  const std::string& outputFormat, int quality, StreamResult& r);
+void StreamFilter(InputImage& in, const FilterParams& p,
+                  const std::string& outputFormat, int quality, StreamResult& r);
+void StreamCrop(InputImage& in, const CropParams& p,
+                const std::string& outputFormat, int quality, StreamResult& r);
+
+#endif // OPS_H
@@ -2,9 +2,21 @@
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include "utils.h"
+#include "ops.h"
+
+/*──────── core op (shared with pipeline) ────────────────────────────────*/
+cv::Mat ApplyPadding(const cv::Mat& src,const std::string& channelOrder,
+                     const PaddingParams& p){
+  cv::Scalar padClrImg=p.padColor;
+  if(channelOrder=="RGB"||channelOrder=="RGBA") std::swap(padClrImg[0],padClrImg[2]);
+
+  cv::Mat dst;
+  cv::copyMakeBorder(src,dst,p.top,p.bottom,p.left,p.right,cv::BORDER_CONSTANT,padClrImg);
+  return dst;
+}
 
 /*------------------------------------------------------------------------*/
-class PaddingWorker final : public Napi::AsyncWorker {
+class PaddingWorker final : public EngineWorker {
 public:
   PaddingWorker(Napi::Function cb,
                 const Napi::Value& imgVal,
@@ -12,74 +24,61 @@ public:
                 cv::Scalar padRGB,
                 std::string outputFormat,
                 int quality = 90,
-                bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+                EncodeOptions encodeOpts = {},
+                OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "padding"),
       t_(top),b_(bottom),l_(left),r_(right),
       padColorRGB(padRGB),
       outputFormat(std::move(outputFormat)),
       quality(quality),
-      pngOptimize(pngOptimize)
+      encodeOpts(encodeOpts),
+      outTarget(std::move(outTarget))
   {
-    /* convertMs — zero‑copy → cv::Mat */
-    const int64 t0=cv::getTickCount();
-    src_=ConvertToMat(imgVal);
-    convertMs_=(cv::getTickCount()-t0)/cv::getTickFrequency()*1e3;
-
-    if (imgVal.IsObject() && !imgVal.IsBuffer()) {
-      Napi::Object obj = imgVal.As<Napi::Object>();
-      
-      // Check for new colorSpace field first
-      if (obj.Has("colorSpace")) {
-        channel_ = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-      }
-      // Default based on channel count
-      else {
-        channel_ = (src_.channels() == 4) ? "BGRA"
-                 : (src_.channels() == 3) ? "BGR" 
-                 : "GRAY";
-      }
-    } else {
-      // Buffer input - determine from OpenCV Mat
-      channel_ = (src_.channels() == 4) ? "BGRA"
-               : (src_.channels() == 3) ? "BGR"
-               : "GRAY";
-    }
-
-    padClrImg=padColorRGB;
-    if(channel_=="RGB"||channel_=="RGBA") std::swap(padClrImg[0],padClrImg[2]);
+    input_=PrepareInput(imgVal);                 // decode deferred to Execute()
   }
 
 protected:
   void Execute() override {
+    /* convertMs — decode en el hilo de trabajo (zero‑copy para RAW) */
+    convertMs_=DecodeInput(input_);
+    src_=input_.mat;
+    channel_=input_.colorSpace;
+
     const int64 t0=cv::getTickCount();
-    cv::copyMakeBorder(src_,dst_,t_,b_,l_,r_,cv::BORDER_CONSTANT,padClrImg);
+    dst_=ApplyPadding(src_,channel_,{t_,b_,l_,r_,padColorRGB});
     taskMs_=(cv::getTickCount()-t0)/cv::getTickFrequency()*1e3;
 
     if(outputFormat != "raw"){
-      const cv::Mat& srcForEncoding=(channel_=="BGR")?dst_:ToBgrForJpg(dst_,channel_);
-      encodeMs_=EncodeToFormat(srcForEncoding,encodedBuf_,outputFormat,quality,pngOptimize);
+      encodeMs_=EncodeImage(dst_,channel_,encodedBuf_,outputFormat,quality,encodeOpts);
     }
+    outTarget.Capture(outputFormat, dst_, encodedBuf_, channel_);
   }
 
   void OnOK() override {
     Napi::Env env=Env();
-    Napi::Value jsImg=(outputFormat != "raw")?VectorToBuffer(env,std::move(encodedBuf_))
-                                             :MatToRawJS(env,dst_,channel_);
+    Napi::Value jsImg=outTarget.ToJS(env, outputFormat, dst_, channel_, encodedBuf_);
 
     Napi::Object res=Napi::Object::New(env);
     res.Set("image",jsImg);
-    res.Set("timing",MakeTimingJS(env,convertMs_,taskMs_,encodeMs_));
+    res.Set("timing",TimingJS(convertMs_,taskMs_,encodeMs_));
+    outTarget.AttachPreview(res);
     Callback().Call({env.Null(),res});
   }
 
+  void OnError(const Napi::Error& e) override {
+    Callback().Call({ e.Value(), Env().Null() });
+  }
+
 private:
+  InputImage input_;
   cv::Mat src_,dst_;
   int t_,b_,l_,r_;
-  cv::Scalar padColorRGB,padClrImg;
+  cv::Scalar padColorRGB;
   std::string channel_;
   std::string outputFormat;
   int quality;
-  bool pngOptimize;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
 
   double convertMs_{0},taskMs_{0},encodeMs_{0};
   std::vector<uchar> encodedBuf_;
@@ -103,7 +102,9 @@ Napi::Value Padding(const Napi::CallbackInfo& info){
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
   
   if (info.Length() - i >= 2) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -114,11 +115,13 @@ Napi::Value Padding(const Napi::CallbackInfo& info){
   }
   
   if (info.Length() - i >= 2) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
   
   Napi::Function cb=info[i].As<Napi::Function>();
 
-  (new PaddingWorker(cb,img,top,bottom,left,right,pad,outputFormat,quality,pngOptimize))->Queue();
+  (new PaddingWorker(cb,img,top,bottom,left,right,pad,outputFormat,quality,encodeOpts,std::move(outTarget)))->Queue(job);
   return env.Undefined();
 }
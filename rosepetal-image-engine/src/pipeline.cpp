@@ -0,0 +1,313 @@
+// ───────── src/pipeline.cpp ──────────────────────────────────────────────
+// Fused multi-op pipeline: one decode, N ops on cv::Mat views, one encode,
+// all inside a single engine worker (one pool job per frame).
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "ops.h"
+
+/*────────────────────────── op descriptors ───────────────────────────*/
+enum class OpType { RESIZE, CROP, ROTATE, FILTER, PADDING, BLEND, LETTERBOX };
+
+struct PipelineOp {
+  OpType        type;
+  std::string   name;          // as given in JS, for timing
+  ResizeParams  resize;
+  CropParams    crop;
+  RotateParams  rotate;
+  FilterParams  filter;
+  PaddingParams padding;
+  LetterboxParams letterbox;
+  int           blendInput = -1;   // index into PipelineWorker::overlays_
+  double        opacity = 0.5;
+  bool          place = false;     // blend at (x, y): op image over the current frame
+  PlaceBlendParams placeParams;
+  int           maskInput = -1;    // optional mask, also in overlays_
+};
+
+static double GetNumber(const Napi::Object& o, const char* key, double def) {
+  if (!o.Has(key)) return def;
+  Napi::Value v = o.Get(key);
+  if (v.IsNull() || v.IsUndefined()) return def;   // null → default (NaN = Auto for resize)
+  return v.ToNumber().DoubleValue();
+}
+
+static std::string GetString(const Napi::Object& o, const char* key, const std::string& def) {
+  if (!o.Has(key) || !o.Get(key).IsString()) return def;
+  return o.Get(key).As<Napi::String>().Utf8Value();
+}
+
+static bool GetBool(const Napi::Object& o, const char* key, bool def) {
+  if (!o.Has(key)) return def;
+  return o.Get(key).ToBoolean().Value();
+}
+
+/*────────────────────────── Worker ───────────────────────────────────*/
+class PipelineWorker final : public EngineWorker {
+public:
+  PipelineWorker(Napi::Function cb,
+                 const Napi::Value& imgVal,
+                 const Napi::Array& opsArray,
+                 std::string outputFormat,
+                 int quality = 90,
+                 EncodeOptions encodeOpts = {},
+                 OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "pipeline"),
+      outputFormat_(std::move(outputFormat)),
+      quality_(quality),
+      encodeOpts_(std::move(encodeOpts)),
+      out_(std::move(outTarget))
+  {
+    Napi::Env env = imgVal.Env();
+    // Bad inputs and ops come back through the callback, as in the other
+    // workers
+    try {
+      input_ = PrepareInput(imgVal);                   // decode deferred to Execute()
+
+      ops_.reserve(opsArray.Length());
+      for (uint32_t i = 0; i < opsArray.Length(); ++i) {
+        Napi::Value v = opsArray.Get(i);
+        if (!v.IsObject()) {
+          throw Napi::TypeError::New(env, "pipeline: op " + std::to_string(i) + " must be an object");
+        }
+        ops_.push_back(ParseOp(env, v.As<Napi::Object>(), i));
+      }
+    } catch (const Napi::Error& e) {
+      SetError(e.Message());
+    }
+  }
+
+protected:
+  void Execute() override {
+    /* ─ convertMs: main input + blend overlays, decoded in parallel ─ */
+    const int64 c0 = cv::getTickCount();
+    // A decoded input is ours and can be written in place (unless the
+    // decode cache shares it with other jobs)
+    const bool inputEncoded = input_.IsEncoded();
+    // A leading resize lets JPEG inputs decode already downscaled (DCT)
+    if (!ops_.empty() && ops_[0].type == OpType::RESIZE) {
+      DecodeForResize(input_, ops_[0].resize);
+    } else if (!ops_.empty() && ops_[0].type == OpType::LETTERBOX) {
+      DecodeForLetterbox(input_, ops_[0].letterbox);
+    } else {
+      DecodeInput(input_);
+    }
+    if (!overlays_.empty()) DecodeInputs(overlays_);
+    convertMs_ = (cv::getTickCount() - c0) / cv::getTickFrequency() * 1e3;
+    const bool inputOwned = inputEncoded && !input_.shared;
+
+    /* ─ taskMs: every op works on the previous result (views when possible) ─ */
+    cv::Mat current = input_.mat;
+    channel_ = input_.colorSpace;
+    stepMs_.reserve(ops_.size());
+    stepGpu_.reserve(ops_.size());
+    JobCounters* counters = JobCounters::Current();     // gpuOps tells the step's device
+
+    const int64 t0 = cv::getTickCount();
+    cv::Size sourceSize = input_.sourceSize;     // full-res size of `current`
+    for (const auto& op : ops_) {
+      const int64 s0 = cv::getTickCount();
+      const uint64_t gpu0 = counters ? counters->gpuOps.load() : 0;
+      switch (op.type) {
+        case OpType::RESIZE:  current = ApplyResize(current, op.resize, sourceSize); break;
+        case OpType::CROP:    current = ApplyCrop(current, op.crop); break;
+        case OpType::ROTATE:  current = ApplyRotate(current, channel_, op.rotate); break;
+        case OpType::FILTER:  current = ApplyFilter(current, op.filter); break;
+        case OpType::PADDING: current = ApplyPadding(current, channel_, op.padding); break;
+        case OpType::LETTERBOX:
+          current = ApplyLetterbox(current, channel_, op.letterbox, sourceSize, &letterboxInfo_);
+          hasLetterbox_ = true;
+          break;
+        case OpType::BLEND: {
+          const InputImage& ov = overlays_[op.blendInput];
+          if (op.place) {
+            const cv::Mat mask = op.maskInput >= 0 ? overlays_[op.maskInput].mat : cv::Mat();
+            // Intermediates (and decoded inputs) are ours: blend into them in place
+            const bool owned = inputOwned || current.datastart != input_.mat.datastart;
+            current = ApplyPlaceBlend(current, channel_, ov.mat, ov.colorSpace, mask,
+                                      op.placeParams, owned);
+            break;
+          }
+          std::string outChannel;
+          current = ApplyBlend(current, channel_, ov.mat, ov.colorSpace, op.opacity, outChannel);
+          channel_ = outChannel;
+          break;
+        }
+      }
+      sourceSize = current.size();
+      stepMs_.push_back((cv::getTickCount() - s0) / cv::getTickFrequency() * 1e3);
+      stepGpu_.push_back(counters && counters->gpuOps.load() != gpu0);
+    }
+    result_ = current;
+    taskMs_ = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+
+    /* ─ encodeMs ─ */
+    if (outputFormat_ != "raw") {
+      encodeMs_ = EncodeImage(result_, channel_, encodedBuf_, outputFormat_, quality_, encodeOpts_);
+    }
+    out_.Capture(outputFormat_, result_, encodedBuf_, channel_);
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Value jsImg = out_.ToJS(env, outputFormat_, result_, channel_, encodedBuf_);
+
+    Napi::Object timing = TimingJS(convertMs_, taskMs_, encodeMs_);
+    Napi::Array steps = Napi::Array::New(env, ops_.size());
+    for (size_t i = 0; i < ops_.size(); ++i) {
+      Napi::Object s = Napi::Object::New(env);
+      s.Set("op", Napi::String::New(env, ops_[i].name));
+      s.Set("ms", Napi::Number::New(env, stepMs_[i]));
+      s.Set("device", Napi::String::New(env, stepGpu_[i] ? "gpu" : "cpu"));
+      steps.Set(static_cast<uint32_t>(i), s);
+    }
+    timing.Set("steps", steps);
+
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("image",  jsImg);
+    out.Set("timing", timing);
+    // Geometry of the last letterbox op, relative to that op's input
+    if (hasLetterbox_) out.Set("letterbox", LetterboxInfoJS(env, letterboxInfo_));
+    out_.AttachPreview(out);
+    Callback().Call({ env.Null(), out });
+  }
+
+  void OnError(const Napi::Error& e) override {
+    Callback().Call({ e.Value(), Env().Null() });
+  }
+
+private:
+  PipelineOp ParseOp(Napi::Env env, const Napi::Object& o, uint32_t idx) {
+    PipelineOp op;
+    op.name = GetString(o, "type", "");
+
+    if (op.name == "resize") {
+      op.type = OpType::RESIZE;
+      op.resize.widthMode   = GetString(o, "widthMode", "set");
+      op.resize.widthValue  = GetNumber(o, "width", std::numeric_limits<double>::quiet_NaN());
+      op.resize.heightMode  = GetString(o, "heightMode", "set");
+      op.resize.heightValue = GetNumber(o, "height", std::numeric_limits<double>::quiet_NaN());
+    } else if (op.name == "crop") {
+      op.type = OpType::CROP;
+      op.crop.x          = GetNumber(o, "x", 0);
+      op.crop.y          = GetNumber(o, "y", 0);
+      op.crop.width      = GetNumber(o, "width", 0);
+      op.crop.height     = GetNumber(o, "height", 0);
+      op.crop.normalized = GetBool(o, "normalized", false);
+    } else if (op.name == "rotate") {
+      op.type = OpType::ROTATE;
+      op.rotate.angleDeg = GetNumber(o, "angle", 0);
+      op.rotate.padColor = ParseColor(GetString(o, "padColor", "#000000"));
+    } else if (op.name == "filter") {
+      op.type = OpType::FILTER;
+      op.filter.type       = GetString(o, "filterType", "blur");
+      op.filter.kernelSize = static_cast<int>(GetNumber(o, "kernelSize", 3));
+      op.filter.intensity  = GetNumber(o, "intensity", 1.0);
+    } else if (op.name == "padding") {
+      op.type = OpType::PADDING;
+      op.padding.top      = static_cast<int>(GetNumber(o, "top", 0));
+      op.padding.bottom   = static_cast<int>(GetNumber(o, "bottom", 0));
+      op.padding.left     = static_cast<int>(GetNumber(o, "left", 0));
+      op.padding.right    = static_cast<int>(GetNumber(o, "right", 0));
+      op.padding.padColor = ParseColor(GetString(o, "color", "#000000"));
+    } else if (op.name == "letterbox") {
+      op.type = OpType::LETTERBOX;
+      op.letterbox.width    = static_cast<int>(GetNumber(o, "width", 640));
+      op.letterbox.height   = static_cast<int>(GetNumber(o, "height", 640));
+      op.letterbox.padColor = ParseColor(GetString(o, "padColor", "#727272"));
+      op.letterbox.align    = GetString(o, "align", "center");
+      op.letterbox.scaleUp  = GetBool(o, "scaleUp", true);
+    } else if (op.name == "blend") {
+      op.type = OpType::BLEND;
+      if (!o.Has("image")) {
+        throw Napi::TypeError::New(env, "pipeline: blend op " + std::to_string(idx) + " needs an 'image'");
+      }
+      overlays_.push_back(PrepareInput(o.Get("image")));
+      op.blendInput = static_cast<int>(overlays_.size()) - 1;
+      op.opacity = std::max(0.0, std::min(1.0, GetNumber(o, "opacity", 0.5)));
+
+      // Placement: the op image is an overlay at (x, y), weighted by opacity
+      const std::string mode = GetString(o, "mode", "");
+      const bool hasMask = o.Has("mask") && o.Get("mask").IsObject();
+      op.place = mode == "place" ||
+                 (mode != "stretch" && (o.Has("x") || o.Has("y") || hasMask));
+      if (op.place) {
+        op.placeParams.x = static_cast<int>(std::lround(GetNumber(o, "x", 0)));
+        op.placeParams.y = static_cast<int>(std::lround(GetNumber(o, "y", 0)));
+        op.placeParams.opacity = std::max(0.0, std::min(1.0, GetNumber(o, "opacity", 1.0)));
+        if (hasMask) {
+          overlays_.push_back(PrepareInput(o.Get("mask")));
+          op.maskInput = static_cast<int>(overlays_.size()) - 1;
+        }
+      }
+    } else {
+      throw Napi::TypeError::New(env, "pipeline: unknown op type '" + op.name + "' at index " + std::to_string(idx));
+    }
+    return op;
+  }
+
+  InputImage input_;
+  std::vector<InputImage> overlays_;     // second inputs of blend ops
+  std::vector<PipelineOp> ops_;
+  cv::Mat result_;
+  std::string channel_;
+  LetterboxInfo letterboxInfo_;
+  bool hasLetterbox_ = false;
+
+  std::string outputFormat_;
+  int quality_;
+  EncodeOptions encodeOpts_;
+  OutputTarget out_;
+
+  double convertMs_{0.0}, taskMs_{0.0}, encodeMs_{0.0};
+  std::vector<double> stepMs_;
+  std::vector<bool> stepGpu_;
+  std::vector<uchar> encodedBuf_;
+};
+
+/*──────── binding: pipeline(image, ops, [outputFormat], [quality], [pngOptimize], callback) ─*/
+Napi::Value Pipeline(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 3 || info.Length() > 6 || !info[1].IsArray() ||
+      !info[info.Length()-1].IsFunction()) {
+    Napi::TypeError::New(env,
+      "pipeline(image, ops, [outputFormat], [quality], [pngOptimize], callback)")
+      .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int i = 0;
+  Napi::Value img = info[i++];
+  Napi::Array ops = info[i++].As<Napi::Array>();
+
+  // Handle parameters
+  std::string outputFormat = "raw";
+  int quality = 90;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
+
+  if (info.Length() - i >= 2) {
+    outputFormat = info[i++].As<Napi::String>().Utf8Value();
+  }
+
+  if (info.Length() - i >= 2) {
+    quality = info[i++].As<Napi::Number>().Int32Value();
+  }
+
+  if (info.Length() - i >= 2) {
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
+  }
+
+  Napi::Function cb = info[i].As<Napi::Function>();
+
+  (new PipelineWorker(cb, img, ops, outputFormat, quality, encodeOpts, std::move(outTarget)))->Queue(job);
+  return env.Undefined();
+}
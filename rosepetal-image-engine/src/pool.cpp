@@ -0,0 +1,23 @@
+// ───────── src/pool.cpp ──────────────────────────────────────────────────
+// poolStats(): synchronous snapshot of the frame pool (src/memory/frame-pool.h)
+#include <napi.h>
+#include "memory/frame-pool.h"
+
+/*──────── binding: poolStats() → { hits, misses, recycled, dropped, idleBytes, liveBytes, idleLimit } ─*/
+Napi::Value PoolStats(const Napi::CallbackInfo& info)
+{
+  Napi::Env env = info.Env();
+  const FramePool::Stats s = FramePool::Instance().GetStats();
+
+  Napi::Object o = Napi::Object::New(env);
+  o.Set("hits",      Napi::Number::New(env, static_cast<double>(s.hits)));
+  o.Set("misses",    Napi::Number::New(env, static_cast<double>(s.misses)));
+  o.Set("recycled",  Napi::Number::New(env, static_cast<double>(s.recycled)));
+  o.Set("dropped",   Napi::Number::New(env, static_cast<double>(s.dropped)));
+  o.Set("idleBytes", Napi::Number::New(env, static_cast<double>(s.idleBytes)));
+  o.Set("liveBytes", Napi::Number::New(env, static_cast<double>(s.liveBytes)));
+  o.Set("idleLimit", Napi::Number::New(env, static_cast<double>(s.idleLimit)));
+  const uint64_t requests = s.hits + s.misses;
+  o.Set("hitRate",   Napi::Number::New(env, requests ? static_cast<double>(s.hits) / requests : 0.0));
+  return o;
+}
@@ -3,15 +3,59 @@
 #include <napi.h>
 #include <opencv2/opencv.hpp>
 #include <chrono>
-#include <cstring>
 #include <string>
 #include <vector>
 #include <cmath>
 #include <utility>  
 #include <limits> 
 #include "utils.h"
+#include "ops.h"
+#include "runtime/device.h"
 
-class ResizeWorker : public Napi::AsyncWorker {
+/*──────────────────────── core op (shared with pipeline) ───────────────*/
+cv::Size ResolveResizeTarget(const cv::Size& src, const ResizeParams& p) {
+  auto calcDim = [](int orig, const std::string& mode, double val) -> int {
+    if (std::isnan(val)) return 0;  // Auto
+    return mode == "multiply"
+           ? static_cast<int>(std::lround(orig * val))
+           : static_cast<int>(std::lround(val));
+  };
+
+  int w = calcDim(src.width,  p.widthMode,  p.widthValue);
+  int h = calcDim(src.height, p.heightMode, p.heightValue);
+
+  if (!w && !h)
+    throw std::runtime_error("Both dimensions are Auto");
+
+  if (!w) w = std::lround(h * (double)src.width  / src.height);
+  if (!h) h = std::lround(w * (double)src.height / src.width);
+
+  return cv::Size(w, h);
+}
+
+cv::Mat ApplyResize(const cv::Mat& src, const ResizeParams& p) {
+  return ApplyResize(src, p, src.size());
+}
+
+cv::Mat ApplyResize(const cv::Mat& src, const ResizeParams& p, const cv::Size& sourceSize) {
+  const cv::Size target = ResolveResizeTarget(sourceSize, p);
+  // Large frames: OpenCL resize when configure({ device }) allows it
+  return OnDevice(GpuOp::RESIZE, static_cast<double>(src.total()),
+    [&] { cv::Mat dst; cv::resize(src, dst, target, 0, 0, cv::INTER_LINEAR); return dst; },
+    [&] { cv::UMat dst; cv::resize(Upload(src), dst, target, 0, 0, cv::INTER_LINEAR); return dst; });
+}
+
+double DecodeForResize(InputImage& in, const ResizeParams& p) {
+  int reduce = 1;
+  cv::Size full;
+  int components = 0;
+  if (in.IsEncoded() && ProbeJpegSize(in.encoded, in.encodedSize, full, components)) {
+    reduce = ChooseReducedScale(full, ResolveResizeTarget(full, p));
+  }
+  return DecodeInput(in, reduce);
+}
+
+class ResizeWorker : public EngineWorker {
 public:
 ResizeWorker(Napi::Function& callback,
   const Napi::Value& inputImage,
@@ -19,37 +63,17 @@ ResizeWorker(Napi::Function& callback,
   std::string heightMode, double heightValue,
   std::string outputFormat,
   int quality = 90,
-  bool pngOptimize = false)
-  : Napi::AsyncWorker(callback),
+  EncodeOptions encodeOpts = {},
+  OutputTarget outTarget = OutputTarget(),
+  StreamMode streamMode = StreamMode::OFF)
+  : EngineWorker(callback, "resize"),
   widthMode(std::move(widthMode)),   widthValue(widthValue),
   heightMode(std::move(heightMode)), heightValue(heightValue),
-  outputFormat(std::move(outputFormat)), quality(quality), pngOptimize(pngOptimize){
+  outputFormat(std::move(outputFormat)), quality(quality), encodeOpts(encodeOpts),
+  outTarget(std::move(outTarget)), streamMode(streamMode){
 
     try {
-      auto t0 = std::chrono::steady_clock::now();
-      inputMat = ConvertToMat(inputImage);
-      auto t1 = std::chrono::steady_clock::now();
-      convertMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
-
-      if (inputImage.IsObject() && !inputImage.IsBuffer()) {
-        Napi::Object obj = inputImage.As<Napi::Object>();
-        
-        // Check for colorSpace field
-        if (obj.Has("colorSpace")) {
-          channelOrder = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-        }
-        // Default based on channel count
-        else {
-          channelOrder = (inputMat.channels() == 4) ? "BGRA"
-                       : (inputMat.channels() == 3) ? "BGR"
-                       : "GRAY";
-        }
-      } else {
-        // Buffer input - determine from OpenCV Mat
-        channelOrder = (inputMat.channels() == 4) ? "BGRA"
-                     : (inputMat.channels() == 3) ? "BGR"
-                     : "GRAY";
-      }
+      input = PrepareInput(inputImage);   // decode deferred to Execute()
     } catch (const Napi::Error& e) {
       SetError(e.Message());
     }
@@ -58,81 +82,62 @@ ResizeWorker(Napi::Function& callback,
 protected:
   void Execute() override {
     try {
-        // --- 4.1 Calcular ancho/alto objetivo --------------------------
-        auto calcDim = [](int orig, const std::string& mode, double val) -> int {
-          if (std::isnan(val)) return 0;  // Auto
-          return mode == "multiply"
-                 ? static_cast<int>(std::lround(orig * val))
-                 : static_cast<int>(std::lround(val));
-        };
-      
-        targetWidth  = calcDim(inputMat.cols, widthMode,  widthValue);
-        targetHeight = calcDim(inputMat.rows, heightMode, heightValue);
-
-        if (!targetWidth && !targetHeight)
-            throw std::runtime_error("Both dimensions are Auto");
-
-        if (!targetWidth)
-            targetWidth  = std::lround(targetHeight *
-                        (double)inputMat.cols / inputMat.rows);
-        if (!targetHeight)
-            targetHeight = std::lround(targetWidth  *
-                        (double)inputMat.rows / inputMat.cols);
-
-        // --- 4.2 Redimensionar ----------------------------------------
+        // --- 4.0 Decodificar en el hilo de trabajo ---------------------
+        // (JPEG que se va a reducir ≥2× → decodificación escalada en DCT)
+        const ResizeParams params{ widthMode, widthValue, heightMode, heightValue };
+
+        // Very large JPEGs: decode / resize / encode in row strips
+        if (ShouldStream(input, streamMode)) {
+          StreamResult s;
+          StreamResize(input, params, outputFormat, quality, s);
+          convertMs = s.decodeMs;
+          taskMs = s.taskMs;
+          channelOrder = s.colorSpace;
+          resultMat = s.mat;
+          if (s.encodedDone) {
+            encodedBuf = std::move(s.encoded);
+            encodeMs = s.encodeMs;
+          } else if (outputFormat != "raw") {
+            encodeMs = EncodeImage(resultMat, channelOrder, encodedBuf, outputFormat, quality, encodeOpts);
+          }
+          outTarget.Capture(outputFormat, resultMat, encodedBuf, channelOrder);
+          return;
+        }
+
+        convertMs = DecodeForResize(input, params);
+        inputMat = input.mat;
+        channelOrder = input.colorSpace;
+
+        // --- 4.1 Redimensionar ----------------------------------------
         auto t0 = std::chrono::steady_clock::now();
-        cv::resize(inputMat, resultMat,
-                  cv::Size(targetWidth, targetHeight),
-                  0, 0, cv::INTER_LINEAR);
+        resultMat = ApplyResize(inputMat, params, input.sourceSize);
         auto t1 = std::chrono::steady_clock::now();
         taskMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
 
-        // --- 4.3 Multi-format encoding -----------------------------
+        // --- 4.2 Multi-format encoding -----------------------------
         if (outputFormat != "raw") {
-          // Convert to BGR if needed for encoding
-          const cv::Mat& srcForEncoding =
-                (channelOrder == "BGR") ? resultMat
-                                        : ToBgrForJpg(resultMat, channelOrder);
-      
-          encodeMs = EncodeToFormat(srcForEncoding, encodedBuf, outputFormat, quality, pngOptimize);
+          // JPEG via TurboJPEG straight from channelOrder; BGR otherwise
+          encodeMs = EncodeImage(resultMat, channelOrder, encodedBuf, outputFormat, quality, encodeOpts);
         }
+        outTarget.Capture(outputFormat, resultMat, encodedBuf, channelOrder);
     } catch (const std::exception& e) {
         SetError(e.what());
     }
   }
 
 
-  // Fichero: src/resize.cpp (OnOK corregido y final)
-
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value imageResult; // Usamos un Napi::Value para guardar el resultado de la imagen
-
-    // --- Lógica de la Imagen ---
-    if (outputFormat != "raw") {
-        // Return encoded buffer (JPG/PNG/WebP)
-        uint8_t* encodedData = new uint8_t[encodedBuf.size()];
-        std::memcpy(encodedData, encodedBuf.data(), encodedBuf.size());
-        imageResult = Napi::Buffer<uint8_t>::New(
-            env, encodedData, encodedBuf.size(),
-            [](Napi::Env, uint8_t* p){ delete[] p; }
-        );
-    } else {
-        // Return raw image object using new format
-        imageResult = MatToRawJS(env, resultMat, channelOrder);
-    }
 
-    // --- Lógica de Tiempos (siempre se añade) ---
-    Napi::Object timingObj = Napi::Object::New(env);
-    timingObj.Set("convertMs", Napi::Number::New(env, convertMs));
-    timingObj.Set("taskMs",   Napi::Number::New(env, taskMs));
-    timingObj.Set("encodeMs", Napi::Number::New(env, encodeMs));
+    // Encoded buffers and raw Mats are both handed to JS without copying
+    // (or land in the caller's `out` Buffer)
+    Napi::Value imageResult = outTarget.ToJS(env, outputFormat, resultMat, channelOrder, encodedBuf);
 
-    // --- Objeto Final (siempre tiene la misma estructura) ---
     Napi::Object finalResult = Napi::Object::New(env);
-    finalResult.Set("image",  imageResult); // Contiene el Buffer JPG o el Objeto Raw
-    finalResult.Set("timing", timingObj);
+    finalResult.Set("image",  imageResult);
+    finalResult.Set("timing", TimingJS(convertMs, taskMs, encodeMs));
 
+    outTarget.AttachPreview(finalResult);
     Callback().Call({ env.Null(), finalResult });
   }
 
@@ -141,9 +146,8 @@ protected:
   }
 
 private:
+  InputImage input;
   cv::Mat inputMat, resultMat;
-  int targetWidth = 0;
-  int targetHeight = 0;
   std::string widthMode;  
   std::string heightMode;
   double widthValue  = std::numeric_limits<double>::quiet_NaN();
@@ -157,7 +161,9 @@ private:
 
   std::string outputFormat;
   int quality;
-  bool pngOptimize;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  StreamMode streamMode;
   std::vector<uchar> encodedBuf;
   double encodeMs = 0.0;
 };
@@ -174,7 +180,10 @@ Napi::Value Resize(const Napi::CallbackInfo& info) {
 
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
+  StreamMode streamMode = StreamMode::OFF;
   size_t cbIndex = 5;
 
   // Handle parameters
@@ -188,7 +197,10 @@ Napi::Value Resize(const Napi::CallbackInfo& info) {
   } else if (info.Length() == 9) {
     outputFormat = info[5].As<Napi::String>().Utf8Value();
     quality = info[6].As<Napi::Number>().Int32Value();
-    pngOptimize = info[7].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[7]);
+    job        = ParseJobOptions(info[7]);
+    outTarget  = ParseOutputTarget(info[7]);
+    streamMode = ParseStreamMode(info[7]);
     cbIndex = 8;
   }
 
@@ -203,8 +215,10 @@ Napi::Value Resize(const Napi::CallbackInfo& info) {
       info[4].As<Napi::Number>().DoubleValue(),   // heightVal
       outputFormat,                               // outputFormat
       quality,                                    // quality
-      pngOptimize);                               // pngOptimize
+      encodeOpts,                                 // pngOptimize / encode options
+      std::move(outTarget),                       // options.out
+      streamMode);                                // options.streaming
 
-  worker->Queue();
+  worker->Queue(job);
   return env.Undefined();
 }
@@ -4,9 +4,40 @@
 #include <chrono>
 #include <cmath>
 #include "utils.h"          // ParseColor, VectorToBuffer, MatToRawJS…
+#include "ops.h"
+#include "geometry/remap-cache.h"
+
+// ──────────────────────────────── core op (shared with pipeline)
+cv::Mat ApplyRotate(const cv::Mat& src, const std::string& channelOrder,
+                    const RotateParams& p)
+{
+  // Ajustar color al orden real de la imagen
+  cv::Scalar padClrImg = p.padColor;                   // RGB
+  if (channelOrder == "RGB" || channelOrder == "RGBA")
+    std::swap(padClrImg[0], padClrImg[2]);             // → BGR/BGRA
+
+  cv::Mat dst;
+
+  // Fast-path 0/90/180/270°
+  double n = std::fmod(p.angleDeg + 360.0, 360.0), eps = 1e-3;
+  auto near=[&](double a){ return std::abs(n-a)<eps; };
+
+  if (near(0) || near(90) || near(180) || near(270)) {
+    if      (near(0))   dst = src; // alias
+    else if (near(90))  cv::rotate(src,dst,cv::ROTATE_90_CLOCKWISE);
+    else if (near(180)) cv::rotate(src,dst,cv::ROTATE_180);
+    else                cv::rotate(src,dst,cv::ROTATE_90_COUNTERCLOCKWISE);
+  } else {
+    // Ángulos arbitrarios (sempre PAD): tablas de remap cacheadas por
+    // (tamaño, ángulo), el ángulo suele ser fijo por cámara; o warpAffine
+    // en la GPU para imágenes grandes (src/runtime/device.h)
+    dst = RotateOnDevice(GpuOp::WARP, src, p.angleDeg, cv::INTER_LINEAR, padClrImg);
+  }
+  return dst;
+}
 
 // ──────────────────────────────── Worker
-class RotateWorker : public Napi::AsyncWorker {
+class RotateWorker : public EngineWorker {
 public:
   RotateWorker(Napi::Function& cb,
                const Napi::Value& imgVal,
@@ -14,99 +45,52 @@ public:
                cv::Scalar padRGB,   // R,G,B
                std::string outputFormat,
                int quality = 90,
-               bool pngOptimize = false)
-    : Napi::AsyncWorker(cb),
+               EncodeOptions encodeOpts = {},
+               OutputTarget outTarget = OutputTarget())
+    : EngineWorker(cb, "rotate"),
       angleDeg(angDeg),
       padColorRGB(padRGB),
       outputFormat(std::move(outputFormat)),
       quality(quality),
-      pngOptimize(pngOptimize)
+      encodeOpts(encodeOpts),
+      outTarget(std::move(outTarget))
   {
     try {
-      inputMat = ConvertToMat(imgVal);            // zero-copy RAW
-      
-      if (imgVal.IsObject() && !imgVal.IsBuffer()) {
-        Napi::Object obj = imgVal.As<Napi::Object>();
-        
-        // Check for new colorSpace field first
-        if (obj.Has("colorSpace")) {
-          channelOrder = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
-        }
-        // Default based on channel count
-        else {
-          channelOrder = (inputMat.channels() == 4) ? "BGRA"
-                       : (inputMat.channels() == 3) ? "BGR" 
-                       : "GRAY";
-        }
-      } else {
-        // Buffer input - determine from OpenCV Mat
-        channelOrder = (inputMat.channels() == 4) ? "BGRA"
-                     : (inputMat.channels() == 3) ? "BGR"
-                     : "GRAY";
-      }
+      input = PrepareInput(imgVal);               // decode deferred to Execute()
     } catch (const Napi::Error& e) { SetError(e.Message()); }
   }
 
 protected:
   void Execute() override {
     try {
+      convertMs = DecodeInput(input);
+      inputMat = input.mat;
+      channelOrder = input.colorSpace;
+
       auto t0 = std::chrono::steady_clock::now();          
 
-      // Ajustar color al orden real de la imagen
-      padClrImg = padColorRGB;                             // RGB
-      if (channelOrder == "RGB" || channelOrder == "RGBA")
-        std::swap(padClrImg[0], padClrImg[2]);             // → BGR/BGRA
-
-      // Fast-path 0/90/180/270°
-      double n = std::fmod(angleDeg + 360.0, 360.0), eps = 1e-3;
-      auto near=[&](double a){ return std::abs(n-a)<eps; };
-
-      if (near(0) || near(90) || near(180) || near(270)) {
-        if      (near(0))   resultMat = inputMat; // alias
-        else if (near(90))  cv::rotate(inputMat,resultMat,cv::ROTATE_90_CLOCKWISE);
-        else if (near(180)) cv::rotate(inputMat,resultMat,cv::ROTATE_180);
-        else                cv::rotate(inputMat,resultMat,cv::ROTATE_90_COUNTERCLOCKWISE);
-      } else {
-        // Ángulos arbitrarios (sempre PAD)
-        int w=inputMat.cols, h=inputMat.rows;
-        cv::Point2f c(w/2.f,h/2.f);
-        cv::Mat M = cv::getRotationMatrix2D(c, angleDeg, 1.0);
-
-        double cosA=std::abs(M.at<double>(0,0));
-        double sinA=std::abs(M.at<double>(0,1));
-        cv::Size dst(int(h*sinA+w*cosA), int(h*cosA+w*sinA));
-
-        M.at<double>(0,2) += dst.width /2.0 - c.x;
-        M.at<double>(1,2) += dst.height/2.0 - c.y;
-
-        cv::warpAffine(inputMat,resultMat,M,dst,
-                       cv::INTER_LINEAR,cv::BORDER_CONSTANT,padClrImg);
-      }
+      resultMat = ApplyRotate(inputMat, channelOrder, { angleDeg, padColorRGB });
 
       taskMs = std::chrono::duration<double,std::milli>(
                  std::chrono::steady_clock::now() - t0).count(); 
 
       // Multi-format encoding
       if (outputFormat != "raw") {
-        // Convert to BGR if needed for encoding
-        const cv::Mat& srcForEncoding =
-              (channelOrder == "BGR") ? resultMat
-                                      : ToBgrForJpg(resultMat, channelOrder);
-    
-        encodeMs = EncodeToFormat(srcForEncoding, encodedBuf, outputFormat, quality, pngOptimize);
+        // JPEG via TurboJPEG straight from channelOrder; BGR otherwise
+        encodeMs = EncodeImage(resultMat, channelOrder, encodedBuf, outputFormat, quality, encodeOpts);
       }
+      outTarget.Capture(outputFormat, resultMat, encodedBuf, channelOrder);
     } catch (const std::exception& e) { SetError(e.what()); }
   }
 
   void OnOK() override {
     Napi::Env env = Env();
-    Napi::Value jsImg = (outputFormat != "raw")
-        ? VectorToBuffer(env, std::move(encodedBuf))
-        : MatToRawJS(env, resultMat, channelOrder);
+    Napi::Value jsImg = outTarget.ToJS(env, outputFormat, resultMat, channelOrder, encodedBuf);
 
     Napi::Object res = Napi::Object::New(env);
     res.Set("image",  jsImg);
-    res.Set("timing", MakeTimingJS(env, 0.0, taskMs, encodeMs)); // convertMs=0
+    res.Set("timing", TimingJS(convertMs, taskMs, encodeMs));
+    outTarget.AttachPreview(res);
     Callback().Call({ env.Null(), res });
   }
 
@@ -115,14 +99,17 @@ protected:
   }
 
 private:
+  InputImage input;
   cv::Mat inputMat, resultMat;
   double  angleDeg;
-  cv::Scalar padColorRGB, padClrImg;
+  cv::Scalar padColorRGB;
   std::string outputFormat;
   int quality;
-  bool pngOptimize;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
 
   std::string channelOrder;
+  double convertMs = 0.0;
   double taskMs  = 0.0;
   double encodeMs = 0.0;
   std::vector<uchar> encodedBuf;
@@ -148,7 +135,9 @@ Napi::Value Rotate(const Napi::CallbackInfo& info)
   // Handle parameters
   std::string outputFormat = "raw";
   int quality = 90;
-  bool pngOptimize = false;
+  EncodeOptions encodeOpts;
+  OutputTarget outTarget;
+  JobOptions job;
   
   if (info.Length() - i >= 2) {
     outputFormat = info[i++].As<Napi::String>().Utf8Value();
@@ -159,7 +148,9 @@ Napi::Value Rotate(const Napi::CallbackInfo& info)
   }
   
   if (info.Length() - i >= 2) {
-    pngOptimize = info[i++].As<Napi::Boolean>().Value();
+    encodeOpts = ParseEncodeOptions(info[i]);
+    job        = ParseJobOptions(info[i]);
+    outTarget  = ParseOutputTarget(info[i++]);
   }
 
   Napi::Function cb = info[i].As<Napi::Function>();
@@ -171,7 +162,8 @@ Napi::Value Rotate(const Napi::CallbackInfo& info)
       ParseColor(padColorStr),   // RGB
       outputFormat,
       quality,
-      pngOptimize);
-  worker->Queue();
+      encodeOpts,
+      std::move(outTarget));
+  worker->Queue(job);
   return env.Undefined();
 }
\ No newline at end of file
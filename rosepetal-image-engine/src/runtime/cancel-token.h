@@ -0,0 +1,30 @@
+// Fichero: src/runtime/cancel-token.h
+//
+// CancelToken: JS handle over a CancelState (runtime/job-control.h). Pass it
+// as options.cancel to any number of jobs; cancel() stops those still queued
+// or running at their next stage boundary. A token cannot be reset.
+#ifndef CANCEL_TOKEN_H
+#define CANCEL_TOKEN_H
+
+#include <napi.h>
+#include <memory>
+#include "job-control.h"
+
+class CancelToken : public Napi::ObjectWrap<CancelToken> {
+public:
+  // Defines the class for this env and exports it as `CancelToken`
+  static void Init(Napi::Env env, Napi::Object exports);
+
+  // The state behind `v`, or nullptr when `v` is not a CancelToken
+  static std::shared_ptr<CancelState> FromValue(const Napi::Value& v);
+
+  explicit CancelToken(const Napi::CallbackInfo& info);
+
+private:
+  Napi::Value Cancel(const Napi::CallbackInfo& info);
+  Napi::Value GetCancelled(const Napi::CallbackInfo& info);
+
+  std::shared_ptr<CancelState> state_;
+};
+
+#endif // CANCEL_TOKEN_H
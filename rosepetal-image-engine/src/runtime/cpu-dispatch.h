@@ -0,0 +1,97 @@
+// Fichero: src/runtime/cpu-dispatch.h
+//
+// Runtime selection of the hand-written SIMD kernels, so the addon is built
+// for the portable baseline of its architecture (no -march=native) and
+// still uses the widest vectors of the host it runs on.
+// - Baseline kernels use OpenCV universal intrinsics: SSE2 on x86-64, NEON
+//   on arm64 (always present there, so arm64 has nothing to dispatch).
+// - On x86 with GCC/Clang the hot 8-bit kernels (alpha blending in
+//   src/compositing/alpha-blend.h, the tensor row in src/codecs/tensor.h)
+//   also have sse4.2 / avx2 / avx512 variants, compiled through function
+//   target attributes and picked once per call with PickSimd().
+// - The level is the best the CPU (and OS) supports; ROSEPETAL_SIMD
+//   ("baseline" | "sse4.2" | "avx2" | "avx512") caps it, e.g. to compare
+//   variants or to rule one out on a suspicious host.
+// - stats().cpu reports the active and the detected level.
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <cstdlib>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROSEPETAL_X86_SIMD 1
+#include <immintrin.h>
+#define ROSEPETAL_TARGET_SSE42  __attribute__((target("sse4.2")))
+#define ROSEPETAL_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define ROSEPETAL_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx2,fma")))
+// x86 variant of a kernel, nullptr where it is not compiled
+#define SIMD_VARIANT(fn) fn
+#else
+#define ROSEPETAL_X86_SIMD 0
+#define SIMD_VARIANT(fn) nullptr
+#endif
+
+enum class SimdLevel { BASELINE = 0, SSE42, AVX2, AVX512 };
+
+inline const char* SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::SSE42:  return "sse4.2";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    default: break;
+  }
+#if defined(__aarch64__) || defined(__ARM_NEON)
+  return "neon";
+#elif defined(__x86_64__) || defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+// Best level of this CPU that has kernels compiled for it
+inline SimdLevel DetectedSimd() {
+  static const SimdLevel level = [] {
+#if ROSEPETAL_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+      return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return SimdLevel::SSE42;
+#endif
+    return SimdLevel::BASELINE;
+  }();
+  return level;
+}
+
+// Level the kernels run at: DetectedSimd() capped by ROSEPETAL_SIMD
+inline SimdLevel ActiveSimd() {
+  static const SimdLevel level = [] {
+    const SimdLevel hw = DetectedSimd();
+    const char* v = std::getenv("ROSEPETAL_SIMD");
+    if (!v || !*v) return hw;
+    const std::string s = v;
+    SimdLevel cap = hw;
+    if (s == "baseline" || s == "sse2" || s == "neon") cap = SimdLevel::BASELINE;
+    else if (s == "sse4.2") cap = SimdLevel::SSE42;
+    else if (s == "avx2")   cap = SimdLevel::AVX2;
+    return cap < hw ? cap : hw;
+  }();
+  return level;
+}
+
+// Widest available variant of a kernel (nullptr entries are skipped)
+template <class Fn>
+inline Fn PickSimd(Fn baseline, Fn sse42, Fn avx2, Fn avx512) {
+  switch (ActiveSimd()) {
+    case SimdLevel::AVX512: if (avx512) return avx512; [[fallthrough]];
+    case SimdLevel::AVX2:   if (avx2)   return avx2;   [[fallthrough]];
+    case SimdLevel::SSE42:  if (sse42)  return sse42;  [[fallthrough]];
+    default:                return baseline;
+  }
+}
+
+#endif // CPU_DISPATCH_H
@@ -0,0 +1,167 @@
+// Fichero: src/runtime/device.h
+//
+// Optional OpenCL execution through OpenCV's T-API (cv::UMat), for the
+// compute-bound parts of resize, rotate, filter, blend and advanced mosaic
+// (and the same ops inside pipeline).
+// - configure({ device }): "cpu" (default), "gpu" (every supported call is
+//   offloaded) or "auto" (offloaded when the image has at least the op's
+//   gpuMinPixels). ROSEPETAL_DEVICE sets the initial value.
+// - Offloading copies the input into device memory and the result back, so
+//   small images stay on the CPU: the per-op thresholds are where the
+//   kernel time saved outweighs those two transfers on a typical iGPU.
+//   Memory-bound work (crop, padding, copies, plain mosaic) always runs on
+//   the CPU.
+// - Without an OpenCL device (or an OpenCV built without it) everything runs
+//   on the CPU. An OpenCL failure re-runs the call on the CPU and is counted
+//   in stats().device.fallbacks.
+// - Jobs count the calls that ran on the device (JobCounters::gpuOps); the
+//   timing object reports device: "gpu" | "cpu".
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include "metrics.h"
+
+enum class GpuOp { RESIZE = 0, WARP, FILTER, BLEND, MOSAIC, COUNT };
+
+inline const char* GpuOpName(GpuOp op) {
+  switch (op) {
+    case GpuOp::RESIZE: return "resize";
+    case GpuOp::WARP:   return "rotate";
+    case GpuOp::FILTER: return "filter";
+    case GpuOp::BLEND:  return "blend";
+    default:            return "mosaic";
+  }
+}
+
+class ComputeDevice {
+public:
+  enum class Mode { CPU, GPU, AUTO };
+  static constexpr int kOps = static_cast<int>(GpuOp::COUNT);
+
+  struct Config {
+    Mode mode = Mode::CPU;
+    double minPixels[kOps] = {
+      2e6,    // resize: source pixels
+      1e6,    // rotate: arbitrary angles (warpAffine)
+      1e6,    // filter
+      4e6,    // blend: two uploads for one cheap addWeighted
+      2e6,    // mosaic: per tile resize
+    };
+  };
+
+  struct Stats {
+    bool available = false;
+    std::string name;                    // OpenCL device, empty if none
+    uint64_t offloaded = 0, fallbacks = 0;
+  };
+
+  static ComputeDevice& Instance() {
+    static ComputeDevice* device = new ComputeDevice();
+    return *device;
+  }
+
+  // mode < 0 keeps the current one; minPixels[i] < 0 keeps that threshold
+  Config Configure(int mode, const double (&minPixels)[kOps]) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mode >= 0) config_.mode = static_cast<Mode>(mode);
+    for (int i = 0; i < kOps; ++i) {
+      if (minPixels[i] >= 0) config_.minPixels[i] = minPixels[i];
+    }
+    mode_ = static_cast<int>(config_.mode);
+    for (int i = 0; i < kOps; ++i) threshold_[i] = config_.minPixels[i];
+    return config_;
+  }
+
+  Config GetConfig() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+  }
+
+  // Probes OpenCL on first use (platform enumeration can take a while)
+  Stats GetStats() {
+    Stats s;
+    s.available = Available();
+    if (s.available) s.name = cv::ocl::Device::getDefault().name();
+    s.offloaded = offloaded_;
+    s.fallbacks = fallbacks_;
+    return s;
+  }
+
+  // Whether a call of `op` on an image of `pixels` runs on the device
+  bool Offload(GpuOp op, double pixels) {
+    const Mode mode = static_cast<Mode>(mode_.load(std::memory_order_relaxed));
+    if (mode == Mode::CPU) return false;
+    if (mode == Mode::AUTO &&
+        pixels < threshold_[static_cast<int>(op)].load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return Available();
+  }
+
+  void CountOffload() {
+    ++offloaded_;
+    if (JobCounters* c = JobCounters::Current()) ++c->gpuOps;
+  }
+  void CountFallback() { ++fallbacks_; }
+
+private:
+  ComputeDevice() {
+    const char* v = std::getenv("ROSEPETAL_DEVICE");
+    const std::string d = v ? v : "";
+    if (d == "gpu")       config_.mode = Mode::GPU;
+    else if (d == "auto") config_.mode = Mode::AUTO;
+    mode_ = static_cast<int>(config_.mode);
+    for (int i = 0; i < kOps; ++i) threshold_[i] = config_.minPixels[i];
+  }
+
+  bool Available() {
+    std::call_once(probe_, [&] {
+      available_ = cv::ocl::haveOpenCL() && cv::ocl::Device::getDefault().available();
+    });
+    return available_;
+  }
+
+  mutable std::mutex mutex_;
+  Config config_;
+  std::atomic<int> mode_{0};             // lock-free copies read by Offload()
+  std::atomic<double> threshold_[kOps];
+  std::once_flag probe_;
+  bool available_ = false;
+  std::atomic<uint64_t> offloaded_{0}, fallbacks_{0};
+};
+
+// Runs `gpu` (UMat in → UMat out) when `op` is offloaded for `pixels`,
+// otherwise `cpu` (Mat in → Mat out). The device result is copied back into
+// a Mat; an OpenCL error falls back to `cpu`.
+template <typename Cpu, typename Gpu>
+cv::Mat OnDevice(GpuOp op, double pixels, Cpu&& cpu, Gpu&& gpu) {
+  ComputeDevice& device = ComputeDevice::Instance();
+  if (device.Offload(op, pixels)) {
+    try {
+      cv::Mat out;
+      gpu().copyTo(out);
+      device.CountOffload();
+      return out;
+    } catch (const cv::Exception&) {
+      device.CountFallback();
+    }
+  }
+  return cpu();
+}
+
+// Host → device copy of `m` (the Mat may be shared or a view into JS memory,
+// so it is never mapped in place)
+inline cv::UMat Upload(const cv::Mat& m) {
+  cv::UMat u;
+  m.copyTo(u);
+  return u;
+}
+
+#endif // DEVICE_H
@@ -0,0 +1,70 @@
+// Fichero: src/runtime/job-control.h
+//
+// Deadlines, cancellation and "latest frame wins" for engine jobs.
+// - options.deadlineMs: budget from the call; a job still queued when it
+//   expires is dropped without running, a running one stops at the next
+//   stage boundary (after each decode, before each encode, between the
+//   strips of a streamed JPEG).
+// - options.cancel: CancelToken (src/runtime/cancel-token.h); cpp-bridge.js
+//   maps options.signal (AbortSignal) onto one. Checked at the same points.
+// - options.latestKey: a new job with the same key drops the previous one
+//   while it is still queued (EngineThreadPool::Submit), so a slow consumer
+//   processes the newest frame of a source instead of a growing backlog.
+// Dropped jobs fail with err.code ERR_DEADLINE / ERR_CANCELLED /
+// ERR_SUPERSEDED.
+
+#ifndef JOB_CONTROL_H
+#define JOB_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "metrics.h"
+
+// Shared by a CancelToken and every job it was passed to
+struct CancelState {
+  std::atomic<bool> cancelled{false};
+};
+
+struct JobControl {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point deadline = Clock::time_point::max();   // max = none
+  std::shared_ptr<CancelState> cancel;
+  std::string latestKey;                                   // empty = never superseded
+
+  // Error code when the job should stop now, nullptr otherwise
+  const char* Stopped() const {
+    if (cancel && cancel->cancelled.load(std::memory_order_relaxed)) return "ERR_CANCELLED";
+    if (deadline != Clock::time_point::max() && Clock::now() >= deadline) return "ERR_DEADLINE";
+    return nullptr;
+  }
+};
+
+// Thrown at a stage boundary; EngineWorker turns it into err.code
+class JobStopped : public std::runtime_error {
+public:
+  JobStopped(const char* code, const std::string& stage)
+    : std::runtime_error(std::string(code) == "ERR_CANCELLED"
+                           ? "Job cancelled before " + stage
+                           : "Job deadline exceeded before " + stage),
+      code_(code) {}
+
+  const char* Code() const { return code_; }
+
+private:
+  const char* code_;
+};
+
+// Stage boundary of the running job (no-op outside jobs / without limits).
+// Parallel bodies that collect errors as strings call it again before
+// rethrowing, so a stop inside a body keeps its err.code.
+inline void CheckJob(const char* stage) {
+  const JobCounters* c = JobCounters::Current();
+  if (!c || !c->control) return;
+  if (const char* code = c->control->Stopped()) throw JobStopped(code, stage);
+}
+
+#endif // JOB_CONTROL_H
@@ -0,0 +1,194 @@
+// Fichero: src/runtime/metrics.h
+//
+// Per-job counters and engine-wide latency statistics.
+// - JobCounters: bytes in/out, decode vs wrap time, decode-cache hits,
+//   frame allocations and OpenCL calls of the running job. EngineWorker
+//   binds one to its pool thread; parallel_for_ bodies that decode, allocate
+//   or encode rebind it with JobCountersScope so helper threads report to
+//   the same job. It also carries the job's deadline / cancellation
+//   (runtime/job-control.h) to the stage checks.
+// - LatencyHistogram: log-scale buckets (4 per octave, 10 µs … ~3 min);
+//   percentiles are bucket upper bounds, i.e. ≤ 19 % high.
+// - EngineStats: per-op histograms and throughput counters behind stats().
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct JobControl;
+
+struct JobCounters {
+  std::atomic<int64_t>  decodeNs{0};     // imdecode of encoded inputs
+  std::atomic<int64_t>  wrapNs{0};       // zero-copy wrapping of raw inputs
+  std::atomic<uint64_t> bytesIn{0};
+  std::atomic<uint64_t> bytesOut{0};
+  std::atomic<uint64_t> allocations{0};  // pooled Mat allocations
+  std::atomic<uint64_t> cacheHits{0};    // decode cache (src/codecs/decode-cache.h)
+  std::atomic<uint64_t> cacheMisses{0};
+  std::atomic<uint64_t> gpuOps{0};       // calls offloaded (src/runtime/device.h)
+  const JobControl* control = nullptr;   // deadline / cancellation of the job
+
+  // Counters of the job running on this thread (nullptr outside jobs)
+  static JobCounters*& Current() {
+    thread_local JobCounters* current = nullptr;
+    return current;
+  }
+};
+
+// Binds `c` to the calling thread for the lifetime of the scope
+class JobCountersScope {
+public:
+  explicit JobCountersScope(JobCounters* c) : prev_(JobCounters::Current()) {
+    JobCounters::Current() = c;
+  }
+  ~JobCountersScope() { JobCounters::Current() = prev_; }
+
+  JobCountersScope(const JobCountersScope&) = delete;
+  JobCountersScope& operator=(const JobCountersScope&) = delete;
+
+private:
+  JobCounters* prev_;
+};
+
+inline void CountInput(size_t bytes, double ms, bool decoded) {
+  JobCounters* c = JobCounters::Current();
+  if (!c) return;
+  c->bytesIn += bytes;
+  (decoded ? c->decodeNs : c->wrapNs) += static_cast<int64_t>(ms * 1e6);
+}
+
+inline void CountOutput(size_t bytes) {
+  if (JobCounters* c = JobCounters::Current()) c->bytesOut += bytes;
+}
+
+inline void CountDecodeCache(bool hit) {
+  if (JobCounters* c = JobCounters::Current()) ++(hit ? c->cacheHits : c->cacheMisses);
+}
+
+inline void CountAllocation() {
+  if (JobCounters* c = JobCounters::Current()) ++c->allocations;
+}
+
+// What a finished job reports in its timing object and to EngineStats
+struct JobMetrics {
+  double queueMs = 0.0;      // Queue() → picked up by a pool thread
+  double runMs = 0.0;        // Execute() on the pool thread
+  double totalMs = 0.0;      // Queue() → callback
+  double convertMs = 0.0, taskMs = 0.0, encodeMs = 0.0;   // as reported by the op
+  double decodeMs = 0.0, wrapMs = 0.0;                    // split of convertMs, summed per input
+  uint64_t bytesIn = 0, bytesOut = 0, allocations = 0;
+  uint64_t cacheHits = 0, cacheMisses = 0;                // decode cache, per encoded input
+  uint64_t gpuOps = 0;                                    // OpenCL calls
+  int thread = -1;           // engine thread index
+};
+
+/*────────────────────────── histogram ────────────────────────────────*/
+class LatencyHistogram {
+public:
+  static constexpr int kBuckets = 96;
+  static constexpr double kMinMs = 0.01;
+
+  static double UpperBound(int i) { return kMinMs * std::exp2(i / 4.0); }
+
+  void Add(double ms) {
+    int i = 0;
+    if (ms > kMinMs) i = static_cast<int>(std::ceil(4.0 * std::log2(ms / kMinMs)));
+    ++buckets_[std::min(i, kBuckets - 1)];
+    ++count_;
+    sum_ += ms;
+    max_ = std::max(max_, ms);
+  }
+
+  // q in [0, 1]; 0 when empty
+  double Percentile(double q) const {
+    if (!count_) return 0.0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count_)));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) return std::min(UpperBound(i), max_);
+    }
+    return max_;
+  }
+
+  uint64_t Count() const { return count_; }
+  double Mean() const { return count_ ? sum_ / count_ : 0.0; }
+  double Max() const { return max_; }
+
+private:
+  uint64_t buckets_[kBuckets] = {};
+  uint64_t count_ = 0;
+  double sum_ = 0.0;
+  double max_ = 0.0;
+};
+
+/*────────────────────────── engine stats ─────────────────────────────*/
+class EngineStats {
+public:
+  struct OpStats {
+    uint64_t count = 0, errors = 0;
+    uint64_t bytesIn = 0, bytesOut = 0, allocations = 0;
+    uint64_t gpu = 0;                    // jobs with at least one OpenCL call
+    LatencyHistogram totalMs, queueMs, convertMs, taskMs, encodeMs;
+  };
+
+  struct Snapshot {
+    double uptimeMs = 0.0;
+    double windowMs = 0.0;               // since the last Reset()
+    std::map<std::string, OpStats> ops;
+  };
+
+  static EngineStats& Instance() {
+    static EngineStats* stats = new EngineStats();
+    return *stats;
+  }
+
+  void Record(const std::string& op, const JobMetrics& m, bool ok) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpStats& s = ops_[op];
+    ++s.count;
+    if (!ok) { ++s.errors; return; }     // failed jobs only count
+    s.bytesIn     += m.bytesIn;
+    s.bytesOut    += m.bytesOut;
+    s.allocations += m.allocations;
+    if (m.gpuOps) ++s.gpu;
+    s.totalMs.Add(m.totalMs);
+    s.queueMs.Add(m.queueMs);
+    s.convertMs.Add(m.convertMs);
+    s.taskMs.Add(m.taskMs);
+    s.encodeMs.Add(m.encodeMs);
+  }
+
+  Snapshot Get() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    Snapshot s;
+    s.uptimeMs = std::chrono::duration<double, std::milli>(now - started_).count();
+    s.windowMs = std::chrono::duration<double, std::milli>(now - reset_).count();
+    s.ops = ops_;
+    return s;
+  }
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ops_.clear();
+    reset_ = std::chrono::steady_clock::now();
+  }
+
+private:
+  EngineStats() : started_(std::chrono::steady_clock::now()), reset_(started_) {}
+
+  mutable std::mutex mutex_;
+  std::chrono::steady_clock::time_point started_, reset_;
+  std::map<std::string, OpStats> ops_;
+};
+
+#endif // METRICS_H
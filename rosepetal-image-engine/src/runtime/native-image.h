@@ -0,0 +1,52 @@
+// Fichero: src/runtime/native-image.h
+//
+// NativeImage: opaque JS handle over an engine cv::Mat (outputFormat
+// "native"). Handles go straight back into any binding as input — the Mat
+// header is shared (refcounted), so a chain of engine nodes never copies
+// pixels through JS.
+// - width / height / channels / colorSpace / dtype are plain accessors.
+// - `data` returns a new Buffer copy on every read: writing into it never
+//   reaches the handle (read it once and keep it when it is needed twice).
+// - toObject() returns the usual {data, width, height, channels, colorSpace,
+//   dtype} image object, with such a copy.
+// The pixels are immutable once wrapped: every op reads its input and
+// writes a new Mat, so one handle can feed several jobs at once.
+#ifndef NATIVE_IMAGE_H
+#define NATIVE_IMAGE_H
+
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <string>
+
+class NativeImage : public Napi::ObjectWrap<NativeImage> {
+public:
+  // Defines the class for this env and exports it as `NativeImage`
+  static void Init(Napi::Env env, Napi::Object exports);
+
+  // JS thread: wraps `mat` (shared, not copied) in a new handle
+  static Napi::Object New(Napi::Env env, const cv::Mat& mat, const std::string& colorSpace);
+
+  // The handle behind `v`, or nullptr when `v` is not a NativeImage
+  static NativeImage* FromValue(const Napi::Value& v);
+
+  explicit NativeImage(const Napi::CallbackInfo& info);
+  void Finalize(Napi::Env env) override;
+
+  const cv::Mat& Mat() const { return mat_; }
+  const std::string& ColorSpace() const { return colorSpace_; }
+
+private:
+  Napi::Value GetWidth(const Napi::CallbackInfo& info);
+  Napi::Value GetHeight(const Napi::CallbackInfo& info);
+  Napi::Value GetChannels(const Napi::CallbackInfo& info);
+  Napi::Value GetColorSpace(const Napi::CallbackInfo& info);
+  Napi::Value GetDtype(const Napi::CallbackInfo& info);
+  Napi::Value GetData(const Napi::CallbackInfo& info);
+  Napi::Value ToObject(const Napi::CallbackInfo& info);
+
+  cv::Mat mat_;
+  std::string colorSpace_;
+  int64_t externalBytes_ = 0;
+};
+
+#endif // NATIVE_IMAGE_H
@@ -0,0 +1,519 @@
+// Fichero: src/runtime/worker-pool.h
+//
+// Engine-owned worker pool. Image jobs no longer go through the libuv
+// threadpool (4 threads by default, shared with fs/dns/crypto):
+// - EngineThreadPool: N dedicated threads, three priority queues
+//   (high / normal / low, strict order) and an optional queue limit. When
+//   the limit is hit a new job is either rejected or, with the "shed"
+//   policy, evicts the oldest queued job of equal or lower priority.
+// - EngineWorker: drop-in for Napi::AsyncWorker (Execute / OnOK / OnError /
+//   SetError / Callback / Env / Queue). Completions come back to the JS
+//   thread through one thread-safe function per env. Each job measures its
+//   queue wait, run time and JobCounters (runtime/metrics.h) and reports
+//   them to EngineStats under its op name.
+// - Jobs carry a JobControl (runtime/job-control.h): expired / cancelled
+//   jobs are dropped before Execute and stop at stage boundaries; a queued
+//   job is superseded by a newer one with the same latestKey. Errors of
+//   dropped, rejected and shed jobs carry err.code.
+// - OpenCV's own pool is sized so that engine threads plus parallel_for_
+//   helpers do not oversubscribe the CPU (see ConfigurePool()).
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "cancel-token.h"
+#include "job-control.h"
+#include "metrics.h"
+
+enum class JobPriority { HIGH = 0, NORMAL = 1, LOW = 2 };
+
+inline const char* JobPriorityName(JobPriority p) {
+  switch (p) {
+    case JobPriority::HIGH: return "high";
+    case JobPriority::LOW:  return "low";
+    default:                return "normal";
+  }
+}
+
+// options.priority → "high" | "normal" | "low" (anything else → normal)
+inline JobPriority ParseJobPriority(const Napi::Value& opts) {
+  if (!opts.IsObject() || opts.IsBuffer()) return JobPriority::NORMAL;
+  Napi::Object o = opts.As<Napi::Object>();
+  if (!o.Has("priority") || !o.Get("priority").IsString()) return JobPriority::NORMAL;
+  const std::string p = o.Get("priority").As<Napi::String>().Utf8Value();
+  if (p == "high") return JobPriority::HIGH;
+  if (p == "low")  return JobPriority::LOW;
+  return JobPriority::NORMAL;
+}
+
+struct JobOptions {
+  JobPriority priority = JobPriority::NORMAL;
+  JobControl control;
+};
+
+// options.priority, options.deadlineMs (from now), options.cancel
+// (CancelToken) and options.latestKey (string)
+inline JobOptions ParseJobOptions(const Napi::Value& opts) {
+  JobOptions job;
+  job.priority = ParseJobPriority(opts);
+  if (!opts.IsObject() || opts.IsBuffer()) return job;
+  Napi::Object o = opts.As<Napi::Object>();
+
+  if (o.Has("deadlineMs") && o.Get("deadlineMs").IsNumber()) {
+    const double ms = o.Get("deadlineMs").ToNumber().DoubleValue();
+    if (std::isfinite(ms)) {
+      job.control.deadline = JobControl::Clock::now() +
+          std::chrono::duration_cast<JobControl::Clock::duration>(
+              std::chrono::duration<double, std::milli>(std::max(0.0, ms)));
+    }
+  }
+  if (o.Has("cancel")) job.control.cancel = CancelToken::FromValue(o.Get("cancel"));
+  if (o.Has("latestKey") && o.Get("latestKey").IsString()) {
+    job.control.latestKey = o.Get("latestKey").As<Napi::String>().Utf8Value();
+  }
+  return job;
+}
+
+class EngineWorker;
+
+// Per-env state, stored with Env::SetInstanceData in the module Init(); one
+// per isolate that loads the addon (main thread, each worker_thread). Freed
+// with the env, whose teardown also closes the thread-safe function.
+struct AddonData {
+  Napi::ThreadSafeFunction completions;  // delivers EngineWorker results
+  int inFlight = 0;                      // queued + running jobs of this env
+  Napi::FunctionReference nativeImage;   // NativeImage constructor of this env
+  Napi::FunctionReference cancelToken;   // CancelToken constructor of this env
+};
+
+inline void InitAddonData(Napi::Env env) {
+  auto* data = new AddonData();
+  data->completions = Napi::ThreadSafeFunction::New(
+      env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+      "rosepetal-engine", 0, 1);
+  data->completions.Unref(env);          // only keeps the loop alive while jobs run
+  env.SetInstanceData(data);
+}
+
+/*────────────────────────── thread pool ──────────────────────────────*/
+class EngineThreadPool {
+public:
+  enum class Policy { REJECT, SHED };
+
+  struct Config {
+    int threads = 0;
+    size_t queueLimit = 0;               // 0 = unbounded
+    Policy policy = Policy::REJECT;
+    int opencvThreads = 0;
+  };
+
+  struct Stats {
+    int threads = 0;
+    int running = 0;
+    size_t queued[3] = { 0, 0, 0 };
+    uint64_t completed = 0, rejected = 0, shed = 0;
+    uint64_t expired = 0, cancelled = 0, superseded = 0;
+  };
+
+  // Never destroyed: detached threads keep using it until the process ends
+  static EngineThreadPool& Instance() {
+    static EngineThreadPool* pool = new EngineThreadPool();
+    return *pool;
+  }
+
+  // threads ≤ 0 keeps the current value; opencvThreads ≤ 0 derives it
+  Config Configure(int threads, long queueLimit, int policy, int opencvThreads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EnsureDefaults();
+    if (threads > 0) config_.threads = threads;
+    if (queueLimit >= 0) config_.queueLimit = static_cast<size_t>(queueLimit);
+    if (policy >= 0) config_.policy = static_cast<Policy>(policy);
+    config_.opencvThreads = opencvThreads > 0 ? opencvThreads
+                                              : DefaultOpenCvThreads(config_.threads);
+    cv::setNumThreads(config_.opencvThreads);
+    Spawn();
+    wake_.notify_all();                  // surplus threads exit on wake-up
+    return config_;
+  }
+
+  Config GetConfig() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EnsureDefaults();
+    return config_;
+  }
+
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    s.threads = live_;
+    s.running = running_;
+    for (int q = 0; q < 3; ++q) s.queued[q] = queues_[q].size();
+    return s;
+  }
+
+  // Index of the calling engine thread, -1 on any other thread
+  static int& ThreadIndex() {
+    thread_local int index = -1;
+    return index;
+  }
+
+  // false → rejected (queue full). `shed` receives a job evicted to make
+  // room and `superseded` the queued job with the same latestKey; the
+  // caller must complete both with an error.
+  bool Submit(EngineWorker* w, EngineWorker*& shed, EngineWorker*& superseded);
+
+  // A job dropped for its deadline / cancellation (JobStopped codes)
+  void CountStopped(const char* code) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++(std::string(code) == "ERR_CANCELLED" ? stats_.cancelled : stats_.expired);
+  }
+
+private:
+  EngineThreadPool() = default;
+
+  static int Hardware() {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Engine threads each may run one parallel_for_ at a time; OpenCV only
+  // serves one of them with its pool, so N + M − 1 ≤ cores
+  static int DefaultOpenCvThreads(int engineThreads) {
+    return std::max(1, Hardware() - engineThreads + 1);
+  }
+
+  static long EnvNumber(const char* name, long def) {
+    const char* v = std::getenv(name);
+    return (v && *v) ? std::strtol(v, nullptr, 10) : def;
+  }
+
+  // First use: ROSEPETAL_THREADS / ROSEPETAL_QUEUE_LIMIT, else half the cores
+  void EnsureDefaults() {
+    if (config_.threads > 0) return;
+    config_.threads = static_cast<int>(
+        std::max(1L, EnvNumber("ROSEPETAL_THREADS", std::max(2, Hardware() / 2))));
+    config_.queueLimit = static_cast<size_t>(std::max(0L, EnvNumber("ROSEPETAL_QUEUE_LIMIT", 0)));
+    config_.opencvThreads = DefaultOpenCvThreads(config_.threads);
+    cv::setNumThreads(config_.opencvThreads);
+  }
+
+  void Spawn() {
+    while (live_ < config_.threads) {
+      ++live_;
+      std::thread(&EngineThreadPool::Run, this, nextIndex_++).detach();
+    }
+  }
+
+  size_t Queued() const {
+    return queues_[0].size() + queues_[1].size() + queues_[2].size();
+  }
+
+  void Run(int index);
+
+  // Removes `w` from the queues (false if a pool thread already took it)
+  bool Unqueue(EngineWorker* w) {
+    for (auto& q : queues_) {
+      auto it = std::find(q.begin(), q.end(), w);
+      if (it != q.end()) { q.erase(it); return true; }
+    }
+    return false;
+  }
+
+  void ForgetLatest(EngineWorker* w);
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<EngineWorker*> queues_[3];  // indexed by JobPriority
+  std::unordered_map<std::string, EngineWorker*> latest_;  // latestKey → queued job
+  Config config_;
+  Stats stats_;
+  int live_ = 0;
+  int running_ = 0;
+  int nextIndex_ = 0;
+};
+
+/*────────────────────────── worker base ──────────────────────────────*/
+class EngineWorker {
+public:
+  virtual ~EngineWorker() = default;
+
+  EngineWorker(const EngineWorker&) = delete;
+  EngineWorker& operator=(const EngineWorker&) = delete;
+
+  // JS thread. The worker owns itself from here and is deleted after its
+  // OnOK / OnError ran.
+  void Queue(const JobOptions& job = {}) {
+    Napi::Env env = Env();
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data->inFlight++ == 0) data->completions.Ref(env);
+    completions_ = data->completions;
+    priority_ = job.priority;
+    control_ = job.control;
+    enqueued_ = std::chrono::steady_clock::now();
+
+    EngineThreadPool& pool = EngineThreadPool::Instance();
+    if (const char* code = control_.Stopped()) {
+      pool.CountStopped(code);
+      Fail(code, std::string(code) == "ERR_CANCELLED" ? "Job cancelled before it was queued"
+                                                      : "Job deadline exceeded before it was queued");
+      Post();
+      return;
+    }
+
+    const std::string priority = JobPriorityName(priority_);
+    EngineWorker* shed = nullptr;
+    EngineWorker* superseded = nullptr;
+    if (!pool.Submit(this, shed, superseded)) {
+      Fail("ERR_QUEUE_FULL", "Engine queue full; " + priority + " priority job rejected");
+      Post();
+    }
+    if (shed) {
+      shed->Fail("ERR_SHED", "Job shed from the engine queue to make room for a " +
+                             priority + " priority job");
+      shed->Post();
+    }
+    if (superseded) {
+      superseded->Fail("ERR_SUPERSEDED", "Job superseded by a newer frame (latestKey \"" +
+                                         control_.latestKey + "\")");
+      superseded->Post();
+    }
+  }
+
+protected:
+  // `op` names the job in stats() ("resize", "batch.crop"…)
+  explicit EngineWorker(const Napi::Function& callback, const char* op = "job")
+    : env_(callback.Env()), callback_(Napi::Persistent(callback)), op_(op) {}
+
+  virtual void Execute() = 0;
+
+  virtual void OnOK() {
+    Callback().Call({ Env().Null() });
+  }
+
+  virtual void OnError(const Napi::Error& e) {
+    Callback().Call({ e.Value() });
+  }
+
+  void SetError(const std::string& error) { error_ = error; }
+
+  Napi::FunctionReference& Callback() { return callback_; }
+  Napi::Env Env() const { return Napi::Env(env_); }
+  JobPriority Priority() const { return priority_; }
+  const JobMetrics& Metrics() const { return metrics_; }
+
+  // JS thread (OnOK): the op's own stage times plus what the engine measured
+  Napi::Object TimingJS(double convertMs, double taskMs, double encodeMs) {
+    metrics_.convertMs = convertMs;
+    metrics_.taskMs    = taskMs;
+    metrics_.encodeMs  = encodeMs;
+
+    Napi::Env env = Env();
+    Napi::Object t = Napi::Object::New(env);
+    t.Set("convertMs",   Napi::Number::New(env, convertMs));
+    t.Set("taskMs",      Napi::Number::New(env, taskMs));
+    t.Set("encodeMs",    Napi::Number::New(env, encodeMs));
+    t.Set("queueMs",     Napi::Number::New(env, metrics_.queueMs));
+    t.Set("decodeMs",    Napi::Number::New(env, metrics_.decodeMs));
+    t.Set("wrapMs",      Napi::Number::New(env, metrics_.wrapMs));
+    t.Set("bytesIn",     Napi::Number::New(env, static_cast<double>(metrics_.bytesIn)));
+    t.Set("bytesOut",    Napi::Number::New(env, static_cast<double>(metrics_.bytesOut)));
+    t.Set("allocations", Napi::Number::New(env, static_cast<double>(metrics_.allocations)));
+    t.Set("cacheHits",   Napi::Number::New(env, static_cast<double>(metrics_.cacheHits)));
+    t.Set("cacheMisses", Napi::Number::New(env, static_cast<double>(metrics_.cacheMisses)));
+    t.Set("device",      Napi::String::New(env, metrics_.gpuOps ? "gpu" : "cpu"));
+    t.Set("thread",      Napi::Number::New(env, metrics_.thread));
+    return t;
+  }
+
+private:
+  friend class EngineThreadPool;
+
+  void Fail(const char* code, const std::string& error) {
+    errorCode_ = code;
+    error_ = error;
+  }
+
+  // Pool thread. An error set earlier (constructor, rejection) or a job
+  // that expired / was cancelled while queued skips Execute.
+  void RunOnPool() {
+    const auto started = std::chrono::steady_clock::now();
+    metrics_.queueMs = std::chrono::duration<double, std::milli>(started - enqueued_).count();
+    metrics_.thread = EngineThreadPool::ThreadIndex();
+
+    if (error_.empty()) {
+      if (const char* code = control_.Stopped()) {
+        EngineThreadPool::Instance().CountStopped(code);
+        Fail(code, std::string(code) == "ERR_CANCELLED" ? "Job cancelled while queued"
+                                                        : "Job deadline exceeded while queued");
+      }
+    }
+
+    if (error_.empty()) {
+      JobCounters counters;
+      counters.control = &control_;
+      JobCountersScope scope(&counters);
+      try {
+        Execute();
+      } catch (const JobStopped& e) {
+        EngineThreadPool::Instance().CountStopped(e.Code());
+        Fail(e.Code(), e.what());
+      } catch (const std::exception& e) {
+        SetError(e.what());
+      } catch (...) {
+        SetError("Unknown error in engine worker");
+      }
+      metrics_.decodeMs    = counters.decodeNs / 1e6;
+      metrics_.wrapMs      = counters.wrapNs / 1e6;
+      metrics_.bytesIn     = counters.bytesIn;
+      metrics_.bytesOut    = counters.bytesOut;
+      metrics_.allocations = counters.allocations;
+      metrics_.cacheHits   = counters.cacheHits;
+      metrics_.cacheMisses = counters.cacheMisses;
+      metrics_.gpuOps      = counters.gpuOps;
+    }
+    metrics_.runMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+    Post();
+  }
+
+  // Fails (napi_closing) only when the env went away while the job ran, e.g.
+  // a terminated worker_thread; the worker's references into that env cannot
+  // be released from here, so it is left behind rather than deleted.
+  void Post() {
+    completions_.NonBlockingCall(this, [](Napi::Env env, Napi::Function, EngineWorker* w) {
+      w->Complete(env);
+    });
+  }
+
+  // JS thread, via the env's thread-safe function
+  void Complete(Napi::Env env) {
+    std::unique_ptr<EngineWorker> self(this);
+    Napi::HandleScope scope(env);
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (--data->inFlight == 0) data->completions.Unref(env);
+
+    // As Napi::AsyncWorker: a callback that throws surfaces as an uncaught
+    // JS exception instead of unwinding out of the thread-safe function
+    const bool ok = error_.empty();
+    try {
+      if (ok) {
+        OnOK();
+      } else {
+        Napi::Error e = Napi::Error::New(env, error_);
+        if (errorCode_) e.Set("code", Napi::String::New(env, errorCode_));
+        OnError(e);
+      }
+    } catch (const Napi::Error& e) {
+      e.ThrowAsJavaScriptException();
+    } catch (const std::exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+    }
+
+    metrics_.totalMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - enqueued_).count();
+    EngineStats::Instance().Record(op_, metrics_, ok);
+  }
+
+  napi_env env_;
+  Napi::FunctionReference callback_;
+  Napi::ThreadSafeFunction completions_;
+  std::string error_;
+  const char* errorCode_ = nullptr;      // err.code, static string
+  JobPriority priority_ = JobPriority::NORMAL;
+  JobControl control_;
+  std::string op_;
+  std::chrono::steady_clock::time_point enqueued_;
+  JobMetrics metrics_;
+};
+
+inline bool EngineThreadPool::Submit(EngineWorker* w, EngineWorker*& shed,
+                                     EngineWorker*& superseded) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EnsureDefaults();
+  Spawn();
+
+  // The queued job with the same latestKey leaves when this one gets in,
+  // so its slot counts as free; a rejected job supersedes nothing.
+  const std::string& key = w->control_.latestKey;
+  EngineWorker* previous = nullptr;
+  if (!key.empty()) {
+    auto it = latest_.find(key);
+    if (it != latest_.end()) previous = it->second;
+  }
+
+  const int p = static_cast<int>(w->priority_);
+  const size_t queued = Queued() - (previous ? 1 : 0);
+  if (config_.queueLimit && queued >= config_.queueLimit) {
+    if (config_.policy == Policy::SHED) {
+      for (int q = 2; q >= p && !shed; --q) {
+        for (auto it = queues_[q].begin(); it != queues_[q].end(); ++it) {
+          if (*it == previous) continue;
+          shed = *it;
+          queues_[q].erase(it);
+          ForgetLatest(shed);
+          ++stats_.shed;
+          break;
+        }
+      }
+    }
+    if (!shed) { ++stats_.rejected; return false; }
+  }
+
+  if (previous) {
+    if (Unqueue(previous)) {
+      superseded = previous;
+      ++stats_.superseded;
+    }
+    latest_.erase(key);
+  }
+  queues_[p].push_back(w);
+  if (!key.empty()) latest_[key] = w;
+  wake_.notify_one();
+  return true;
+}
+
+// Called with mutex_ held once `w` leaves the queues
+inline void EngineThreadPool::ForgetLatest(EngineWorker* w) {
+  const std::string& key = w->control_.latestKey;
+  if (key.empty()) return;
+  auto it = latest_.find(key);
+  if (it != latest_.end() && it->second == w) latest_.erase(it);
+}
+
+inline void EngineThreadPool::Run(int index) {
+  ThreadIndex() = index;
+  for (;;) {
+    EngineWorker* w = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return live_ > config_.threads || Queued() > 0; });
+      if (live_ > config_.threads) { --live_; return; }
+      for (auto& q : queues_) {
+        if (!q.empty()) { w = q.front(); q.pop_front(); break; }
+      }
+      ForgetLatest(w);
+      ++running_;
+    }
+
+    w->RunOnPool();                      // `w` may be gone once this returns
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    --running_;
+    ++stats_.completed;
+  }
+}
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,326 @@
+// Fichero: src/streaming.cpp
+//
+// Streaming mode for very large JPEG inputs (line-scan frames of 16k×60k
+// and beyond): decode in row strips, run the op strip by strip and encode
+// rows as they are finished, so the full decoded frame never exists.
+// - filter: each strip is filtered with a halo of kernelSize/2 real rows
+//   on both sides (the frame's own top / bottom rows are image borders as
+//   usual), which makes the result identical to one full-frame pass over
+//   the same decoded pixels (test-streaming.js checks both against
+//   cv::imdecode + the regular op). Strips of one round run in parallel.
+// - crop: rows above the rectangle are skipped and only the iMCU columns
+//   covering it are decoded.
+// - resize: bilinear, separable. Only the source rows an output row samples
+//   are kept (horizontally resized as a batch); the vertical pass runs in
+//   parallel over the round's output rows. Large reductions also use the
+//   DCT-scaled decode. Within ±1 of cv::resize INTER_LINEAR.
+// "jpg" output is encoded row by row; other formats assemble the result Mat
+// (still without the decoded source) and go through EncodeImage as usual.
+#include <napi.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "ops.h"
+#include "codecs/jpeg-strips.h"
+#include "filters/kernels.h"
+
+StreamMode ParseStreamMode(const Napi::Value& opts) {
+  if (!opts.IsObject() || opts.IsBuffer()) return StreamMode::OFF;
+  Napi::Object o = opts.As<Napi::Object>();
+  if (!o.Has("streaming")) return StreamMode::OFF;
+  Napi::Value v = o.Get("streaming");
+  if (v.IsString()) return v.As<Napi::String>().Utf8Value() == "auto" ? StreamMode::AUTO : StreamMode::OFF;
+  return v.ToBoolean().Value() ? StreamMode::ON : StreamMode::OFF;
+}
+
+bool ShouldStream(const InputImage& in, StreamMode mode) {
+#ifdef HAVE_JPEG_STRIPS
+  if (mode == StreamMode::OFF || !in.IsEncoded()) return false;
+  cv::Size size;
+  int components = 0;
+  if (!ProbeJpegSize(in.encoded, in.encodedSize, size, components)) return false;
+  if (components != 1 && components != 3) return false;
+  return mode == StreamMode::ON || double(size.area()) >= kStreamAutoPixels;
+#else
+  (void)in; (void)mode;
+  return false;
+#endif
+}
+
+#ifdef HAVE_JPEG_STRIPS
+namespace {
+
+constexpr size_t kStripBytes = size_t(4) << 20;     // decoded bytes per strip
+
+int StripRows(int width, int channels) {
+  return std::max(16, static_cast<int>(kStripBytes / (size_t(std::max(1, width)) * channels)));
+}
+
+double Ms(int64 t0) { return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3; }
+
+// Finished rows → streamed JPEG, or the result Mat for any other format
+class StripSink {
+public:
+  StripSink(const cv::Size& size, int type, const std::string& order,
+            const std::string& outputFormat, int quality, StreamResult& r)
+    : r_(r),
+      jpeg_(ParseImageFormat(outputFormat) == ImageFormat::JPG)
+  {
+    if (jpeg_) {
+      if (!writer_.Begin(size.width, size.height, CV_MAT_CN(type), order, quality)) {
+        throw std::runtime_error(std::string("streaming encode: ") + writer_.Error());
+      }
+    } else {
+      r_.mat.create(size, type);
+    }
+  }
+
+  void Put(const cv::Mat& rows) {
+    const int64 t0 = cv::getTickCount();
+    if (jpeg_) {
+      if (!writer_.Write(rows)) throw std::runtime_error(std::string("streaming encode: ") + writer_.Error());
+      r_.encodeMs += Ms(t0);
+    } else {
+      rows.copyTo(r_.mat.rowRange(y_, y_ + rows.rows));
+    }
+    y_ += rows.rows;
+  }
+
+  void Finish() {
+    if (!jpeg_) return;
+    const int64 t0 = cv::getTickCount();
+    if (!writer_.Finish(r_.encoded)) throw std::runtime_error(std::string("streaming encode: ") + writer_.Error());
+    r_.encodeMs += Ms(t0);
+    r_.encodedDone = true;
+  }
+
+private:
+  StreamResult& r_;
+  JpegStripWriter writer_;
+  bool jpeg_;
+  int y_ = 0;
+};
+
+void OpenReader(JpegStripReader& reader, const InputImage& in, int reduce) {
+  if (!reader.Open(in.encoded, in.encodedSize, reduce)) {
+    throw std::runtime_error(std::string("streaming decode: ") + reader.Error());
+  }
+}
+
+void ReadRows(JpegStripReader& reader, const cv::Mat& strip, StreamResult& r) {
+  const int64 t0 = cv::getTickCount();
+  if (!reader.Read(strip)) throw std::runtime_error(std::string("streaming decode: ") + reader.Error());
+  r.decodeMs += Ms(t0);
+}
+
+void Begin(InputImage& in, const JpegStripReader& reader, const cv::Size& full, StreamResult& r) {
+  in.colorSpace = reader.Channels() == 1 ? "GRAY" : "BGR";
+  in.sourceSize = full;
+  r.colorSpace = in.colorSpace;
+}
+
+// Input accounting as DecodeInput() would have done; the encoded bytes are
+// released like a decoded input's
+void End(InputImage& in, StreamResult& r) {
+  CountInput(in.encodedSize, r.decodeMs, true);
+  in.encoded = nullptr;
+}
+
+}  // namespace
+
+/*──────────────────────── filter ───────────────────────────────────────*/
+void StreamFilter(InputImage& in, const FilterParams& p,
+                  const std::string& outputFormat, int quality, StreamResult& r) {
+  JpegStripReader reader;
+  OpenReader(reader, in, 1);
+  const int W = reader.Width(), H = reader.Height(), C = reader.Channels();
+  Begin(in, reader, cv::Size(W, H), r);
+
+  const int halo = ValidateKernelSize(p.kernelSize) / 2;
+  const int strip = StripRows(W, C);
+  const int S = strip * std::max(1, cv::getNumThreads());    // output rows per round
+
+  // Rows [wy0, wy1) of the source live in win; each round keeps 2·halo
+  // rows of context from the previous one
+  cv::Mat win(S + 2 * halo, W, CV_8UC(C));
+  cv::Mat out(S, W, CV_8UC(C));
+  int wy0 = 0, wy1 = 0;
+
+  const int64 tOps = cv::getTickCount();
+  StripSink sink(cv::Size(W, H), CV_8UC(C), in.colorSpace, outputFormat, quality, r);
+
+  for (int y0 = 0; y0 < H; y0 += S) {
+    CheckJob("the next strip");
+    const int y1 = std::min(H, y0 + S);
+    const int need0 = std::max(0, y0 - halo), need1 = std::min(H, y1 + halo);
+
+    // Slide the window: keep rows ≥ need0, decode up to need1. The kept
+    // rows start S - halo (first slide) or S rows in and may overlap their
+    // destination for short strips: memmove, win is continuous
+    if (need0 > wy0) {
+      const int keep = wy1 - need0;
+      if (keep > 0) std::memmove(win.ptr(0), win.ptr(need0 - wy0), size_t(keep) * win.step);
+      wy0 = need0;
+    }
+    ReadRows(reader, win.rowRange(wy1 - wy0, need1 - wy0), r);
+    wy1 = need1;
+
+    // Strips of the round in parallel, each with its halo of real rows
+    const int strips = (y1 - y0 + strip - 1) / strip;
+    std::vector<std::string> errors(strips);
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+      JobCountersScope scope(counters);
+      for (int s = range.start; s < range.end; ++s) {
+        try {
+          const int sy0 = y0 + s * strip, sy1 = std::min(y1, sy0 + strip);
+          const int b0 = std::max(0, sy0 - halo), b1 = std::min(H, sy1 + halo);
+          // Own header (no parent ROI): the filter sees the band's edges as
+          // image borders instead of reading stale window rows past them
+          const cv::Mat band(b1 - b0, W, win.type(), win.ptr(b0 - wy0), win.step);
+          const cv::Mat filtered = ApplyFilter(band, p);
+          filtered.rowRange(sy0 - b0, sy1 - b0).copyTo(out.rowRange(sy0 - y0, sy1 - y0));
+        } catch (const std::exception& e) {
+          errors[s] = e.what();
+        }
+      }
+    });
+    for (const auto& e : errors) {
+      if (e.empty()) continue;
+      CheckJob("the next strip");
+      throw std::runtime_error(e);
+    }
+
+    sink.Put(out.rowRange(0, y1 - y0));
+  }
+  sink.Finish();
+  r.taskMs = std::max(0.0, Ms(tOps) - r.decodeMs - r.encodeMs);
+  End(in, r);
+}
+
+/*──────────────────────── crop ─────────────────────────────────────────*/
+void StreamCrop(InputImage& in, const CropParams& p,
+                const std::string& outputFormat, int quality, StreamResult& r) {
+  JpegStripReader reader;
+  OpenReader(reader, in, 1);
+  const cv::Size full(reader.Width(), reader.Height());
+  const int C = reader.Channels();
+  Begin(in, reader, full, r);
+
+  const int64 tOps = cv::getTickCount();
+  const cv::Rect rect = ResolveCropRect(full, p);
+
+  // Narrow the decode to the rectangle's columns (iMCU-aligned)
+  int cx = rect.x, cw = rect.width;
+  if (!reader.CropColumns(cx, cw)) throw std::runtime_error(std::string("streaming decode: ") + reader.Error());
+  const int colOffset = rect.x - cx;
+
+  int64 t0 = cv::getTickCount();
+  if (!reader.Skip(rect.y)) throw std::runtime_error(std::string("streaming decode: ") + reader.Error());
+  r.decodeMs += Ms(t0);
+
+  StripSink sink(rect.size(), CV_8UC(C), in.colorSpace, outputFormat, quality, r);
+  const int strip = StripRows(cw, C);
+  cv::Mat buf(strip, cw, CV_8UC(C));
+  for (int y = 0; y < rect.height; y += strip) {
+    CheckJob("the next strip");
+    const int rows = std::min(strip, rect.height - y);
+    ReadRows(reader, buf.rowRange(0, rows), r);
+    sink.Put(buf(cv::Rect(colOffset, 0, rect.width, rows)));
+  }
+  sink.Finish();
+  r.taskMs = std::max(0.0, Ms(tOps) - r.decodeMs - r.encodeMs);
+  End(in, r);
+}
+
+/*──────────────────────── resize ───────────────────────────────────────*/
+void StreamResize(InputImage& in, const ResizeParams& p,
+                  const std::string& outputFormat, int quality, StreamResult& r) {
+  cv::Size full;
+  int components = 0;
+  ProbeJpegSize(in.encoded, in.encodedSize, full, components);
+  const cv::Size target = ResolveResizeTarget(full, p);
+  if (target.width <= 0 || target.height <= 0) throw std::runtime_error("Resize target must be positive");
+
+  JpegStripReader reader;
+  OpenReader(reader, in, ChooseReducedScale(full, target));
+  const int srcW = reader.Width(), srcH = reader.Height(), C = reader.Channels();
+  Begin(in, reader, full, r);
+
+  const int64 tOps = cv::getTickCount();
+  const double scaleY = static_cast<double>(srcH) / target.height;
+  auto sample = [&](int dy, int& y0, int& y1, float& f) {
+    const double sy = (dy + 0.5) * scaleY - 0.5;
+    const int y = static_cast<int>(std::floor(sy));
+    f = sy <= 0 ? 0.f : static_cast<float>(sy - y);
+    y0 = std::clamp(y, 0, srcH - 1);
+    y1 = std::min(y0 + 1, srcH - 1);
+    if (y >= srcH - 1) f = 0.f;
+  };
+
+  const int strip = StripRows(srcW, C);
+  cv::Mat src(strip, srcW, CV_8UC(C));               // current decoded source strip
+  int sb0 = 0, sb1 = 0;                              // its rows
+  std::map<int, cv::Mat> rowsH;                      // horizontally resized source rows
+
+  const int R = std::max(1, StripRows(target.width, C) * std::max(1, cv::getNumThreads()) / 4);
+  cv::Mat out(R, target.width, CV_8UC(C));
+  StripSink sink(target, CV_8UC(C), in.colorSpace, outputFormat, quality, r);
+
+  for (int dy0 = 0; dy0 < target.height; dy0 += R) {
+    CheckJob("the next strip");
+    const int dy1 = std::min(target.height, dy0 + R);
+
+    // Source rows this round samples, in order
+    std::vector<int> needed;
+    for (int dy = dy0; dy < dy1; ++dy) {
+      int y0, y1; float f;
+      sample(dy, y0, y1, f);
+      if (needed.empty() || needed.back() < y0) needed.push_back(y0);
+      if (needed.back() < y1) needed.push_back(y1);
+    }
+    rowsH.erase(rowsH.begin(), rowsH.lower_bound(needed.front()));
+
+    // Gather the missing ones from the decoded strips, then resize them
+    // horizontally as one batch
+    std::vector<int> missing;
+    for (int y : needed) if (!rowsH.count(y)) missing.push_back(y);
+    if (!missing.empty()) {
+      cv::Mat gathered(static_cast<int>(missing.size()), srcW, CV_8UC(C));
+      for (size_t i = 0; i < missing.size(); ++i) {
+        while (missing[i] >= sb1) {
+          const int rows = std::min(strip, srcH - sb1);
+          ReadRows(reader, src.rowRange(0, rows), r);
+          sb0 = sb1;
+          sb1 += rows;
+        }
+        src.row(missing[i] - sb0).copyTo(gathered.row(static_cast<int>(i)));
+      }
+      cv::Mat resized;
+      cv::resize(gathered, resized, cv::Size(target.width, gathered.rows), 0, 0, cv::INTER_LINEAR);
+      for (size_t i = 0; i < missing.size(); ++i) rowsH[missing[i]] = resized.row(static_cast<int>(i));
+    }
+
+    // Vertical pass over the round's output rows
+    cv::parallel_for_(cv::Range(dy0, dy1), [&](const cv::Range& range) {
+      for (int dy = range.start; dy < range.end; ++dy) {
+        int y0, y1; float f;
+        sample(dy, y0, y1, f);
+        cv::Mat dst = out.row(dy - dy0);
+        if (f == 0.f) rowsH.at(y0).copyTo(dst);
+        else cv::addWeighted(rowsH.at(y0), 1.0 - f, rowsH.at(y1), f, 0.0, dst);
+      }
+    });
+
+    sink.Put(out.rowRange(0, dy1 - dy0));
+  }
+  sink.Finish();
+  r.taskMs = std::max(0.0, Ms(tOps) - r.decodeMs - r.encodeMs);
+  End(in, r);
+}
+#endif // HAVE_JPEG_STRIPS
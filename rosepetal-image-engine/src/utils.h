@@ -8,21 +8,72 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <cstring>
+#include "codecs/decode-cache.h"
+#include "codecs/jpeg-turbo.h"
+#include "codecs/webp.h"
+#include "codecs/tensor.h"
+#include "runtime/native-image.h"
+#include "runtime/worker-pool.h"
+
+/**
+ * Memory behind a byte container, zero-copy: Buffer, any TypedArray view
+ * (including views on a SharedArrayBuffer, honouring byteOffset), DataView
+ * or ArrayBuffer. Returns false for anything else.
+ */
+inline bool GetBytes(const Napi::Value& v, uchar*& data, size_t& length) {
+  if (v.IsTypedArray()) {
+    // Raw call: Napi::TypedArray::ArrayBuffer() refuses shared backing stores
+    napi_typedarray_type type;
+    size_t count = 0, offset = 0;
+    void* ptr = nullptr;
+    napi_value ab;
+    if (napi_get_typedarray_info(v.Env(), v, &type, &count, &ptr, &ab, &offset) != napi_ok) return false;
+    data = static_cast<uchar*>(ptr);
+    length = v.As<Napi::TypedArray>().ByteLength();
+    return true;
+  }
+  if (v.IsDataView()) {
+    Napi::DataView dv = v.As<Napi::DataView>();
+    data = static_cast<uchar*>(dv.Data());
+    length = dv.ByteLength();
+    return true;
+  }
+  if (v.IsArrayBuffer()) {
+    Napi::ArrayBuffer ab = v.As<Napi::ArrayBuffer>();
+    data = static_cast<uchar*>(ab.Data());
+    length = ab.ByteLength();
+    return true;
+  }
+  return false;
+}
+
+inline bool IsBytes(const Napi::Value& v) {
+  return v.IsTypedArray() || v.IsDataView() || v.IsArrayBuffer();
+}
 
 /**
  * Converts JS input to cv::Mat supporting:
- * - Image object: {data, width, height, channels, colorSpace, dtype}
- * - Buffer: Raw image file data (JPEG/PNG/WebP)
+ * - NativeImage handle: its Mat, shared (no copy)
+ * - Image object: {data, width, height, channels, colorSpace, dtype}, where
+ *   data is any byte container accepted by GetBytes()
+ * - Byte container: Raw image file data (JPEG/PNG/WebP)
  */
 inline cv::Mat ConvertToMat(const Napi::Value& input) {
   Napi::Env env = input.Env();
 
+  if (NativeImage* handle = NativeImage::FromValue(input)) return handle->Mat();
+
   // --- 1. Raw image object -------------------------
-  if (input.IsObject() && !input.IsBuffer()) {
+  if (input.IsObject() && !IsBytes(input)) {
     Napi::Object obj = input.As<Napi::Object>();
     if (obj.Has("data") && obj.Has("width") && obj.Has("height")) {
 
-      auto dataBuf = obj.Get("data").As<Napi::Buffer<uint8_t>>();
+      uchar* pixels = nullptr;
+      size_t length = 0;
+      if (!GetBytes(obj.Get("data"), pixels, length)) {
+        throw Napi::TypeError::New(env, "Image data must be a Buffer, TypedArray, DataView or ArrayBuffer");
+      }
       
       int width = obj.Get("width").As<Napi::Number>().Int32Value();
       int height = obj.Get("height").As<Napi::Number>().Int32Value();
@@ -94,14 +145,19 @@ inline cv::Mat ConvertToMat(const Napi::Value& input) {
         }
       }
 
-      return cv::Mat(height, width, cvType, dataBuf.Data());
+      if (width <= 0 || height <= 0 ||
+          length < size_t(width) * height * CV_ELEM_SIZE(cvType)) {
+        throw Napi::Error::New(env, "Image data is smaller than width × height × channels");
+      }
+      return cv::Mat(height, width, cvType, pixels);
     }
   }
 
-  // --- 2. Direct Buffer (JPEG/PNG/WebP file data) -------------------------
-  if (input.IsBuffer()) {
-    auto buf = input.As<Napi::Buffer<uint8_t>>();
-    cv::Mat tmp(1, buf.Length(), CV_8UC1, buf.Data());
+  // --- 2. Direct bytes (JPEG/PNG/WebP file data) -------------------------
+  uchar* bytes = nullptr;
+  size_t length = 0;
+  if (GetBytes(input, bytes, length)) {
+    cv::Mat tmp(1, static_cast<int>(length), CV_8UC1, bytes);
     cv::Mat img = cv::imdecode(tmp, cv::IMREAD_UNCHANGED);
 
     if (img.empty()) {
@@ -111,7 +167,176 @@ inline cv::Mat ConvertToMat(const Napi::Value& input) {
   }
 
   throw Napi::Error::New(env,
-      "Invalid input: Expected Buffer or image object with {data, width, height}.");
+      "Invalid input: Expected encoded bytes (Buffer, TypedArray, ArrayBuffer) or image object with {data, width, height}.");
+}
+
+// Canal por defecto cuando la entrada no trae colorSpace
+inline std::string DefaultChannelOrder(int channels) {
+  return (channels == 4) ? "BGRA" : (channels == 3) ? "BGR" : "GRAY";
+}
+
+/**
+ * Input captured on the JS thread and decoded later on the worker thread.
+ * - Raw image objects are wrapped zero-copy in `mat` straight away.
+ * - Encoded Buffers (JPEG/PNG/WebP) only keep a pointer + length; the
+ *   actual cv::imdecode runs in DecodeInput() from Execute().
+ * The persistent reference keeps the JS memory alive until the worker is
+ * destroyed (always on the main thread).
+ */
+struct InputImage {
+  cv::Mat mat;
+  std::string colorSpace;           // empty → DefaultChannelOrder() after decode
+  const uchar* encoded = nullptr;
+  size_t encodedSize = 0;
+  Napi::ObjectReference ref;
+  cv::Size sourceSize;              // full-resolution size, set by DecodeInput()
+  int decodeScale = 1;              // 2/4/8 when decoded with DCT downscaling
+  bool shared = false;              // `mat` is also in the decode cache: read-only
+
+  bool IsEncoded() const { return encoded != nullptr; }
+};
+
+// Main thread: no pixel work, only JS property reads.
+inline InputImage PrepareInput(const Napi::Value& input) {
+  InputImage in;
+
+  uchar* bytes = nullptr;
+  size_t length = 0;
+  if (GetBytes(input, bytes, length)) {
+    in.encoded = bytes;
+    in.encodedSize = length;
+  } else if (NativeImage* handle = NativeImage::FromValue(input)) {
+    in.mat = handle->Mat();
+    in.colorSpace = handle->ColorSpace();
+  } else {
+    in.mat = ConvertToMat(input);   // validates and throws Napi::Error
+    Napi::Object obj = input.As<Napi::Object>();
+    if (obj.Has("colorSpace")) {
+      in.colorSpace = obj.Get("colorSpace").As<Napi::String>().Utf8Value();
+    }
+  }
+
+  in.ref = Napi::Persistent(input.As<Napi::Object>());
+  return in;
+}
+
+// Reads width/height/components from the JPEG SOFn header without decoding.
+// Returns false for anything that is not a baseline/progressive JPEG.
+inline bool ProbeJpegSize(const uchar* p, size_t n, cv::Size& size, int& components) {
+  if (!p || n < 4 || p[0] != 0xFF || p[1] != 0xD8) return false;
+
+  size_t i = 2;
+  while (i + 4 <= n) {
+    if (p[i] != 0xFF) return false;
+    const uchar m = p[i + 1];
+    if (m == 0xFF) { ++i; continue; }                                  // fill byte
+    if (m == 0x01 || (m >= 0xD0 && m <= 0xD8)) { i += 2; continue; }   // no payload
+    if (m == 0xD9 || m == 0xDA) return false;                          // EOI/SOS before SOF
+
+    const size_t len = (size_t(p[i + 2]) << 8) | p[i + 3];
+    const bool isSof = m >= 0xC0 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC;
+    if (isSof) {
+      if (len < 8 || i + 2 + len > n) return false;
+      size.height = (p[i + 5] << 8) | p[i + 6];
+      size.width  = (p[i + 7] << 8) | p[i + 8];
+      components  = p[i + 9];
+      return size.width > 0 && size.height > 0;
+    }
+    if (len < 2) return false;
+    i += 2 + len;
+  }
+  return false;
+}
+
+// Largest libjpeg DCT scale (8, 4, 2) that still leaves the decoded image at
+// least as large as `target`, so the final resample is always a downscale.
+inline int ChooseReducedScale(const cv::Size& src, const cv::Size& target) {
+  if (target.width <= 0 || target.height <= 0) return 1;
+  for (int f : { 8, 4, 2 }) {
+    const int w = (src.width  + f - 1) / f;     // libjpeg rounds up
+    const int h = (src.height + f - 1) / f;
+    if (w >= target.width && h >= target.height) return f;
+  }
+  return 1;
+}
+
+// Worker thread: decodes encoded inputs (through the decode cache) and
+// resolves the channel order.
+// `reduce` (2/4/8) asks for DCT-domain downscaling; it only applies to JPEG
+// and is ignored otherwise. Returns the elapsed time in ms (≈0 for raw inputs),
+// which also goes to the job's decode or wrap counter.
+inline double DecodeInput(InputImage& in, int reduce = 1) {
+  const int64 t0 = cv::getTickCount();
+  const bool encoded = in.IsEncoded();
+
+  if (encoded) {
+    int flags = cv::IMREAD_UNCHANGED;
+    cv::Size full;
+    int components = 0;
+    if (reduce > 1 && ProbeJpegSize(in.encoded, in.encodedSize, full, components)) {
+      // REDUCED_* implies IMREAD_COLOR/GRAYSCALE, which would honour EXIF
+      // orientation; IMREAD_UNCHANGED does not, so keep it off for parity.
+      const bool gray = components == 1;
+      flags = cv::IMREAD_IGNORE_ORIENTATION |
+          (reduce == 8 ? (gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8)
+         : reduce == 4 ? (gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4)
+         :               (gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2));
+      in.decodeScale = reduce;
+      in.sourceSize = full;
+    }
+
+    cv::Mat tmp(1, static_cast<int>(in.encodedSize), CV_8UC1,
+                const_cast<uchar*>(in.encoded));
+    DecodeCache& cache = DecodeCache::Instance();
+    bool hit = false;
+    in.mat = cache.Get(in.encoded, in.encodedSize, flags, hit,
+                       [&] { return cv::imdecode(tmp, flags); });
+    in.shared = cache.Enabled() && (hit || cache.Holds(in.mat));
+    if (cache.Enabled()) CountDecodeCache(hit);
+    if (in.mat.empty()) {
+      throw std::runtime_error("Failed to decode image buffer.");
+    }
+    in.encoded = nullptr;           // ya decodificado
+  }
+
+  if (in.decodeScale == 1) in.sourceSize = in.mat.size();
+  if (in.colorSpace.empty()) in.colorSpace = DefaultChannelOrder(in.mat.channels());
+
+  const double ms = (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+  CountInput(encoded ? in.encodedSize : in.mat.total() * in.mat.elemSize(), ms, encoded);
+  CheckJob("processing");
+  return ms;
+}
+
+// Worker thread: decodes several inputs in parallel (mosaic, concat…).
+// Returns wall-clock ms for the whole set.
+inline double DecodeInputs(std::vector<InputImage>& inputs) {
+  const int64 t0 = cv::getTickCount();
+  size_t encodedCount = 0;
+  for (const auto& in : inputs) encodedCount += in.IsEncoded() ? 1 : 0;
+
+  if (encodedCount > 1) {
+    std::vector<std::string> errors(inputs.size());
+    JobCounters* counters = JobCounters::Current();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(inputs.size())),
+      [&](const cv::Range& r) {
+        JobCountersScope scope(counters);
+        for (int i = r.start; i < r.end; ++i) {
+          try { DecodeInput(inputs[i]); }
+          catch (const std::exception& e) { errors[i] = e.what(); }
+        }
+      });
+    for (size_t i = 0; i < errors.size(); ++i) {
+      if (!errors[i].empty()) {
+        CheckJob("processing");
+        throw std::runtime_error("Image " + std::to_string(i) + ": " + errors[i]);
+      }
+    }
+  } else {
+    for (auto& in : inputs) DecodeInput(in);
+  }
+
+  return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
 }
 
 
@@ -162,12 +387,102 @@ inline double EncodeToJpgFast(const cv::Mat& src,
   return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
 }
 
+// Encoder tuning shared by every binding. The trailing [pngOptimize]
+// argument accepts the legacy boolean or an object with these keys.
+struct EncodeOptions {
+  std::string pngMode = "none";   // none (level 0) | fast | balanced (6) | max (9)
+  int  webpMethod = -1;           // 0 fastest … 6 smallest; -1 = encoder default
+  bool webpLossless = false;
+  bool webpThreads = false;       // libwebp multi-threaded encode
+  TensorOptions tensor;           // outputFormat "tensor"
+};
+
+// options.tensor: { dtype, channelOrder, mean, std, scale }; mean / std are
+// a number or one value per tensor channel
+inline TensorOptions ParseTensorOptions(const Napi::Value& v) {
+  TensorOptions t;
+  if (!v.IsObject() || v.IsBuffer()) return t;
+  Napi::Object opts = v.As<Napi::Object>();
+  if (!opts.Has("tensor") || !opts.Get("tensor").IsObject()) return t;
+  Napi::Object o = opts.Get("tensor").As<Napi::Object>();
+
+  if (o.Has("dtype") && o.Get("dtype").IsString()) {
+    t.dtype = o.Get("dtype").As<Napi::String>().Utf8Value();
+    if (t.dtype != "float32" && t.dtype != "float16")
+      throw Napi::TypeError::New(v.Env(), "tensor.dtype must be float32 or float16");
+  }
+  if (o.Has("channelOrder") && o.Get("channelOrder").IsString()) {
+    t.channelOrder = o.Get("channelOrder").As<Napi::String>().Utf8Value();
+    if (t.channelOrder != "RGB" && t.channelOrder != "BGR" && t.channelOrder != "GRAY")
+      throw Napi::TypeError::New(v.Env(), "tensor.channelOrder must be RGB, BGR or GRAY");
+  }
+  auto perChannel = [&](const char* key, std::array<double, 3>& dst) {
+    if (!o.Has(key)) return;
+    Napi::Value val = o.Get(key);
+    if (val.IsNumber()) {
+      dst.fill(val.As<Napi::Number>().DoubleValue());
+    } else if (val.IsArray()) {
+      Napi::Array arr = val.As<Napi::Array>();
+      for (uint32_t c = 0; c < 3 && c < arr.Length(); ++c) dst[c] = arr.Get(c).ToNumber().DoubleValue();
+    }
+  };
+  perChannel("mean", t.mean);
+  perChannel("std", t.stddev);
+  if (o.Has("scale") && o.Get("scale").IsNumber()) t.scale = o.Get("scale").As<Napi::Number>().DoubleValue();
+  return t;
+}
+
+// true → "balanced", false → "none" (what pngOptimize used to mean)
+inline EncodeOptions ParseEncodeOptions(const Napi::Value& v) {
+  EncodeOptions o;
+  if (v.IsBoolean()) {
+    o.pngMode = v.As<Napi::Boolean>().Value() ? "balanced" : "none";
+    return o;
+  }
+  if (!v.IsObject()) return o;
+
+  Napi::Object obj = v.As<Napi::Object>();
+  if (obj.Has("pngOptimize"))
+    o.pngMode = obj.Get("pngOptimize").ToBoolean().Value() ? "balanced" : "none";
+  if (obj.Has("pngMode") && obj.Get("pngMode").IsString()) {
+    const std::string m = obj.Get("pngMode").As<Napi::String>().Utf8Value();
+    if (m == "none" || m == "fast" || m == "balanced" || m == "max") o.pngMode = m;
+    else if (!m.empty())
+      throw Napi::TypeError::New(v.Env(), "pngMode must be none, fast, balanced or max");
+  }
+  if (obj.Has("webpMethod") && obj.Get("webpMethod").IsNumber())
+    o.webpMethod = std::max(-1, std::min(6, obj.Get("webpMethod").ToNumber().Int32Value()));
+  if (obj.Has("webpLossless")) o.webpLossless = obj.Get("webpLossless").ToBoolean().Value();
+  if (obj.Has("webpThreads"))  o.webpThreads  = obj.Get("webpThreads").ToBoolean().Value();
+  o.tensor = ParseTensorOptions(v);
+  return o;
+}
+
+// zlib strategy for "fast" PNG: RLE when neighbouring pixels mostly repeat
+// (masks, mosaics over flat backgrounds), FILTERED for photographic content.
+// Samples ~64 rows, so it costs well under the encode itself.
+inline int ChoosePngStrategy(const cv::Mat& src) {
+  if (src.cols < 2 || src.rows < 1) return cv::IMWRITE_PNG_STRATEGY_DEFAULT;
+  const size_t px = src.elemSize();
+  const int rowStep = std::max(1, src.rows / 64);
+  size_t same = 0, total = 0;
+  for (int y = 0; y < src.rows; y += rowStep) {
+    const uchar* row = src.ptr<uchar>(y);
+    for (int x = 1; x < src.cols; ++x) {
+      same += std::memcmp(row + x * px, row + (x - 1) * px, px) == 0;
+    }
+    total += src.cols - 1;
+  }
+  return (same * 2 > total) ? cv::IMWRITE_PNG_STRATEGY_RLE
+                            : cv::IMWRITE_PNG_STRATEGY_FILTERED;
+}
+
 // Enhanced multi-format encoding function
 inline double EncodeToFormat(const cv::Mat& src,
   std::vector<uchar>& out,
   const std::string& format,
   int quality = 90,
-  bool pngOptimize = false)
+  const EncodeOptions& opts = {})
 {
   const int64 t0 = cv::getTickCount();
   ImageFormat fmt = ParseImageFormat(format);
@@ -185,19 +500,28 @@ inline double EncodeToFormat(const cv::Mat& src,
     }
     case ImageFormat::PNG: {
       out.reserve(src.total());
-      // Use compression level 0 (fastest) when pngOptimize is false, 6 (balanced) when true
-      int compressionLevel = pngOptimize ? 6 : 0;
+      int compressionLevel = 0;                          // "none": stored, fastest
+      int strategy = cv::IMWRITE_PNG_STRATEGY_DEFAULT;
+      if (opts.pngMode == "fast") {
+        compressionLevel = 1;
+        strategy = ChoosePngStrategy(src);
+      } else if (opts.pngMode == "balanced") {
+        compressionLevel = 6;
+      } else if (opts.pngMode == "max") {
+        compressionLevel = 9;
+      }
       std::vector<int> params{
         cv::IMWRITE_PNG_COMPRESSION, compressionLevel,
-        cv::IMWRITE_PNG_STRATEGY, cv::IMWRITE_PNG_STRATEGY_DEFAULT
+        cv::IMWRITE_PNG_STRATEGY, strategy
       };
       cv::imencode(".png", src, out, params);
       break;
     }
     case ImageFormat::WEBP: {
       out.reserve(src.total() >> 1);
+      // OpenCV has no method/thread knobs; quality > 100 selects lossless
       std::vector<int> params{
-        cv::IMWRITE_WEBP_QUALITY, quality
+        cv::IMWRITE_WEBP_QUALITY, opts.webpLossless ? 101 : quality
       };
       cv::imencode(".webp", src, out, params);
       break;
@@ -212,6 +536,41 @@ inline double EncodeToFormat(const cv::Mat& src,
 
 
 
+// Encodes `src` whose channel order is `order`. JPEG and WebP go straight
+// from the source pixel format through libjpeg-turbo / libwebp when
+// available; the rest (and the fallback) is converted to BGR and handed to
+// cv::imencode. Returns ms including any channel conversion.
+inline double EncodeImage(const cv::Mat& src,
+  const std::string& order,
+  std::vector<uchar>& out,
+  const std::string& format,
+  int quality = 90,
+  const EncodeOptions& opts = {})
+{
+  CheckJob("encoding");
+  if (format == "native") return 0.0;    // handed over as a NativeImage
+  if (format == "tensor") {
+    out.resize(opts.tensor.Bytes(src.size()));
+    return EncodeTensor(src, order, out.data(), opts.tensor);
+  }
+
+  const int64 t0 = cv::getTickCount();
+  const ImageFormat fmt = ParseImageFormat(format);
+
+  if ((fmt == ImageFormat::JPG && EncodeJpegTurbo(src, order, out, quality)) ||
+      (fmt == ImageFormat::WEBP &&
+       EncodeWebpDirect(src, order, out, quality, opts.webpMethod,
+                        opts.webpLossless, opts.webpThreads))) {
+    return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+  }
+
+  const cv::Mat bgr = ToBgrForJpg(src, order);
+  EncodeToFormat(bgr, out, format, quality, opts);
+  return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+}
+
+
+
 // Devuelve "BGRA", "BGR" o "GRAY" a partir de "int8_BGRA", "int16_GRAY", etc.
 inline std::string ExtractChannelOrder(const std::string& chFull) {
   auto pos = chFull.find('_');
@@ -245,8 +604,17 @@ inline Napi::Value VectorToBuffer(Napi::Env env, std::vector<uchar>&& v)
       [](Napi::Env, uchar*, std::vector<uchar>* p) { delete p; }, vec);
 }
 
-// Converts cv::Mat to new JS format {width, height, channels, colorSpace, dtype, data}
-inline Napi::Object MatToRawJS(Napi::Env env,
+// dtype of an OpenCV depth
+inline const char* DtypeName(int depth) {
+  switch (depth) {
+    case CV_16U: return "uint16";
+    case CV_32F: return "float32";
+    default:     return "uint8";     // CV_8U and fallback
+  }
+}
+
+// {width, height, channels, colorSpace, dtype} for `m`, without "data"
+inline Napi::Object RawHeaderJS(Napi::Env env,
   const cv::Mat& m,
   const std::string& colorSpace)
 {
@@ -255,29 +623,261 @@ inline Napi::Object MatToRawJS(Napi::Env env,
   o.Set("height", Napi::Number::New(env, m.rows));
   o.Set("channels", Napi::Number::New(env, m.channels()));
   o.Set("colorSpace", Napi::String::New(env, colorSpace));
+  o.Set("dtype", Napi::String::New(env, DtypeName(m.depth())));
+  return o;
+}
 
-  // Determine dtype from OpenCV depth
-  std::string dtype;
-  switch (m.depth()) {
-    case CV_8U:  dtype = "uint8"; break;
-    case CV_16U: dtype = "uint16"; break;
-    case CV_32F: dtype = "float32"; break;
-    default:     dtype = "uint8"; break;  // fallback
-  }
-  o.Set("dtype", Napi::String::New(env, dtype));
+// Zero-copy: the Buffer takes a reference to the cv::Mat and releases it in
+// the finalizer. Only non-contiguous ROIs, Mats that wrap external memory
+// (u == nullptr, e.g. a raw JS input aliased by rotate 0°) and views of a
+// decode-cache entry (JS could write into it) get a clone.
+inline Napi::Value MatToBuffer(Napi::Env env, const cv::Mat& m)
+{
+  const size_t bytes = m.total() * m.elemSize();
+  if (bytes == 0) return Napi::Buffer<uint8_t>::New(env, 0);
+
+  const bool alias = m.isContinuous() && m.u != nullptr && !DecodeCache::Instance().Holds(m);
+  auto* owned = alias ? new cv::Mat(m) : new cv::Mat(m.clone());
+  Napi::MemoryManagement::AdjustExternalMemory(env, static_cast<int64_t>(bytes));
+
+  return Napi::Buffer<uint8_t>::NewOrCopy(
+    env, owned->data, bytes,
+    [](Napi::Env env, uint8_t*, cv::Mat* p) {
+      Napi::MemoryManagement::AdjustExternalMemory(
+          env, -static_cast<int64_t>(p->total() * p->elemSize()));
+      delete p;
+    }, owned);
+}
 
-  // Copy data
-  size_t bytes = m.total() * m.elemSize();
-  auto* raw = new uint8_t[bytes];
-  std::memcpy(raw, m.data, bytes);
+inline Napi::Object MatToRawJS(Napi::Env env,
+  const cv::Mat& m,
+  const std::string& colorSpace)
+{
+  Napi::Object o = RawHeaderJS(env, m, colorSpace);
+  o.Set("data", MatToBuffer(env, m));
+  return o;
+}
 
-  o.Set("data", Napi::Buffer<uint8_t>::New(
-    env, raw, bytes,
-    [](Napi::Env, uint8_t* p) { delete[] p; }));
-  
+// { data, dtype, layout: "NCHW", shape: [n, C, H, W], channelOrder, width, height }
+inline Napi::Object TensorJS(Napi::Env env, Napi::Value data, int n,
+                             const cv::Size& size, const TensorOptions& t)
+{
+  Napi::Object o = Napi::Object::New(env);
+  Napi::Array shape = Napi::Array::New(env, 4);
+  shape.Set(0u, Napi::Number::New(env, n));
+  shape.Set(1u, Napi::Number::New(env, t.Channels()));
+  shape.Set(2u, Napi::Number::New(env, size.height));
+  shape.Set(3u, Napi::Number::New(env, size.width));
+  o.Set("data", data);
+  o.Set("dtype", Napi::String::New(env, t.dtype));
+  o.Set("layout", Napi::String::New(env, "NCHW"));
+  o.Set("shape", shape);
+  o.Set("channelOrder", Napi::String::New(env, t.channelOrder));
+  o.Set("width", Napi::Number::New(env, size.width));
+  o.Set("height", Napi::Number::New(env, size.height));
   return o;
 }
 
+// options.preview: { width, quality }. A small JPEG of the result, made on
+// the worker thread from the Mat still in memory (debug displays, UIs), so
+// nothing has to decode the main result again in JS.
+struct PreviewOptions {
+  int width = 0;                  // 0 = no preview
+  int quality = 70;
+};
+
+inline PreviewOptions ParsePreviewOptions(const Napi::Value& v) {
+  PreviewOptions p;
+  if (!v.IsObject() || v.IsBuffer()) return p;
+  Napi::Object opts = v.As<Napi::Object>();
+  if (!opts.Has("preview") || !opts.Get("preview").IsObject()) return p;
+  Napi::Object o = opts.Get("preview").As<Napi::Object>();
+  p.width = o.Has("width") && o.Get("width").IsNumber()
+            ? std::max(0, std::min(4096, o.Get("width").ToNumber().Int32Value())) : 200;
+  if (o.Has("quality") && o.Get("quality").IsNumber())
+    p.quality = std::max(1, std::min(100, o.Get("quality").ToNumber().Int32Value()));
+  return p;
+}
+
+// Worker thread: `width`-wide JPEG of `result` (aspect kept). A result that
+// only exists encoded (strip-streamed JPEG) is decoded DCT-reduced first.
+// Returns the elapsed time in ms.
+inline double EncodePreview(const cv::Mat& result, const std::string& colorSpace,
+                            const std::vector<uchar>& encoded, const PreviewOptions& p,
+                            std::vector<uchar>& out, cv::Size& size) {
+  const int64 t0 = cv::getTickCount();
+  cv::Mat src = result;
+  std::string order = colorSpace;
+  cv::Size full;
+  int components = 0;
+  if (src.empty() && ProbeJpegSize(encoded.data(), encoded.size(), full, components)) {
+    const cv::Size target(p.width, std::max(1, int(std::lround(double(full.height) * p.width / full.width))));
+    const int reduce = ChooseReducedScale(full, target);
+    const int flags = reduce == 8 ? cv::IMREAD_REDUCED_COLOR_8
+                    : reduce == 4 ? cv::IMREAD_REDUCED_COLOR_4
+                    : reduce == 2 ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_COLOR;
+    src = cv::imdecode(encoded, flags);
+    order = "BGR";
+  }
+  if (src.empty() || src.cols == 0) return 0.0;
+
+  const cv::Size target(p.width, std::max(1, int(std::lround(double(src.rows) * p.width / src.cols))));
+  cv::Mat thumb;
+  cv::resize(src, thumb, target, 0, 0, target.width < src.cols ? cv::INTER_AREA : cv::INTER_LINEAR);
+  if (thumb.depth() == CV_16U)       thumb.convertTo(thumb, CV_8U, 1.0 / 257.0);
+  else if (thumb.depth() != CV_8U)   thumb.convertTo(thumb, CV_8U, 255.0);
+
+  EncodeImage(thumb, order, out, "jpg", p.quality);
+  size = thumb.size();
+  return (cv::getTickCount() - t0) / cv::getTickFrequency() * 1e3;
+}
+
+// Caller-supplied destination Buffer (`out` in the options object). The
+// worker copies its result into it on the worker thread and OnOK returns a
+// view of that same Buffer, so a flow can hand the same memory back frame
+// after frame. A result that does not fit falls back to a fresh Buffer.
+class OutputTarget {
+public:
+  OutputTarget() = default;
+  explicit OutputTarget(const Napi::Value& v) {
+    if (!v.IsBuffer()) return;
+    Napi::Buffer<uint8_t> buf = v.As<Napi::Buffer<uint8_t>>();
+    data_ = buf.Data();
+    capacity_ = buf.Length();
+    ref_ = Napi::Persistent(buf);
+  }
+
+  // Worker thread: stores the encoded bytes, or the pixels for "raw".
+  // "native" ignores `out`; Mats over external memory are cloned here, off
+  // the JS thread, so the handle owns its pixels. Also makes the preview
+  // thumbnail when options.preview asked for one.
+  void Capture(const std::string& outputFormat, const cv::Mat& result,
+               const std::vector<uchar>& encoded, const std::string& colorSpace) {
+    Preview(result, colorSpace, encoded);
+    if (outputFormat == "native") {
+      CountOutput(result.total() * result.elemSize());
+      native_ = result.u != nullptr ? result : result.clone();
+      return;
+    }
+    CountOutput(outputFormat != "raw" ? encoded.size() : result.total() * result.elemSize());
+    if (!data_) return;
+    if (outputFormat != "raw") {
+      if (encoded.size() > capacity_) return;
+      std::memcpy(data_, encoded.data(), encoded.size());
+      written_ = encoded.size();
+    } else {
+      const size_t rowBytes = result.cols * result.elemSize();
+      if (result.empty() || rowBytes * result.rows > capacity_) return;
+      if (result.isContinuous()) {
+        std::memcpy(data_, result.data, rowBytes * result.rows);
+      } else {
+        for (int y = 0; y < result.rows; ++y)
+          std::memcpy(data_ + y * rowBytes, result.ptr(y), rowBytes);
+      }
+      written_ = rowBytes * result.rows;
+    }
+    stored_ = true;
+  }
+
+  // JS thread: same shape VectorToBuffer / MatToRawJS would have returned
+  Napi::Value ToJS(Napi::Env env, const std::string& outputFormat,
+                   const cv::Mat& result, const std::string& colorSpace,
+                   std::vector<uchar>& encoded) {
+    if (outputFormat == "native") {
+      return NativeImage::New(env, native_.empty() ? result : native_, colorSpace);
+    }
+    if (outputFormat == "tensor") {
+      Napi::Value data = stored_ ? View(env) : VectorToBuffer(env, std::move(encoded));
+      return TensorJS(env, data, 1, result.size(), tensor_);
+    }
+    if (!stored_) {
+      return (outputFormat != "raw") ? VectorToBuffer(env, std::move(encoded))
+                                     : MatToRawJS(env, result, colorSpace);
+    }
+    Napi::Value view = View(env);
+    if (outputFormat != "raw") return view;
+
+    Napi::Object o = RawHeaderJS(env, result, colorSpace);
+    o.Set("data", view);
+    return o;
+  }
+
+  // Layout of "tensor" results (same options.tensor the encoder got)
+  void SetTensor(const TensorOptions& t) { tensor_ = t; }
+  void SetPreview(const PreviewOptions& p) { preview_ = p; }
+
+  // Worker thread: the preview alone (results that skip Capture)
+  void Preview(const cv::Mat& result, const std::string& colorSpace,
+               const std::vector<uchar>& encoded = {}) {
+    if (preview_.width <= 0) return;
+    previewMs_ = EncodePreview(result, colorSpace, encoded, preview_, previewBuf_, previewSize_);
+  }
+
+  // JS thread: result.preview = { data, width, height, ms } (JPEG)
+  void AttachPreview(Napi::Object result) {
+    if (previewBuf_.empty()) return;
+    Napi::Env env = result.Env();
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("data",   VectorToBuffer(env, std::move(previewBuf_)));
+    o.Set("width",  Napi::Number::New(env, previewSize_.width));
+    o.Set("height", Napi::Number::New(env, previewSize_.height));
+    o.Set("ms",     Napi::Number::New(env, previewMs_));
+    result.Set("preview", o);
+  }
+
+private:
+  // out.subarray(0, written)
+  Napi::Value View(Napi::Env env) {
+    Napi::Buffer<uint8_t> buf = ref_.Value();
+    return buf.Get("subarray").As<Napi::Function>().Call(
+        buf, { Napi::Number::New(env, 0),
+               Napi::Number::New(env, static_cast<double>(written_)) });
+  }
+
+  Napi::Reference<Napi::Buffer<uint8_t>> ref_;   // keeps the Buffer alive
+  uint8_t* data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t written_ = 0;
+  bool stored_ = false;
+  TensorOptions tensor_;
+  cv::Mat native_;
+  PreviewOptions preview_;
+  std::vector<uchar> previewBuf_;
+  cv::Size previewSize_;
+  double previewMs_ = 0.0;
+};
+
+// `out` of an options object: a Buffer (single-image bindings)
+inline OutputTarget ParseOutputTarget(const Napi::Value& opts) {
+  if (!opts.IsObject() || opts.IsBuffer()) return OutputTarget();
+  Napi::Object o = opts.As<Napi::Object>();
+  OutputTarget target = o.Has("out") ? OutputTarget(o.Get("out")) : OutputTarget();
+  target.SetTensor(ParseTensorOptions(opts));
+  target.SetPreview(ParsePreviewOptions(opts));
+  return target;
+}
+
+// `out` as an array of Buffers, one per result (batch bindings); missing or
+// non-Buffer entries simply get a fresh Buffer. options.preview only
+// applies to the first result (batches return one `preview`).
+inline std::vector<OutputTarget> ParseOutputTargets(const Napi::Value& opts, size_t n) {
+  std::vector<OutputTarget> targets(n);
+  if (!opts.IsObject() || opts.IsBuffer()) return targets;
+  const TensorOptions tensor = ParseTensorOptions(opts);
+  const PreviewOptions preview = ParsePreviewOptions(opts);
+  for (auto& t : targets) t.SetTensor(tensor);
+  if (n) targets[0].SetPreview(preview);
+  Napi::Object o = opts.As<Napi::Object>();
+  if (!o.Has("out") || !o.Get("out").IsArray()) return targets;
+  Napi::Array arr = o.Get("out").As<Napi::Array>();
+  for (uint32_t i = 0; i < arr.Length() && i < n; ++i) {
+    targets[i] = OutputTarget(arr.Get(i));
+    targets[i].SetTensor(tensor);
+    if (i == 0) targets[0].SetPreview(preview);
+  }
+  return targets;
+}
+
 // Crea el objeto { convertMs, taskMs, encodeMs } para devolver a JS.
 inline Napi::Object MakeTimingJS(Napi::Env env,
   double convertMs,
@@ -293,7 +893,7 @@ return t;
 
 // Helper function to detect channel format for individual images (shared between blend and concat)
 inline std::string DetectChannelFormatShared(const Napi::Value& jsImg, const cv::Mat& mat) {
-  if (jsImg.IsObject() && !jsImg.IsBuffer()) {
+  if (jsImg.IsObject() && !IsBytes(jsImg)) {
     Napi::Object obj = jsImg.As<Napi::Object>();
     
     // Check for colorSpace field first
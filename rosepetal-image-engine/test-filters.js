@@ -0,0 +1,63 @@
+#!/usr/bin/env node
+
+/**
+ * Filter checks against plain JS references.
+ *
+ * Emboss: 3x3 correlation with the intensity-scaled relief kernel, the +128
+ * mid-gray applied inside the filter pass (negative responses land below
+ * 128 instead of being clipped to flat gray), BORDER_REFLECT_101 edges,
+ * saturated to 0..255.
+ */
+
+const { CppProcessor, makeImage, maxDiff, run } = require('./test-helpers');
+
+function embossReference(image, intensity) {
+    const { width, height, channels } = image;
+    const i = intensity;
+    const kernel = [[-2 * i, -i, 0], [-i, 1, i], [0, i, 2 * i]];
+    const reflect = (v, n) => (v < 0 ? -v : v >= n ? 2 * n - 2 - v : v);
+    const data = Buffer.alloc(image.data.length);
+    for (let y = 0; y < height; y++) {
+        for (let x = 0; x < width; x++) {
+            for (let c = 0; c < channels; c++) {
+                let sum = 128;
+                for (let ky = -1; ky <= 1; ky++) {
+                    for (let kx = -1; kx <= 1; kx++) {
+                        const sx = reflect(x + kx, width), sy = reflect(y + ky, height);
+                        sum += kernel[ky + 1][kx + 1] * image.data[(sy * width + sx) * channels + c];
+                    }
+                }
+                data[(y * width + x) * channels + c] = Math.max(0, Math.min(255, Math.round(sum)));
+            }
+        }
+    }
+    return { ...image, data };
+}
+
+async function checkEmboss(image, intensity) {
+    const result = await CppProcessor.filter(image, 'emboss', 3, intensity, 'raw', 90);
+    const d = maxDiff(result.image, embossReference(image, intensity));
+    if (d !== 0) throw new Error(`max difference ${d} from the reference`);
+}
+
+// A bright square on a dark field: the relief goes up on one side and down
+// on the other, so both sides of 128 must show up in the output
+async function checkEmbossBelowMidGray() {
+    const width = 16, height = 16;
+    const data = Buffer.alloc(width * height, 40);
+    for (let y = 5; y < 11; y++) data.fill(200, y * width + 5, y * width + 11);
+    const image = { data, width, height, channels: 1, colorSpace: 'GRAY', dtype: 'uint8' };
+
+    const result = await CppProcessor.filter(image, 'emboss', 3, 0.25, 'raw', 90);
+    const out = result.image.data;
+    const min = Math.min(...out), max = Math.max(...out);
+    if (!(min < 128 && max > 128)) throw new Error(`relief range ${min}..${max} does not straddle 128`);
+    const d = maxDiff(result.image, embossReference(image, 0.25));
+    if (d !== 0) throw new Error(`max difference ${d} from the reference`);
+}
+
+run('Testing filters...', [
+    ['emboss gray, intensity 1', () => checkEmboss(makeImage(37, 23, 1), 1)],
+    ['emboss BGR, intensity 2', () => checkEmboss(makeImage(37, 23, 3), 2)],
+    ['emboss relief below and above mid-gray', checkEmbossBelowMidGray]
+]);
@@ -0,0 +1,92 @@
+/**
+ * Shared helpers for the behaviour tests (test-*.js): deterministic test
+ * images, pixel comparisons and a minimal sequential runner that prints one
+ * line per check and exits non-zero when any of them fails.
+ */
+
+const CppProcessor = require('../node-red-contrib-rosepetal-image-tools/lib/cpp-bridge.js');
+
+// Gradient + hash noise (same pattern as bench/run.js): smooth enough to
+// compress like a photo, noisy enough that no op can shortcut it
+function makeImage(width, height, channels = 3, colorSpace = channels === 1 ? 'GRAY' : 'BGR') {
+    const data = Buffer.allocUnsafe(width * height * channels);
+    let i = 0;
+    for (let y = 0; y < height; y++) {
+        for (let x = 0; x < width; x++) {
+            const n = ((x * 73856093) ^ (y * 19349663)) & 31;
+            for (let c = 0; c < channels; c++) {
+                data[i++] = c === 3 ? 255 : ((((x * (c + 1) + y * (3 - c)) >> 3) + n) & 255);
+            }
+        }
+    }
+    return { data, width, height, channels, colorSpace, dtype: 'uint8' };
+}
+
+// Encoded copy of a raw image (resize by 1 is a plain re-encode)
+async function encode(image, format = 'jpg', quality = 90) {
+    const result = await CppProcessor.resize(image, 'multiply', 1, 'multiply', 1, format, quality,
+                                             { streaming: false });
+    return result.image;
+}
+
+// Full-frame decode of an encoded buffer, through the same path as the ops
+async function decode(buffer) {
+    const result = await CppProcessor.resize(buffer, 'multiply', 1, 'multiply', 1, 'raw', 90,
+                                             { streaming: false });
+    return result.image;
+}
+
+// Region [x, y, w, h] of a raw image, as a new raw image
+function roi(image, x, y, w, h) {
+    const cn = image.channels;
+    const data = Buffer.allocUnsafe(w * h * cn);
+    for (let r = 0; r < h; r++) {
+        const start = ((y + r) * image.width + x) * cn;
+        image.data.copy(data, r * w * cn, start, start + w * cn);
+    }
+    return { ...image, data, width: w, height: h };
+}
+
+// Largest per-byte difference of two raw images; throws on a shape mismatch
+function maxDiff(a, b) {
+    if (a.width !== b.width || a.height !== b.height || a.channels !== b.channels) {
+        throw new Error(`shape ${a.width}x${a.height}x${a.channels} != ${b.width}x${b.height}x${b.channels}`);
+    }
+    const da = a.data, db = b.data;
+    let max = 0;
+    for (let i = 0; i < da.length; i++) {
+        const d = Math.abs(da[i] - db[i]);
+        if (d > max) max = d;
+    }
+    return max;
+}
+
+function expectClose(a, b, tolerance, what) {
+    const d = maxDiff(a, b);
+    if (d > tolerance) throw new Error(`${what}: max difference ${d} > ${tolerance}`);
+}
+
+function expectCode(promise, code) {
+    return promise.then(
+        () => { throw new Error(`resolved, expected ${code}`); },
+        (error) => { if (error.code !== code) throw new Error(`got ${error.code || error.message}, expected ${code}`); });
+}
+
+// Runs the checks one after the other and exits with their verdict
+async function run(title, checks) {
+    console.log(`🔧 ${title}\n`);
+    let failed = 0;
+    for (const [name, check] of checks) {
+        try {
+            await check();
+            console.log(`✅ ${name}`);
+        } catch (error) {
+            failed++;
+            console.log(`❌ ${name}: ${error.message}`);
+        }
+    }
+    console.log(`\n${checks.length - failed}/${checks.length} passed`);
+    process.exit(failed ? 1 : 0);
+}
+
+module.exports = { CppProcessor, makeImage, encode, decode, roi, maxDiff, expectClose, expectCode, run };
@@ -0,0 +1,259 @@
+#!/usr/bin/env node
+
+/**
+ * Behaviour checks of the op bindings and of job control:
+ * - cropMany: each ROI equals the same region of the input, single frame
+ *   and batched (rects[][] → images[][]), also with the per-ROI resize;
+ *   rects with missing or non-finite fields are rejected
+ * - letterbox: the image area is a plain resize of the input, the border is
+ *   the pad colour in the image's channel order, the info maps it back
+ * - tensor output: NCHW float32 equal to (pixel / 255 - mean) / std
+ * - native output: a NativeImage handle with the pixels of a raw result;
+ *   `data` is a copy and handles feed other ops like raw images
+ * - frame pool: configure({ framePoolMB }) frees idle frames when lowered
+ * - malformed pipeline ops and inputs come back through the callback
+ * - err.code ERR_DEADLINE, ERR_CANCELLED (CancelToken and AbortSignal) and
+ *   ERR_SUPERSEDED (latestKey)
+ */
+
+const { CppProcessor, makeImage, roi, maxDiff, expectClose, expectCode, run } = require('./test-helpers');
+
+function expect(condition, message) {
+    if (!condition) throw new Error(message);
+}
+
+/*──────── cropMany ────────*/
+const RECTS = [[0, 0, 40, 30], [17, 9, 101, 77], [250, 150, 50, 50], [3, 140, 297, 1]];
+const asRect = ([x, y, width, height]) => ({ x, y, width, height });
+
+async function checkCropMany() {
+    const img = makeImage(300, 200, 3);
+    const { images } = await CppProcessor.cropMany(img, RECTS.map(asRect), { outputFormat: 'raw' });
+    expect(images.length === RECTS.length, `${images.length} crops for ${RECTS.length} rects`);
+    RECTS.forEach(([x, y, w, h], i) => expectClose(images[i], roi(img, x, y, w, h), 0, `rect ${RECTS[i]}`));
+}
+
+async function checkCropManyBatched() {
+    const frames = [makeImage(300, 200, 3), makeImage(120, 90, 1)];
+    const rects = [RECTS.slice(0, 2).map(asRect), []];
+    const { images } = await CppProcessor.cropMany(frames, rects, { outputFormat: 'raw' });
+    expect(images.length === 2 && images[1].length === 0, 'one list per frame');
+    images[0].forEach((crop, i) => expectClose(crop, roi(frames[0], ...RECTS[i]), 0, `frame 0 rect ${i}`));
+}
+
+async function checkCropManyResize() {
+    const img = makeImage(300, 200, 3);
+    const [x, y, w, h] = RECTS[1];
+    const { images } = await CppProcessor.cropMany(img, [asRect(RECTS[1])],
+        { outputFormat: 'raw', resize: { width: 64, height: 48 } });
+    const expected = await CppProcessor.resize(roi(img, x, y, w, h), 'set', 64, 'set', 48, 'raw', 90);
+    expectClose(images[0], expected.image, 0, 'resized crop');
+}
+
+// A rect with a missing, non-numeric or non-finite field is a TypeError,
+// never a crop of whatever NaN turns into
+async function checkCropManyBadRects() {
+    const img = makeImage(300, 200, 3);
+    const bad = [
+        { x: 0, y: 0, w: 10, height: 10 },
+        { x: '5', y: 0, width: 10, height: 10 },
+        { x: 0, y: NaN, width: 10, height: 10 },
+        { x: 0, y: 0, width: Infinity, height: 10 },
+        { x: 0, y: 0, width: 10, height: null }
+    ];
+    for (const rect of bad) {
+        await CppProcessor.cropMany(img, [asRect(RECTS[0]), rect], { outputFormat: 'raw' }).then(
+            () => { throw new Error(`accepted ${JSON.stringify(rect)}`); },
+            (error) => expect(/rect 1 must be \{x,y,width,height\}/.test(error.message),
+                              `${JSON.stringify(rect)}: ${error.message}`));
+    }
+}
+
+/*──────── letterbox ────────*/
+function expectPad(image, rect, color, what) {
+    const { width, channels, data } = image;
+    for (let y = rect[1]; y < rect[1] + rect[3]; y++) {
+        for (let x = rect[0]; x < rect[0] + rect[2]; x++) {
+            for (let c = 0; c < 3; c++) {
+                const v = data[(y * width + x) * channels + c];
+                if (v !== color[c]) throw new Error(`${what}: pixel ${x},${y} = ${v}, pad ${color[c]}`);
+            }
+        }
+    }
+}
+
+async function checkLetterbox(img, align, info, imageRect, padRects, padBytes) {
+    const result = await CppProcessor.letterbox(img, 640, 640, '#102030', align, 'raw', 90);
+    const out = result.image;
+    expect(out.width === 640 && out.height === 640, `output ${out.width}x${out.height}`);
+    for (const key of Object.keys(info)) {
+        expect(result.letterbox[key] === info[key], `letterbox.${key} = ${result.letterbox[key]}, expected ${info[key]}`);
+    }
+    const [x, y, w, h] = imageRect;
+    const expected = await CppProcessor.resize(img, 'set', w, 'set', h, 'raw', 90);
+    expectClose(roi(out, x, y, w, h), expected.image, 0, 'image area');
+    padRects.forEach(r => expectPad(out, r, padBytes, 'border'));
+}
+
+/*──────── tensor ────────*/
+async function checkTensor() {
+    const img = makeImage(61, 37, 3, 'BGR');
+    const mean = [0.485, 0.456, 0.406], std = [0.229, 0.224, 0.225];
+    const result = await CppProcessor.resize(img, 'multiply', 1, 'multiply', 1, 'tensor', 90,
+                                             { tensor: { channelOrder: 'RGB', mean, std } });
+    const t = result.image;
+    expect(t.layout === 'NCHW' && t.dtype === 'float32', `layout ${t.layout} / ${t.dtype}`);
+    expect(t.shape.join() === [1, 3, 37, 61].join(), `shape ${t.shape}`);
+    const values = new Float32Array(t.data.buffer.slice(t.data.byteOffset, t.data.byteOffset + t.data.length));
+    const plane = 61 * 37;
+    let worst = 0;
+    for (let i = 0; i < plane; i++) {
+        for (let c = 0; c < 3; c++) {
+            const px = img.data[i * 3 + (2 - c)];             // BGR input → RGB planes
+            worst = Math.max(worst, Math.abs(values[c * plane + i] - (px / 255 - mean[c]) / std[c]));
+        }
+    }
+    expect(worst < 1e-5, `max difference ${worst}`);
+}
+
+/*──────── native ────────*/
+async function checkNative() {
+    const img = makeImage(97, 53, 3);
+    const [native, raw] = await Promise.all([
+        CppProcessor.filter(img, 'blur', 5, 1.0, 'native', 90),
+        CppProcessor.filter(img, 'blur', 5, 1.0, 'raw', 90)
+    ]);
+    const handle = native.image;
+    expect(handle instanceof CppProcessor.NativeImage, 'not a NativeImage');
+    expect(handle.width === 97 && handle.height === 53 && handle.channels === 3 &&
+           handle.colorSpace === raw.image.colorSpace && handle.dtype === 'uint8', 'handle header');
+    expectClose(handle.toObject(), raw.image, 0, 'handle pixels');
+
+    // Writes into `data` never reach the handle
+    const copy = handle.data;
+    copy.fill(0);
+    expect(maxDiff(handle.toObject(), raw.image) === 0, 'writing data changed the handle');
+
+    // A handle goes back into any op as input
+    const [fromHandle, fromRaw] = await Promise.all([
+        CppProcessor.rotate(handle, 90, '#000000', 'raw', 90),
+        CppProcessor.rotate(raw.image, 90, '#000000', 'raw', 90)
+    ]);
+    expectClose(fromHandle.image, fromRaw.image, 0, 'op on handle vs raw');
+}
+
+/*──────── frame pool ────────*/
+// Lowering the idle limit frees the cached frames at once; with 0 nothing
+// is kept after a job
+async function checkFramePoolLimit() {
+    const { framePoolMB } = CppProcessor.configure();
+    try {
+        await CppProcessor.filter(makeImage(1000, 800, 3), 'blur', 5, 1.0, 'raw', 90);
+        expect(CppProcessor.configure({ framePoolMB: 0 }).framePoolMB === 0, 'limit not applied');
+        const after = CppProcessor.poolStats();
+        expect(after.idleLimit === 0 && after.idleBytes === 0, `${after.idleBytes} idle bytes kept`);
+        await CppProcessor.filter(makeImage(1000, 800, 3), 'blur', 5, 1.0, 'raw', 90);
+        expect(CppProcessor.poolStats().idleBytes === 0, 'frames kept with the pool disabled');
+    } finally {
+        CppProcessor.configure({ framePoolMB });
+    }
+    expect(CppProcessor.poolStats().idleLimit === framePoolMB * 2 ** 20, 'limit not restored');
+}
+
+/*──────── argument errors ────────*/
+// Bad inputs and ops reach the callback like any job error instead of
+// throwing from the binding (so a flow sees the same failure either way)
+const addon = require('./build/Release/addon.node');
+
+function expectCallbackError(name, args, pattern) {
+    return new Promise((resolve, reject) => {
+        try {
+            addon[name](...args, (error) => {
+                if (!error) reject(new Error(`${name}: no error`));
+                else if (!pattern.test(error.message)) reject(new Error(`${name}: ${error.message}`));
+                else resolve();
+            });
+        } catch (error) {
+            reject(new Error(`${name} threw: ${error.message}`));
+        }
+    });
+}
+
+const checkPipelineBadOp = () => expectCallbackError('pipeline',
+    [makeImage(64, 64, 3), [{ type: 'resize', width: 32, height: 32 }, { type: 'sepia' }], 'raw', 90],
+    /unknown op type 'sepia' at index 1/);
+
+const checkPipelineNonObjectOp = () => expectCallbackError('pipeline',
+    [makeImage(64, 64, 3), ['resize'], 'raw', 90], /op 0 must be an object/);
+
+const checkFilterBadInput = () => expectCallbackError('filter',
+    [{ data: Buffer.alloc(64 * 64 * 2), width: 64, height: 64, channels: 2 }, 'blur', 3, 1.0, 'raw', 90],
+    /Unsupported channel count: 2/);
+
+/*──────── job control ────────*/
+const slow = () => CppProcessor.filter(makeImage(3000, 2000, 3), 'gaussian', 31, 1.0, 'raw', 90);
+
+async function checkDeadline() {
+    await expectCode(CppProcessor.resize(makeImage(64, 64, 3), 'multiply', 0.5, 'multiply', 0.5, 'raw', 90,
+                                         { deadlineMs: 0 }), 'ERR_DEADLINE');
+}
+
+async function checkCancelToken() {
+    const token = new CppProcessor.CancelToken();
+    token.cancel();
+    await expectCode(CppProcessor.resize(makeImage(64, 64, 3), 'multiply', 0.5, 'multiply', 0.5, 'raw', 90,
+                                         { cancel: token }), 'ERR_CANCELLED');
+}
+
+async function checkAbortSignal() {
+    const controller = new AbortController();
+    controller.abort();
+    await expectCode(CppProcessor.filter(makeImage(64, 64, 3), 'blur', 3, 1.0, 'raw', 90,
+                                         { signal: controller.signal }), 'ERR_CANCELLED');
+}
+
+// One engine thread kept busy, so both keyed jobs are still queued when
+// the second arrives: the first is dropped, the second runs
+async function checkSuperseded() {
+    const { threads } = CppProcessor.configure();
+    CppProcessor.configure({ threads: 1 });
+    try {
+        // Surplus threads leave once they wake up idle
+        for (let i = 0; i < 100 && CppProcessor.stats().queue.threads > 1; i++) {
+            await new Promise(resolve => setTimeout(resolve, 10));
+        }
+        const busy = slow();
+        const img = makeImage(64, 64, 3);
+        const first = CppProcessor.resize(img, 'multiply', 0.5, 'multiply', 0.5, 'raw', 90, { latestKey: 'camera-1' });
+        const second = CppProcessor.resize(img, 'multiply', 0.5, 'multiply', 0.5, 'raw', 90, { latestKey: 'camera-1' });
+        await expectCode(first, 'ERR_SUPERSEDED');
+        const kept = await second;
+        expect(kept.image.width === 32, 'newest job did not run');
+        await busy;
+    } finally {
+        CppProcessor.configure({ threads });
+    }
+}
+
+run('Testing ops and job control...', [
+    ['cropMany single frame', checkCropMany],
+    ['cropMany batched', checkCropManyBatched],
+    ['cropMany with resize', checkCropManyResize],
+    ['cropMany rejects malformed rects', checkCropManyBadRects],
+    ['letterbox wide BGR, centred', () => checkLetterbox(makeImage(1000, 500, 3, 'BGR'), 'center',
+        { scale: 0.64, offsetX: 0, offsetY: 160, width: 640, height: 320 },
+        [0, 160, 640, 320], [[0, 0, 640, 160], [0, 480, 640, 160]], [0x30, 0x20, 0x10])],
+    ['letterbox tall RGB, top-left', () => checkLetterbox(makeImage(300, 600, 3, 'RGB'), 'top-left',
+        { scale: 640 / 600, offsetX: 0, offsetY: 0, width: 320, height: 640 },
+        [0, 0, 320, 640], [[320, 0, 320, 640]], [0x10, 0x20, 0x30])],
+    ['tensor output', checkTensor],
+    ['native output', checkNative],
+    ['frame pool idle limit', checkFramePoolLimit],
+    ['pipeline: unknown op reported through the callback', checkPipelineBadOp],
+    ['pipeline: non-object op reported through the callback', checkPipelineNonObjectOp],
+    ['filter: bad input reported through the callback', checkFilterBadInput],
+    ['ERR_DEADLINE', checkDeadline],
+    ['ERR_CANCELLED (CancelToken)', checkCancelToken],
+    ['ERR_CANCELLED (AbortSignal)', checkAbortSignal],
+    ['ERR_SUPERSEDED', checkSuperseded]
+]);
@@ -0,0 +1,97 @@
+#!/usr/bin/env node
+
+/**
+ * The pipeline Node-RED node (nodes/transform/pipeline.js) driven through a
+ * minimal RED stub, so ops go through the node's own op resolution before
+ * they reach the addon:
+ * - letterbox op: same pixels as CppProcessor.letterbox, geometry in
+ *   msg.letterbox (one entry per image for arrays)
+ * - unknown op type: the message fails with "Unsupported op"
+ */
+
+const { EventEmitter } = require('events');
+const { CppProcessor, makeImage, expectClose, run } = require('./test-helpers');
+
+const path = (obj, p) => p.split('.').reduce((o, k) => (o == null ? undefined : o[k]), obj);
+
+// Just enough of the runtime for one node: property access, node events,
+// status / warn / error recorded on the node
+function stubRED() {
+    const RED = {
+        types: {},
+        nodes: {
+            createNode(node, config) {
+                Object.setPrototypeOf(node, EventEmitter.prototype);
+                EventEmitter.call(node);
+                Object.assign(node, { id: config.id, warnings: [], errors: [] });
+                node.status = () => {};
+                node.warn = (m) => node.warnings.push(m);
+                node.error = (m) => node.errors.push(m);
+            },
+            registerType(name, ctor) { RED.types[name] = ctor; }
+        },
+        util: {
+            getMessageProperty: path,
+            setMessageProperty(msg, p, value) {
+                const keys = p.split('.');
+                const last = keys.pop();
+                keys.reduce((o, k) => (o[k] = o[k] || {}), msg)[last] = value;
+            },
+            evaluateNodeProperty: (value, type, node, msg) => (type === 'msg' ? path(msg, value) : value)
+        },
+        comms: { publish() {} }
+    };
+    require('../node-red-contrib-rosepetal-image-tools/nodes/transform/pipeline.js')(RED);
+    return RED;
+}
+
+// Sends one message through a fresh node; resolves with the sent message,
+// rejects with the error passed to done()
+function sendThrough(ops, payload) {
+    const RED = stubRED();
+    const node = new RED.types.pipeline({ id: 'pipeline-test', ops: JSON.stringify(ops), outputFormat: 'raw' });
+    return new Promise((resolve, reject) => {
+        let sent = null;
+        node.emit('input', { payload }, (msg) => { sent = msg; },
+            (error) => (error ? reject(error) : sent ? resolve(sent) : reject(new Error(node.warnings.join('; ') || 'nothing sent'))));
+    });
+}
+
+const LETTERBOX = { type: 'letterbox', width: 640, height: 640, padColor: '#102030', align: 'center' };
+
+async function checkLetterbox() {
+    const img = makeImage(1000, 500, 3, 'BGR');
+    const msg = await sendThrough([LETTERBOX], img);
+    const direct = await CppProcessor.letterbox(img, 640, 640, '#102030', 'center', 'raw', 90);
+    expectClose(msg.payload, direct.image, 0, 'node vs letterbox');
+    for (const key of ['scale', 'offsetX', 'offsetY', 'width', 'height']) {
+        if (msg.letterbox[key] !== direct.letterbox[key]) {
+            throw new Error(`msg.letterbox.${key} = ${msg.letterbox[key]}, expected ${direct.letterbox[key]}`);
+        }
+    }
+}
+
+async function checkLetterboxArray() {
+    const msg = await sendThrough([{ type: 'crop', x: 0, y: 0, width: 300, height: 100 }, LETTERBOX],
+                                  [makeImage(400, 400, 3), makeImage(300, 200, 1)]);
+    if (!Array.isArray(msg.letterbox) || msg.letterbox.length !== 2) throw new Error('one letterbox entry per image');
+    if (msg.letterbox.some(l => l.offsetY !== 213 || l.height !== 213)) {
+        throw new Error(`letterbox ${JSON.stringify(msg.letterbox)}`);
+    }
+}
+
+async function checkUnsupported() {
+    try {
+        await sendThrough([{ type: 'sepia' }], makeImage(64, 64, 3));
+    } catch (error) {
+        if (/Unsupported op at index 0/.test(error.message)) return;
+        throw error;
+    }
+    throw new Error('unknown op accepted');
+}
+
+run('Testing the pipeline node...', [
+    ['letterbox op through the node', checkLetterbox],
+    ['letterbox after crop, image array', checkLetterboxArray],
+    ['unknown op rejected', checkUnsupported]
+]);
@@ -0,0 +1,67 @@
+#!/usr/bin/env node
+
+/**
+ * Region decode of crop / cropMany (DecodeCropRegions in src/crop.cpp)
+ * against a full cv::imdecode plus the same ROI, for rectangles on and off
+ * the 16-px iMCU grid (4:2:0 colour, so fancy chroma upsampling meets the
+ * rectangle edges) and for a grayscale JPEG.
+ * Each frame is cropped before anything decodes it in full, so the region
+ * path runs (no decode-cache miss is counted); the same crops are then
+ * repeated once the full decode is cached and must come from that entry.
+ */
+
+const { CppProcessor, makeImage, encode, decode, roi, expectClose, run } = require('./test-helpers');
+
+const RECTS = [
+    [0, 0, 64, 64],          // aligned, at the origin
+    [32, 48, 320, 256],      // aligned
+    [13, 7, 101, 77],        // misaligned on every edge
+    [301, 203, 55, 333],
+    [15, 17, 17, 15],        // inside two iMCUs, tiny
+    [1159, 869, 40, 30],     // bottom-right corner
+    [512, 0, 688, 900]       // aligned left edge, full height
+];
+// cropMany shares bands between nearby rects; with the full-height one as
+// well the bands would cost more than a full decode
+const MANY = RECTS.slice(0, -1);
+
+const cacheStats = () => CppProcessor.stats().decodeCache;
+
+async function cropAll(jpeg) {
+    const single = [];
+    for (const [x, y, w, h] of RECTS) {
+        single.push((await CppProcessor.crop(jpeg, x, y, w, h, false, 'raw', 90)).image);
+    }
+    const rects = MANY.map(([x, y, width, height]) => ({ x, y, width, height }));
+    const many = (await CppProcessor.cropMany(jpeg, rects, { outputFormat: 'raw' })).images;
+    return { single, many };
+}
+
+function compareAll({ single, many }, full, what) {
+    RECTS.forEach(([x, y, w, h], i) => {
+        expectClose(single[i], roi(full, x, y, w, h), 0, `${what} crop ${RECTS[i]}`);
+    });
+    MANY.forEach(([x, y, w, h], i) => {
+        expectClose(many[i], roi(full, x, y, w, h), 0, `${what} cropMany ${MANY[i]}`);
+    });
+}
+
+async function check(channels) {
+    const jpeg = await encode(makeImage(1200, 900, channels), 'jpg', 90);
+
+    const before = cacheStats();
+    const regions = await cropAll(jpeg);
+    if (cacheStats().misses !== before.misses) throw new Error('crops decoded the full frame');
+
+    const full = await decode(jpeg);
+    compareAll(regions, full, 'region');
+
+    const hits = cacheStats().hits;
+    compareAll(await cropAll(jpeg), full, 'cached');
+    if (cacheStats().hits <= hits) throw new Error('cached frame not used');
+}
+
+run('Testing region decode against the full frame...', [
+    ['BGR 4:2:0 JPEG', () => check(3)],
+    ['grayscale JPEG', () => check(1)]
+]);
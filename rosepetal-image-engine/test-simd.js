@@ -0,0 +1,154 @@
+#!/usr/bin/env node
+
+/**
+ * Runtime-dispatched SIMD kernels (src/runtime/cpu-dispatch.h) against the
+ * baseline ones: the same cases run in two child processes, one capped with
+ * ROSEPETAL_SIMD=baseline and one at the host's own level, and their
+ * outputs are compared.
+ * - alpha blending (blend placement on BGR / RGBA / GRAY bases, rotated
+ *   advanced-mosaic tiles): identical
+ * - tensor rows (BGR / RGBA / GRAY inputs, RGB and GRAY tensors): within
+ *   1e-5 (FMA contraction differs between the variants)
+ * Both runs are also checked against plain JS references, so a formula
+ * shared by every variant cannot pass unnoticed:
+ * - place blend on BGR / RGBA: weight round(alpha · opacity), colour
+ *   round((s·w + d·(255 − w)) / 255) in the base's channel order: identical
+ * - tensor BGR → RGB, RGBA → BGR, GRAY → RGB: (pixel / 255 − mean) / std
+ *   per plane, within 1e-5 (float32 rounding of values up to ~2.7)
+ * Widths are odd so every kernel also runs its scalar tail.
+ */
+
+const { fork } = require('child_process');
+const { CppProcessor, makeImage } = require('./test-helpers');
+
+// Overlay with an alpha ramp, so every blend weight 0..255 shows up
+function overlay(width, height) {
+    const img = makeImage(width, height, 4, 'RGBA');
+    for (let i = 0; i < width * height; i++) img.data[i * 4 + 3] = (i * 7) & 255;
+    return img;
+}
+
+const PLACE = { mode: 'place', x: 13, y: 7 };
+const OPACITY = 0.8;
+const NORM = { mean: [0.485, 0.456, 0.406], std: [0.229, 0.224, 0.225] };
+const inputs = () => ({
+    ov: overlay(333, 211),
+    bgr: makeImage(501, 301, 3, 'BGR'),
+    rgba: makeImage(501, 301, 4, 'RGBA'),
+    gray: makeImage(501, 301, 1, 'GRAY')
+});
+
+async function cases() {
+    const { ov, bgr, rgba, gray } = inputs();
+    const blend = (base) => CppProcessor.blend(ov, base, OPACITY, 'raw', 90, PLACE).then(r => r.image.data);
+    const tensor = (img, t) => CppProcessor.resize(img, 'multiply', 1, 'multiply', 1, 'tensor', 90, { tensor: t })
+        .then(({ image: { data } }) => new Float32Array(data.buffer.slice(data.byteOffset, data.byteOffset + data.length)));
+    const mosaic = (img, rotation, width) => CppProcessor.advancedMosaic(
+        [img], 800, 700, '#203040',
+        [{ arrayIndex: 0, x: 21, y: 9, rotation, width, height: null, zIndex: 0 }],
+        false, 'raw', 90).then(r => r.image.data);
+
+    return {
+        simd: CppProcessor.stats().cpu.simd,
+        'blend on BGR': await blend(bgr),
+        'blend on RGBA': await blend(rgba),
+        'blend on GRAY': await blend(gray),
+        'mosaic tile rotated 33° (cached tables)': await mosaic(bgr, 33, null),
+        'mosaic tile rotated -17°, resized': await mosaic(bgr, -17, 377),
+        'tensor BGR → RGB': await tensor(bgr, NORM),
+        'tensor RGBA → BGR': await tensor(rgba, { ...NORM, channelOrder: 'BGR' }),
+        'tensor GRAY → RGB': await tensor(gray, NORM),
+        'tensor BGR → GRAY': await tensor(bgr, { channelOrder: 'GRAY', mean: 0.5, std: 0.5 })
+    };
+}
+
+/*──────── JS references ────────*/
+// RGBA overlay over a BGR / RGBA base at PLACE, as blend placement does it
+function blendReference(ov, base) {
+    const out = Buffer.from(base.data);
+    const order = base.channels === 4 ? [0, 1, 2] : [2, 1, 0];      // base channel ← overlay RGBA
+    for (let y = 0; y < ov.height; y++) {
+        for (let x = 0; x < ov.width; x++) {
+            const s = (y * ov.width + x) * 4;
+            const d = ((y + PLACE.y) * base.width + x + PLACE.x) * base.channels;
+            const w = Math.round(ov.data[s + 3] * OPACITY), iw = 255 - w;
+            for (let c = 0; c < 3; c++) out[d + c] = Math.round((ov.data[s + order[c]] * w + out[d + c] * iw) / 255);
+            if (base.channels === 4) out[d + 3] = w + Math.round(out[d + 3] * iw / 255);
+        }
+    }
+    return out;
+}
+
+// NCHW planes of (pixel / 255 - mean) / std; `map` = source channel per plane
+function tensorReference(img, map, { mean, std }) {
+    const plane = img.width * img.height;
+    const out = new Float32Array(plane * map.length);
+    map.forEach((src, c) => {
+        for (let i = 0; i < plane; i++) out[c * plane + i] = (img.data[i * img.channels + src] / 255 - mean[c]) / std[c];
+    });
+    return out;
+}
+
+function references() {
+    const { ov, bgr, rgba, gray } = inputs();
+    return {
+        'blend on BGR': { ref: blendReference(ov, bgr), tolerance: 0 },
+        'blend on RGBA': { ref: blendReference(ov, rgba), tolerance: 0 },
+        'tensor BGR → RGB': { ref: tensorReference(bgr, [2, 1, 0], NORM), tolerance: 1e-5 },
+        'tensor RGBA → BGR': { ref: tensorReference(rgba, [2, 1, 0], NORM), tolerance: 1e-5 },
+        'tensor GRAY → RGB': { ref: tensorReference(gray, [0, 0, 0], NORM), tolerance: 1e-5 }
+    };
+}
+
+function runChild(env) {
+    return new Promise((resolve, reject) => {
+        const child = fork(__filename, ['--child'], { env: { ...process.env, ...env }, serialization: 'advanced' });
+        let result = null;
+        child.on('message', m => { result = m; });
+        child.on('exit', code => (code === 0 && result ? resolve(result) : reject(new Error(`child exited with ${code}`))));
+    });
+}
+
+function maxAbsDiff(a, b) {
+    if (a.length !== b.length) return Infinity;
+    let max = 0;
+    for (let i = 0; i < a.length; i++) max = Math.max(max, Math.abs(a[i] - b[i]));
+    return max;
+}
+
+async function main() {
+    console.log('🔧 Testing SIMD kernels against the baseline...\n');
+    const [base, best] = await Promise.all([runChild({ ROSEPETAL_SIMD: 'baseline' }),
+                                            runChild({ ROSEPETAL_SIMD: '' })]);
+    console.log(`baseline: ${base.simd}, host: ${best.simd}${base.simd === best.simd ? ' (nothing to compare)' : ''}\n`);
+
+    let failed = 0, checks = 0;
+    const names = Object.keys(base).filter(k => k !== 'simd');
+    for (const name of names) {
+        const tolerance = name.startsWith('tensor') ? 1e-5 : 0;
+        const d = maxAbsDiff(base[name], best[name]);
+        checks++;
+        if (d > tolerance) failed++;
+        console.log(`${d > tolerance ? '❌' : '✅'} ${name}: max difference ${d}`);
+    }
+
+    console.log('\nAgainst the JS references:');
+    for (const [name, { ref, tolerance }] of Object.entries(references())) {
+        const d = Math.max(maxAbsDiff(base[name], ref), maxAbsDiff(best[name], ref));
+        checks++;
+        if (d > tolerance) failed++;
+        console.log(`${d > tolerance ? '❌' : '✅'} ${name}: max difference ${d} (tolerance ${tolerance})`);
+    }
+    console.log(`\n${checks - failed}/${checks} passed`);
+    process.exit(failed ? 1 : 0);
+}
+
+if (process.argv[2] === '--child') {
+    cases().then(out => process.send(out, () => process.exit(0)),
+                 error => { console.error(error); process.exit(1); });
+} else {
+    main().catch(error => {
+        console.error('💥 Test framework error:', error.message);
+        process.exit(1);
+    });
+}
@@ -0,0 +1,38 @@
+#!/usr/bin/env node
+
+/**
+ * Streaming mode (src/streaming.cpp) against the full-frame path: the same
+ * JPEG through options.streaming true and false (cv::imdecode + the regular
+ * op). Frames are 2800 px wide, so strips are 499 rows and the 1100-row
+ * frame is processed as three strips: the filter halos cross two band
+ * edges (rows 499 and 998).
+ * - filter: identical
+ * - crop (rectangle off the 8/16-px iMCU grid): identical
+ * - resize: within ±1 (separable bilinear vs cv::resize INTER_LINEAR)
+ */
+
+const { CppProcessor, makeImage, encode, expectClose, run } = require('./test-helpers');
+
+const STREAM = { streaming: true };
+const FULL = { streaming: false };
+
+async function compare(op, tolerance) {
+    const jpeg = await encode(makeImage(2800, 1100, 3), 'jpg', 90);
+    const [strips, full] = await Promise.all([op(jpeg, STREAM), op(jpeg, FULL)]);
+    expectClose(strips.image, full.image, tolerance, 'streamed vs full frame');
+}
+
+const filter = (type, k) => (img, o) => CppProcessor.filter(img, type, k, 1.0, 'raw', 90, o);
+
+run('Testing streaming against the full-frame path...', [
+    ['filter gaussian 7 across band edges', () => compare(filter('gaussian', 7), 0)],
+    ['filter sharpen 3 across band edges', () => compare(filter('sharpen', 3), 0)],
+    ['filter emboss across band edges', () => compare(filter('emboss', 3), 0)],
+    ['filter edge 5 across band edges', () => compare(filter('edge', 5), 0)],
+    ['crop off the iMCU grid (13, 7, 1001 x 997)',
+        () => compare((img, o) => CppProcessor.crop(img, 13, 7, 1001, 997, false, 'raw', 90, o), 0)],
+    ['crop tall band over both edges (1203, 490, 77 x 600)',
+        () => compare((img, o) => CppProcessor.crop(img, 1203, 490, 77, 600, false, 'raw', 90, o), 0)],
+    ['resize 0.6 x 0.6 within ±1',
+        () => compare((img, o) => CppProcessor.resize(img, 'multiply', 0.6, 'multiply', 0.6, 'raw', 90, o), 1)]
+]);